@@ -0,0 +1,123 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+// Decision quality against the number of search iterations for UctStatistic and RaveStatistic
+// as ego statistic in the crossing state. For each iteration budget a number of episodes is run
+// with hypotheses differing from the true agent policies, results are written as CSV to stdout:
+// statistic,iterations,episodes,goal_reached,collisions,mean_return,mean_steps,mean_search_time_ms
+
+#include "mcts/heuristics/random_heuristic.h"
+#include "mcts/statistics/uct_statistic.h"
+#include "mcts/statistics/rave_statistic.h"
+#include "mcts/hypothesis/hypothesis_statistic.h"
+#include "mcts/hypothesis/hypothesis_belief_tracker.h"
+#include "environments/crossing_state.h"
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace mcts;
+
+using Domain = int;
+
+struct EpisodeResult {
+  bool goal_reached;
+  bool collision;
+  double accum_return;
+  unsigned int num_steps;
+  double search_time;
+};
+
+template<class SE>
+EpisodeResult run_episode(const MctsParameters& mcts_params, const CrossingStateParameters<Domain>& params,
+                          const unsigned int& max_steps) {
+  HypothesisBeliefTracker belief_tracker(mcts_params);
+  auto state = std::make_shared<CrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), params,
+                make_hypothesis_set<Domain>({AgentPolicyCrossingState<Domain>({4,5}, params),
+                                             AgentPolicyCrossingState<Domain>({-2,3}, params),
+                                             AgentPolicyCrossingState<Domain>({5,6}, params)}));
+  belief_tracker.belief_update(*state, *state);
+  AgentPolicyCrossingState<Domain> true_agents_policy({5,5}, params);
+  Philox4x32 true_policy_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
+
+  EpisodeResult result{false, false, 0.0, 0, 0.0};
+  std::vector<Reward> rewards;
+  Cost cost;
+  double discount = 1.0;
+  while(!state->is_terminal() && result.num_steps < max_steps) {
+    auto jointaction = JointAction(state->get_num_agents());
+    Mcts<CrossingState<Domain>, SE, HypothesisStatistic, RandomHeuristic> mcts(mcts_params);
+    mcts.search(*state, belief_tracker);
+    result.search_time += mcts.searchTime();
+    jointaction[CrossingState<Domain>::ego_agent_idx] = mcts.returnBestAction();
+    for (auto agent_idx : state->get_other_agent_idx()) {
+      jointaction[agent_idx] = state->get_action_idx(agent_idx, true_agents_policy.act(state->get_agent_state(agent_idx),
+                                                                                     state->get_ego_state(), true_policy_random_generator));
+    }
+    auto next_state = state->execute(jointaction, rewards, cost);
+    belief_tracker.belief_update(*state, *next_state);
+    state = next_state;
+    result.accum_return += discount * rewards[CrossingState<Domain>::ego_agent_idx];
+    discount *= mcts_params.DISCOUNT_FACTOR;
+    result.num_steps += 1;
+  }
+  result.goal_reached = state->ego_goal_reached();
+  result.collision = state->ego_collided();
+  result.search_time /= std::max(result.num_steps, 1u);
+  return result;
+}
+
+template<class SE>
+void run_benchmark(const std::string& statistic_name, const MctsParameters& mcts_params,
+                   const CrossingStateParameters<Domain>& params, const std::vector<unsigned int>& iterations,
+                   const unsigned int& num_episodes, const unsigned int& max_steps) {
+  for (const auto& num_iterations : iterations) {
+    unsigned int goal_reached = 0, collisions = 0;
+    double sum_return = 0.0, sum_steps = 0.0, sum_search_time = 0.0;
+    for (unsigned int episode = 0; episode < num_episodes; ++episode) {
+      // Same seeds for every statistic and budget such that episodes are comparable
+      auto episode_mcts_params = mcts_params;
+      episode_mcts_params.MAX_NUMBER_OF_ITERATIONS = num_iterations;
+      episode_mcts_params.RANDOM_SEED = mcts_params.RANDOM_SEED + episode;
+      episode_mcts_params.hypothesis_belief_tracker.RANDOM_SEED_HYPOTHESIS_SAMPLING += episode;
+      auto episode_params = params;
+      episode_params.OTHER_AGENTS_POLICY_RANDOM_SEED += episode;
+
+      const auto result = run_episode<SE>(episode_mcts_params, episode_params, max_steps);
+      goal_reached += result.goal_reached;
+      collisions += result.collision;
+      sum_return += result.accum_return;
+      sum_steps += result.num_steps;
+      sum_search_time += result.search_time;
+    }
+    std::cout << statistic_name << "," << num_iterations << "," << num_episodes << ","
+              << goal_reached << "," << collisions << "," << sum_return / num_episodes << ","
+              << sum_steps / num_episodes << "," << sum_search_time / num_episodes << std::endl;
+  }
+}
+
+int main(int argc, char **argv) {
+  // usage: crossing_state_rave_benchmark [num_episodes] [max_steps]
+  const unsigned int num_episodes = argc > 1 ? std::atoi(argv[1]) : 10;
+  const unsigned int max_steps = argc > 2 ? std::atoi(argv[2]) : 40;
+  const std::vector<unsigned int> iterations{25, 50, 100, 200, 400};
+
+  auto params = default_crossing_state_parameters<Domain>();
+  auto mcts_params = mcts_default_parameters();
+  // Iterations are the only budget
+  mcts_params.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+  mcts_params.random_heuristic.MAX_SEARCH_TIME = std::numeric_limits<double>::max();
+
+  std::cout << "statistic,iterations,episodes,goal_reached,collisions,mean_return,mean_steps,mean_search_time_ms" << std::endl;
+  run_benchmark<UctStatistic>("uct", mcts_params, params, iterations, num_episodes, max_steps);
+
+  mcts_params.rave_statistic.BLEND_SCHEDULE = RaveStatistic::EQUIVALENCE;
+  run_benchmark<RaveStatistic>("rave_equivalence", mcts_params, params, iterations, num_episodes, max_steps);
+
+  mcts_params.rave_statistic.BLEND_SCHEDULE = RaveStatistic::MINIMUM_MSE;
+  run_benchmark<RaveStatistic>("rave_minimum_mse", mcts_params, params, iterations, num_episodes, max_steps);
+  return 0;
+}
@@ -0,0 +1,183 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+// Throughput and tree memory of Mcts against the size of the problem. Starting from a base configuration one
+// parameter is swept at a time for the synthetic state (agents, actions per agent, branching, terminal depth,
+// execute cost, rollout depth) and the crossing state (other agents, hypotheses, rollout depth). Each point
+// is the mean over a number of searches with a fixed iteration budget, results are written as CSV to stdout:
+// environment,parameter,value,agents,actions,hypotheses,rollout_depth,iterations,search_time_ms,iterations_per_second,nodes,tree_bytes,bytes_per_node
+
+#include "mcts/mcts.h"
+#include "mcts/heuristics/random_heuristic.h"
+#include "mcts/statistics/uct_statistic.h"
+#include "mcts/hypothesis/hypothesis_statistic.h"
+#include "mcts/hypothesis/hypothesis_belief_tracker.h"
+#include "environments/crossing_state.h"
+#include "environments/synthetic_state.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+
+using namespace mcts;
+
+namespace {
+
+struct ScalingPoint {
+  ScalingPoint() : num_agents(0), num_actions(0), num_hypothesis(0), rollout_depth(0), iterations(0),
+                   search_time_ms(0.0), nodes(0), tree_bytes(0) {}
+  unsigned int num_agents;
+  ActionIdx num_actions;
+  unsigned int num_hypothesis;
+  unsigned int rollout_depth;
+  double iterations;
+  double search_time_ms;
+  double nodes;
+  double tree_bytes;
+};
+
+void print_point(const std::string& environment, const std::string& parameter, const double& value,
+                 const ScalingPoint& point) {
+  std::cout << environment << "," << parameter << "," << value << "," << point.num_agents << ","
+            << point.num_actions << "," << point.num_hypothesis << "," << point.rollout_depth << ","
+            << point.iterations << "," << point.search_time_ms << ","
+            << point.iterations / std::max(point.search_time_ms, 1e-9) * 1000.0 << ","
+            << point.nodes << "," << point.tree_bytes << "," << point.tree_bytes / std::max(point.nodes, 1.0)
+            << std::endl;
+}
+
+// Runs the searches of one point, search(mcts) performs a single search
+template<class M, class Search>
+ScalingPoint measure(const MctsParameters& mcts_parameters, const unsigned int& num_searches, Search search) {
+  ScalingPoint point;
+  point.rollout_depth = mcts_parameters.random_heuristic.MAX_NUMBER_OF_ITERATIONS;
+  for (unsigned int search_idx = 0; search_idx < num_searches; ++search_idx) {
+    auto parameters = mcts_parameters;
+    parameters.RANDOM_SEED += search_idx;
+    M mcts(parameters);
+    const auto start = std::chrono::high_resolution_clock::now();
+    search(mcts);
+    const std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
+    point.iterations += mcts.numIterations();
+    point.search_time_ms += duration.count();
+    point.nodes += mcts.numNodes();
+    point.tree_bytes += mcts.treeStatistics().total_bytes();
+  }
+  point.iterations /= num_searches;
+  point.search_time_ms /= num_searches;
+  point.nodes /= num_searches;
+  point.tree_bytes /= num_searches;
+  return point;
+}
+
+ScalingPoint run_synthetic_state(const SyntheticStateParameters& parameters, const MctsParameters& mcts_parameters,
+                                 const unsigned int& num_searches) {
+  const SyntheticState state(parameters);
+  auto point = measure<Mcts<SyntheticState, UctStatistic, UctStatistic, RandomHeuristic>>(mcts_parameters, num_searches,
+                      [&](Mcts<SyntheticState, UctStatistic, UctStatistic, RandomHeuristic>& mcts) { mcts.search(state); });
+  point.num_agents = parameters.NUM_OTHER_AGENTS + 1;
+  point.num_actions = parameters.NUM_ACTIONS;
+  return point;
+}
+
+ScalingPoint run_crossing_state(const CrossingStateParameters<int>& parameters, const unsigned int& num_hypothesis,
+                                const MctsParameters& mcts_parameters, const unsigned int& num_searches) {
+  HypothesisSet<int> hypothesis_set;
+  for (unsigned int hid = 0; hid < num_hypothesis; ++hid) {
+    const int lower = static_cast<int>(hid % 6);
+    hypothesis_set.push_back(AgentPolicyCrossingState<int>({lower, lower + 2}, parameters));
+  }
+  HypothesisBeliefTracker belief_tracker(mcts_parameters);
+  CrossingState<int> state(belief_tracker.sample_current_hypothesis(), parameters,
+                           make_hypothesis_set<int>(hypothesis_set));
+  belief_tracker.belief_update(state, state);
+
+  typedef Mcts<CrossingState<int>, UctStatistic, HypothesisStatistic, RandomHeuristic> CrossingStateMcts;
+  auto point = measure<CrossingStateMcts>(mcts_parameters, num_searches,
+                      [&](CrossingStateMcts& mcts) { mcts.search(state, belief_tracker); });
+  point.num_agents = parameters.NUM_OTHER_AGENTS + 1;
+  point.num_actions = parameters.NUM_OTHER_ACTIONS;
+  point.num_hypothesis = num_hypothesis;
+  return point;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  // usage: scaling_study [num_iterations] [num_searches]
+  const unsigned int num_iterations = argc > 1 ? std::atoi(argv[1]) : 2000;
+  const unsigned int num_searches = argc > 2 ? std::atoi(argv[2]) : 5;
+
+  auto mcts_parameters = mcts_default_parameters();
+  // Iterations are the only budget
+  mcts_parameters.MAX_NUMBER_OF_ITERATIONS = num_iterations;
+  mcts_parameters.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+  mcts_parameters.random_heuristic.MAX_SEARCH_TIME = std::numeric_limits<double>::max();
+  mcts_parameters.random_heuristic.MAX_NUMBER_OF_ITERATIONS = 20;
+
+  std::cout << "environment,parameter,value,agents,actions,hypotheses,rollout_depth,iterations,search_time_ms,"
+               "iterations_per_second,nodes,tree_bytes,bytes_per_node" << std::endl;
+
+  const auto synthetic_base = default_synthetic_state_parameters();
+  for (unsigned int num_other_agents : {1, 2, 4, 8}) {
+    auto parameters = synthetic_base;
+    parameters.NUM_OTHER_AGENTS = num_other_agents;
+    print_point("synthetic", "other_agents", num_other_agents,
+                run_synthetic_state(parameters, mcts_parameters, num_searches));
+  }
+  for (ActionIdx num_actions : {2, 4, 8, 16, 32}) {
+    auto parameters = synthetic_base;
+    parameters.NUM_ACTIONS = num_actions;
+    print_point("synthetic", "actions", num_actions, run_synthetic_state(parameters, mcts_parameters, num_searches));
+  }
+  for (unsigned int branching : {1, 4, 16, 64, 256}) {
+    auto parameters = synthetic_base;
+    parameters.BRANCHING = branching;
+    print_point("synthetic", "branching", branching, run_synthetic_state(parameters, mcts_parameters, num_searches));
+  }
+  for (unsigned int terminal_depth : {5, 10, 20, 40}) {
+    auto parameters = synthetic_base;
+    parameters.TERMINAL_DEPTH = terminal_depth;
+    print_point("synthetic", "terminal_depth", terminal_depth,
+                run_synthetic_state(parameters, mcts_parameters, num_searches));
+  }
+  for (unsigned int execute_cost : {0, 10, 100, 1000}) {
+    auto parameters = synthetic_base;
+    parameters.EXECUTE_COST = execute_cost;
+    print_point("synthetic", "execute_cost", execute_cost,
+                run_synthetic_state(parameters, mcts_parameters, num_searches));
+  }
+  for (unsigned int rollout_depth : {1, 5, 20, 80}) {
+    auto parameters = synthetic_base;
+    parameters.TERMINAL_DEPTH = 100;
+    auto rollout_mcts_parameters = mcts_parameters;
+    rollout_mcts_parameters.random_heuristic.MAX_NUMBER_OF_ITERATIONS = rollout_depth;
+    print_point("synthetic", "rollout_depth", rollout_depth,
+                run_synthetic_state(parameters, rollout_mcts_parameters, num_searches));
+  }
+
+  const auto crossing_base = default_crossing_state_parameters<int>();
+  const unsigned int crossing_base_hypothesis = 2;
+  for (unsigned int num_other_agents : {1, 2, 4, 8}) {
+    auto parameters = crossing_base;
+    parameters.NUM_OTHER_AGENTS = num_other_agents;
+    print_point("crossing_state", "other_agents", num_other_agents,
+                run_crossing_state(parameters, crossing_base_hypothesis, mcts_parameters, num_searches));
+  }
+  for (unsigned int num_hypothesis : {1, 2, 4, 8, 16}) {
+    print_point("crossing_state", "hypotheses", num_hypothesis,
+                run_crossing_state(crossing_base, num_hypothesis, mcts_parameters, num_searches));
+  }
+  for (unsigned int rollout_depth : {1, 5, 20, 80}) {
+    auto rollout_mcts_parameters = mcts_parameters;
+    rollout_mcts_parameters.random_heuristic.MAX_NUMBER_OF_ITERATIONS = rollout_depth;
+    print_point("crossing_state", "rollout_depth", rollout_depth,
+                run_crossing_state(crossing_base, crossing_base_hypothesis, rollout_mcts_parameters, num_searches));
+  }
+  return 0;
+}
@@ -0,0 +1,107 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+// Reruns searches recorded with a SearchRecorder, e.g. by Mcts::set_recorder or CrossingStateEpisodeRunner::set_recorder.
+// Each repetition reloads the recorded inputs and searches for the recorded number of iterations without time limits,
+// such that the search takes the same path as the recorded one. Combine with --config=profiling or
+// --config=perf_counters to obtain the phase profile or hardware counters of a slow search.
+// Rollouts cut by random_heuristic.MAX_SEARCH_TIME during recording are not reproduced.
+
+#include "mcts/mcts.h"
+#include "mcts/search_recorder.h"
+#include "mcts/heuristics/random_heuristic.h"
+#include "mcts/statistics/uct_statistic.h"
+#include "mcts/hypothesis/hypothesis_statistic.h"
+#include "mcts/hypothesis/hypothesis_belief_tracker.h"
+#include "environments/crossing_state.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <typeinfo>
+
+using namespace mcts;
+
+namespace {
+
+// Replays the record if it was recorded by Mcts<CrossingState<Domain>, UctStatistic, SO, RandomHeuristic>
+template<typename Domain, class SO>
+bool replay_crossing_state(const SearchRecord& record, const unsigned int& repetitions) {
+  typedef Mcts<CrossingState<Domain>, UctStatistic, SO, RandomHeuristic> CrossingStateMcts;
+  if(record.search_type != typeid(CrossingStateMcts).name()) {
+    return false;
+  }
+  for (unsigned int repetition = 0; repetition < repetitions; ++repetition) {
+    RecordReader reader(record.inputs);
+    auto mcts_parameters = read_parameters(reader);
+    mcts_parameters.MAX_NUMBER_OF_ITERATIONS = record.num_iterations;
+    mcts_parameters.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+    mcts_parameters.random_heuristic.MAX_SEARCH_TIME = std::numeric_limits<double>::max();
+    HypothesisBeliefTracker belief_tracker(mcts_parameters);
+    const bool with_belief_tracker = reader.read<bool>();
+    if(with_belief_tracker) {
+      belief_tracker.load(reader);
+    }
+    CrossingStateParameters<Domain> parameters;
+    const auto state = CrossingState<Domain>::load(reader, belief_tracker.get_current_hypothesis(), parameters);
+
+    CrossingStateMcts mcts(mcts_parameters);
+    const auto start = std::chrono::high_resolution_clock::now();
+    if(with_belief_tracker) {
+      mcts.search(*state, belief_tracker);
+    } else {
+      mcts.search(*state);
+    }
+    const std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
+    const bool reproduced = mcts.numIterations() == record.num_iterations &&
+                            mcts.returnBestAction() == record.best_action;
+    std::cout << "Repetition " << repetition << ": " << mcts.numIterations() << " iterations in " << duration.count()
+              << " ms (recorded " << record.search_time << " ms), best action " << mcts.returnBestAction()
+              << " (recorded " << record.best_action << ")" << (reproduced ? "" : ", NOT REPRODUCED") << std::endl;
+    if(SearchProfile::enabled()) {
+      std::cout << mcts.profile().sprintf();
+    }
+    if(PerfReport::enabled()) {
+      std::cout << mcts.perf_report().sprintf();
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  // usage: search_replay <record file> [record index, default all] [repetitions]
+  if(argc < 2) {
+    std::cerr << "usage: " << argv[0] << " <record file> [record index] [repetitions]" << std::endl;
+    return 1;
+  }
+  const auto records = read_search_records(argv[1]);
+  const bool all_records = argc < 3 || std::atoi(argv[2]) < 0;
+  const std::size_t first = all_records ? 0 : std::atoi(argv[2]);
+  const std::size_t last = all_records ? records.size() : first + 1;
+  const unsigned int repetitions = argc > 3 ? std::atoi(argv[3]) : 1;
+  if(first >= records.size()) {
+    std::cerr << argv[1] << " contains " << records.size() << " records" << std::endl;
+    return 1;
+  }
+
+  for (std::size_t record_idx = first; record_idx < last; ++record_idx) {
+    const auto& record = records[record_idx];
+    std::cout << "Record " << record_idx << ": " << record.num_iterations << " iterations in "
+              << record.search_time << " ms" << std::endl;
+    const bool replayed = replay_crossing_state<int, HypothesisStatistic>(record, repetitions) ||
+                          replay_crossing_state<int, UctStatistic>(record, repetitions) ||
+                          replay_crossing_state<float, HypothesisStatistic>(record, repetitions) ||
+                          replay_crossing_state<float, UctStatistic>(record, repetitions);
+    if(!replayed) {
+      std::cerr << "No replay for search type " << record.search_type << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
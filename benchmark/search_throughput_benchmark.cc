@@ -0,0 +1,117 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+// Search throughput of Mcts for the environments and statistic pairings of the tree. One benchmark iteration
+// is a search with the number of search iterations given as argument as the only budget. Counters report
+// search iterations, stage nodes and rollout steps per second. The target search_throughput_benchmark_dynamic_interface
+// runs the same benchmarks with CRTP_DYNAMIC_INTERFACE to compare static against dynamic polymorphism.
+// Built with --config=perf_counters, hardware counts per call of the instrumented regions are reported as well.
+
+#include "benchmark/benchmark.h"
+
+#include "mcts/mcts.h"
+#include "mcts/heuristics/random_heuristic.h"
+#include "mcts/statistics/uct_statistic.h"
+#include "mcts/hypothesis/hypothesis_statistic.h"
+#include "mcts/hypothesis/hypothesis_belief_tracker.h"
+#include "environments/crossing_state.h"
+#include "test/uct/simple_state.h"
+
+#include <limits>
+
+using namespace mcts;
+
+namespace {
+
+MctsParameters benchmark_parameters(const unsigned int& num_iterations) {
+  auto parameters = mcts_default_parameters();
+  parameters.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+  parameters.MAX_NUMBER_OF_ITERATIONS = num_iterations;
+  parameters.random_heuristic.MAX_SEARCH_TIME = std::numeric_limits<double>::max();
+  return parameters;
+}
+
+// SimpleState has no hypotheses, it is only searched with Uct statistics for all agents
+struct SimpleStateProblem {
+  explicit SimpleStateProblem(const MctsParameters& mcts_parameters) : state_(4) {}
+
+  template<class M>
+  void search(M& mcts) { mcts.search(state_); }
+
+  SimpleState state_;
+};
+
+template<typename Domain>
+struct CrossingStateProblem {
+  explicit CrossingStateProblem(const MctsParameters& mcts_parameters) :
+                parameters_(default_crossing_state_parameters<Domain>()),
+                belief_tracker_(mcts_parameters),
+                state_() {
+    state_ = std::make_shared<CrossingState<Domain>>(belief_tracker_.sample_current_hypothesis(), parameters_,
+                  make_hypothesis_set<Domain>({AgentPolicyCrossingState<Domain>({4,5}, parameters_),
+                                               AgentPolicyCrossingState<Domain>({5,6}, parameters_)}));
+    belief_tracker_.belief_update(*state_, *state_);
+  }
+
+  template<class M>
+  void search(M& mcts) { mcts.search(*state_, belief_tracker_); }
+
+  const CrossingStateParameters<Domain> parameters_;
+  HypothesisBeliefTracker belief_tracker_;
+  std::shared_ptr<CrossingState<Domain>> state_;
+};
+
+// Hardware counts per call of each instrumented region, e.g. uct_choose_next_action/cache_misses
+void add_perf_counters(benchmark::State& benchmark_state, const PerfReport& perf_report) {
+  for (unsigned int region = 0; region < NUM_PERF_REGIONS; ++region) {
+    const auto perf_region = static_cast<PerfRegion>(region);
+    if(perf_report.get_calls(perf_region) == 0) {
+      continue;
+    }
+    for (unsigned int counter = 0; counter < NUM_PERF_COUNTERS; ++counter) {
+      const auto perf_counter = static_cast<PerfCounter>(counter);
+      benchmark_state.counters[perf_region_name(perf_region) + "/" + perf_counter_name(perf_counter)] =
+                  perf_report.get_count_per_call(perf_region, perf_counter);
+    }
+  }
+}
+
+template<class P, class S, class SE, class SO>
+void BM_Search(benchmark::State& benchmark_state) {
+  const auto parameters = benchmark_parameters(benchmark_state.range(0));
+  P problem(parameters);
+  double num_iterations = 0, num_nodes = 0, num_rollout_steps = 0;
+  PerfReport perf_report;
+  for (auto _ : benchmark_state) {
+    Mcts<S, SE, SO, RandomHeuristic> mcts(parameters);
+    problem.search(mcts);
+    num_iterations += mcts.numIterations();
+    num_nodes += mcts.numNodes();
+    num_rollout_steps += mcts.get_heuristic_function().get_num_rollout_steps();
+    perf_report.merge(mcts.perf_report());
+  }
+  benchmark_state.counters["iterations"] = benchmark::Counter(num_iterations, benchmark::Counter::kIsRate);
+  benchmark_state.counters["nodes"] = benchmark::Counter(num_nodes, benchmark::Counter::kIsRate);
+  benchmark_state.counters["rollout_steps"] = benchmark::Counter(num_rollout_steps, benchmark::Counter::kIsRate);
+  if(PerfReport::enabled()) {
+    add_perf_counters(benchmark_state, perf_report);
+  }
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_Search, SimpleStateProblem, SimpleState, UctStatistic, UctStatistic)
+    ->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Search, CrossingStateProblem<int>, CrossingState<int>, UctStatistic, UctStatistic)
+    ->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Search, CrossingStateProblem<int>, CrossingState<int>, UctStatistic, HypothesisStatistic)
+    ->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Search, CrossingStateProblem<float>, CrossingState<float>, UctStatistic, UctStatistic)
+    ->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Search, CrossingStateProblem<float>, CrossingState<float>, UctStatistic, HypothesisStatistic)
+    ->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
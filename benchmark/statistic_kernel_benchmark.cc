@@ -0,0 +1,340 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+// Microbenchmarks of the statistic and belief kernels isolated from the search. Statistics are warmed up
+// with backpropagations before measuring, benchmark arguments are the action, hypothesis and history sizes.
+// Results are written as JSON to statistic_kernel_benchmark.json in the working directory of bazel run
+// unless --benchmark_out is given, such that runs of different commits can be compared with the
+// compare.py tool of Google Benchmark.
+
+#include "benchmark/benchmark.h"
+
+#include "mcts/statistics/uct_statistic.h"
+#include "mcts/hypothesis/hypothesis_statistic.h"
+#include "mcts/hypothesis/hypothesis_belief_tracker.h"
+#include "environments/crossing_state.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace mcts;
+
+namespace {
+
+// Hypothesis state with a configurable number of actions and hypotheses, each hypothesis samples
+// uniformly from a window of actions such that hypotheses overlap partially
+class KernelState : public HypothesisStateInterface<KernelState> {
+public:
+  KernelState(const std::unordered_map<AgentIdx, HypothesisId>& current_agents_hypothesis,
+              const ActionIdx& num_actions, const HypothesisId& num_hypothesis) :
+                HypothesisStateInterface<KernelState>(current_agents_hypothesis),
+                num_actions_(num_actions),
+                num_hypothesis_(num_hypothesis) {}
+
+  ActionIdx plan_action_current_hypothesis(const AgentIdx& agent_idx, Philox4x32& random_generator) const {
+    const ActionIdx window = std::max<ActionIdx>(num_actions_ / 2, 1);
+    const ActionIdx offset = (current_agents_hypothesis_.at(agent_idx) * num_actions_ / num_hypothesis_) % num_actions_;
+    std::uniform_int_distribution<ActionIdx> action_distribution(0, window - 1);
+    return (offset + action_distribution(random_generator)) % num_actions_;
+  }
+
+  HypothesisId get_num_hypothesis(const AgentIdx& agent_idx) const { return num_hypothesis_; }
+
+  const AgentIdxVector& get_other_agent_idx() const {
+    static const AgentIdxVector other_agent_idx{1};
+    return other_agent_idx;
+  }
+
+  const AgentIdx get_ego_agent_idx() const { return 0; }
+
+  typedef ActionIdx ActionType;
+
+private:
+  const ActionIdx num_actions_;
+  const HypothesisId num_hypothesis_;
+};
+
+MctsParameters kernel_parameters() {
+  auto parameters = mcts_default_parameters();
+  // Keep normalized values within bounds for the returns used below
+  parameters.uct_statistic.LOWER_BOUND = -10;
+  parameters.uct_statistic.UPPER_BOUND = 10;
+  parameters.hypothesis_statistic.LOWER_COST_BOUND = 0;
+  parameters.hypothesis_statistic.UPPER_COST_BOUND = 10;
+  return parameters;
+}
+
+// Backpropagates a child value in [-1, 1] through the chosen action as the search does
+template<class Stat>
+void backpropagate(Stat& statistic, const ActionIdx& action, const double& child_value,
+                   const MctsParameters& parameters) {
+  Stat heuristic(0, 0, parameters);
+  heuristic.set_heuristic_estimate(child_value, 1.0 + child_value);
+  Stat child(0, 0, parameters);
+  child.update_from_heuristic(heuristic);
+  statistic.collect(child_value, 1.0 - child_value, action);
+  statistic.update_statistic(child);
+}
+
+void warm_up(UctStatistic& statistic, const ActionIdx& num_actions, const MctsParameters& parameters) {
+  const std::unordered_map<AgentIdx, HypothesisId> hypothesis;
+  const KernelState state(hypothesis, num_actions, 1);
+  const unsigned int num_visits = 10 * num_actions;
+  std::uniform_real_distribution<double> value_distribution(-1.0, 1.0);
+  for (unsigned int visit = 0; visit < num_visits; ++visit) {
+    const auto action = statistic.choose_next_action(state);
+    backpropagate(statistic, action, value_distribution(statistic.random_generator_), parameters);
+  }
+}
+
+void BM_UctCalculateUcbValues(benchmark::State& benchmark_state) {
+  const ActionIdx num_actions = benchmark_state.range(0);
+  const auto parameters = kernel_parameters();
+  UctStatistic statistic(num_actions, 0, parameters);
+  warm_up(statistic, num_actions, parameters);
+  std::vector<double> values;
+  for (auto _ : benchmark_state) {
+    statistic.calculate_ucb_values(statistic.get_ucb_statistics(), values);
+    benchmark::DoNotOptimize(values.data());
+  }
+  benchmark_state.SetItemsProcessed(benchmark_state.iterations() * num_actions);
+}
+
+void BM_UctChooseNextAction(benchmark::State& benchmark_state) {
+  const ActionIdx num_actions = benchmark_state.range(0);
+  const auto parameters = kernel_parameters();
+  const std::unordered_map<AgentIdx, HypothesisId> hypothesis;
+  const KernelState state(hypothesis, num_actions, 1);
+  UctStatistic statistic(num_actions, 0, parameters);
+  warm_up(statistic, num_actions, parameters);
+  for (auto _ : benchmark_state) {
+    benchmark::DoNotOptimize(statistic.choose_next_action(state));
+  }
+}
+
+void BM_UctUpdateStatistic(benchmark::State& benchmark_state) {
+  const ActionIdx num_actions = benchmark_state.range(0);
+  const auto parameters = kernel_parameters();
+  UctStatistic statistic(num_actions, 0, parameters);
+  warm_up(statistic, num_actions, parameters);
+  UctStatistic heuristic(0, 0, parameters);
+  heuristic.set_heuristic_estimate(0.5, 0.0);
+  UctStatistic child(0, 0, parameters);
+  child.update_from_heuristic(heuristic);
+  ActionIdx action = 0;
+  for (auto _ : benchmark_state) {
+    statistic.collect(0.1, 0.0, action);
+    statistic.update_statistic(child);
+    action = (action + 1) % num_actions;
+  }
+}
+
+// Widening modes of the hypothesis statistic: hypothesis based or total progressive widening,
+// random or cost based selection among expanded actions
+enum HypothesisWideningMode {
+  HYPOTHESIS_BASED_RANDOM = 0,
+  TOTAL_RANDOM = 1,
+  HYPOTHESIS_BASED_COST = 2,
+  TOTAL_COST = 3
+};
+
+MctsParameters hypothesis_parameters(const HypothesisWideningMode& mode) {
+  auto parameters = kernel_parameters();
+  parameters.hypothesis_statistic.PROGRESSIVE_WIDENING_HYPOTHESIS_BASED =
+                mode == HYPOTHESIS_BASED_RANDOM || mode == HYPOTHESIS_BASED_COST;
+  parameters.hypothesis_statistic.COST_BASED_ACTION_SELECTION =
+                mode == HYPOTHESIS_BASED_COST || mode == TOTAL_COST;
+  return parameters;
+}
+
+void BM_HypothesisChooseNextAction(benchmark::State& benchmark_state) {
+  const ActionIdx num_actions = benchmark_state.range(0);
+  const HypothesisId num_hypothesis = benchmark_state.range(1);
+  const auto parameters = hypothesis_parameters(static_cast<HypothesisWideningMode>(benchmark_state.range(2)));
+  std::unordered_map<AgentIdx, HypothesisId> hypothesis{{1, 0}};
+  const KernelState state(hypothesis, num_actions, num_hypothesis);
+  HypothesisStatistic statistic(num_actions, 1, parameters);
+  std::uniform_real_distribution<double> value_distribution(0.0, 1.0);
+  for (unsigned int visit = 0; visit < 10 * num_actions * num_hypothesis; ++visit) {
+    hypothesis[1] = visit % num_hypothesis;
+    const auto action = statistic.choose_next_action(state);
+    backpropagate(statistic, action, value_distribution(statistic.random_generator_), parameters);
+  }
+  HypothesisId hypothesis_id = 0;
+  for (auto _ : benchmark_state) {
+    hypothesis[1] = hypothesis_id;
+    benchmark::DoNotOptimize(statistic.choose_next_action(state));
+    hypothesis_id = (hypothesis_id + 1) % num_hypothesis;
+  }
+}
+
+void BM_HypothesisGetWorstCaseAction(benchmark::State& benchmark_state) {
+  const ActionIdx num_actions = benchmark_state.range(0);
+  const auto parameters = kernel_parameters();
+  HypothesisStatistic statistic(num_actions, 1, parameters);
+  std::unordered_map<ActionIdx, HypothesisStatistic::UcbPair> ucb_statistics;
+  unsigned int node_visits = 0;
+  for (ActionIdx action = 0; action < num_actions; ++action) {
+    auto& ucb_pair = ucb_statistics[action];
+    ucb_pair.action_count_ = 1 + action % 7;
+    ucb_pair.action_ego_cost_ = static_cast<double>(action % 10);
+    node_visits += ucb_pair.action_count_;
+  }
+  for (auto _ : benchmark_state) {
+    benchmark::DoNotOptimize(statistic.get_worst_case_action(ucb_statistics, node_visits));
+  }
+  benchmark_state.SetItemsProcessed(benchmark_state.iterations() * num_actions);
+}
+
+// Crossing state with a hypothesis set of the given size and the state reached by one step, the other
+// agents' last actions thus have to be explained by the hypotheses
+template<typename Domain>
+struct CrossingStateBelief {
+  CrossingStateBelief(const HypothesisId& num_hypothesis, const unsigned int& history_length) :
+                parameters_(default_crossing_state_parameters<Domain>()),
+                mcts_parameters_([&]() {
+                  auto mcts_parameters = mcts_default_parameters();
+                  mcts_parameters.hypothesis_belief_tracker.HISTORY_LENGTH = history_length;
+                  return mcts_parameters;
+                }()),
+                belief_tracker_(mcts_parameters_),
+                hypothesis_(),
+                state_(),
+                next_state_() {
+    HypothesisSet<Domain> hypothesis_set;
+    for (HypothesisId hid = 0; hid < num_hypothesis; ++hid) {
+      const Domain lower = static_cast<Domain>(hid % 6);
+      hypothesis_set.push_back(AgentPolicyCrossingState<Domain>({lower, lower + 2}, parameters_));
+    }
+    for (AgentIdx agent_idx = 1; agent_idx <= parameters_.NUM_OTHER_AGENTS; ++agent_idx) {
+      hypothesis_[agent_idx] = 0;
+    }
+    state_ = std::make_shared<CrossingState<Domain>>(hypothesis_, parameters_, make_hypothesis_set<Domain>(hypothesis_set));
+    JointAction joint_action(state_->get_num_agents());
+    joint_action[CrossingState<Domain>::ego_agent_idx] = 1;
+    Philox4x32 random_generator(parameters_.OTHER_AGENTS_POLICY_RANDOM_SEED);
+    for (auto agent_idx : state_->get_other_agent_idx()) {
+      joint_action[agent_idx] = state_->plan_action_current_hypothesis(agent_idx, random_generator);
+    }
+    std::vector<Reward> rewards;
+    Cost cost;
+    next_state_ = state_->execute(joint_action, rewards, cost);
+    belief_tracker_.belief_update(*state_, *state_);
+  }
+
+  const CrossingStateParameters<Domain> parameters_;
+  const MctsParameters mcts_parameters_;
+  HypothesisBeliefTracker belief_tracker_;
+  std::unordered_map<AgentIdx, HypothesisId> hypothesis_;
+  std::shared_ptr<CrossingState<Domain>> state_;
+  std::shared_ptr<CrossingState<Domain>> next_state_;
+};
+
+template<typename Domain>
+void BM_BeliefUpdate(benchmark::State& benchmark_state) {
+  CrossingStateBelief<Domain> belief(benchmark_state.range(0), benchmark_state.range(1));
+  // Fill the probability history such that every update discards the oldest probability
+  for (int step = 0; step < benchmark_state.range(1); ++step) {
+    belief.belief_tracker_.belief_update(*belief.state_, *belief.next_state_);
+  }
+  for (auto _ : benchmark_state) {
+    belief.belief_tracker_.belief_update(*belief.state_, *belief.next_state_);
+  }
+}
+
+template<typename Domain>
+void BM_SampleCurrentHypothesis(benchmark::State& benchmark_state) {
+  CrossingStateBelief<Domain> belief(benchmark_state.range(0), 4);
+  belief.belief_tracker_.belief_update(*belief.state_, *belief.next_state_);
+  for (auto _ : benchmark_state) {
+    benchmark::DoNotOptimize(belief.belief_tracker_.sample_current_hypothesis());
+  }
+}
+
+// Probability of the other agent's actions for a grid of agent positions around the ego agent,
+// the first argument selects the tabulated policy for the integer domain
+template<typename Domain>
+void BM_AgentPolicyGetProbability(benchmark::State& benchmark_state) {
+  auto parameters = default_crossing_state_parameters<Domain>();
+  parameters.TABULATE_OTHER_AGENTS_POLICY = benchmark_state.range(0);
+  const AgentPolicyCrossingState<Domain> policy({1, 4}, parameters);
+  const AgentState<Domain> ego_state(5, 1);
+  std::vector<std::pair<AgentState<Domain>, Domain>> queries;
+  for (Domain x_pos = 0; x_pos < parameters.CHAIN_LENGTH; x_pos += 1) {
+    for (Domain last_action = parameters.MIN_VELOCITY_OTHER; last_action <= parameters.MAX_VELOCITY_OTHER; last_action += 1) {
+      queries.emplace_back(AgentState<Domain>(x_pos, last_action), last_action);
+    }
+  }
+  std::size_t query_idx = 0;
+  for (auto _ : benchmark_state) {
+    const auto& query = queries[query_idx];
+    benchmark::DoNotOptimize(policy.get_probability(query.first, ego_state, query.second));
+    query_idx = (query_idx + 1) % queries.size();
+  }
+}
+
+void action_sizes(benchmark::internal::Benchmark* benchmark) {
+  for (int num_actions : {4, 16, 64, 256}) {
+    benchmark->Arg(num_actions);
+  }
+}
+
+void hypothesis_sizes(benchmark::internal::Benchmark* benchmark) {
+  for (int mode = HYPOTHESIS_BASED_RANDOM; mode <= TOTAL_COST; ++mode) {
+    for (int num_actions : {8, 64}) {
+      for (int num_hypothesis : {1, 4, 16}) {
+        benchmark->Args({num_actions, num_hypothesis, mode});
+      }
+    }
+  }
+}
+
+void belief_sizes(benchmark::internal::Benchmark* benchmark) {
+  for (int num_hypothesis : {2, 8, 32}) {
+    for (int history_length : {1, 4, 16}) {
+      benchmark->Args({num_hypothesis, history_length});
+    }
+  }
+}
+
+} // namespace
+
+BENCHMARK(BM_UctCalculateUcbValues)->Apply(action_sizes);
+BENCHMARK(BM_UctChooseNextAction)->Apply(action_sizes);
+BENCHMARK(BM_UctUpdateStatistic)->Apply(action_sizes);
+BENCHMARK(BM_HypothesisChooseNextAction)->Apply(hypothesis_sizes)->ArgNames({"actions", "hypotheses", "mode"});
+BENCHMARK(BM_HypothesisGetWorstCaseAction)->Apply(action_sizes);
+BENCHMARK_TEMPLATE(BM_BeliefUpdate, int)->Apply(belief_sizes)->ArgNames({"hypotheses", "history"});
+BENCHMARK_TEMPLATE(BM_BeliefUpdate, float)->Apply(belief_sizes)->ArgNames({"hypotheses", "history"});
+BENCHMARK_TEMPLATE(BM_SampleCurrentHypothesis, int)->Arg(2)->Arg(8)->Arg(32);
+BENCHMARK_TEMPLATE(BM_AgentPolicyGetProbability, int)->Arg(0)->Arg(1)->ArgName("tabulated");
+BENCHMARK_TEMPLATE(BM_AgentPolicyGetProbability, float)->Arg(0)->ArgName("tabulated");
+
+int main(int argc, char** argv) {
+  // Default to a JSON report next to the invoking shell, bazel run executes in the runfiles tree
+  std::vector<char*> arguments(argv, argv + argc);
+  std::string out_argument;
+  const std::string out_format_argument = "--benchmark_out_format=json";
+  bool has_out = false;
+  for (int arg = 1; arg < argc; ++arg) {
+    has_out |= std::strncmp(argv[arg], "--benchmark_out=", std::strlen("--benchmark_out=")) == 0;
+  }
+  if(!has_out) {
+    const char* working_directory = std::getenv("BUILD_WORKING_DIRECTORY");
+    out_argument = std::string("--benchmark_out=") + (working_directory ? std::string(working_directory) + "/" : "") +
+                    "statistic_kernel_benchmark.json";
+    arguments.push_back(&out_argument[0]);
+    arguments.push_back(const_cast<char*>(out_format_argument.c_str()));
+  }
+  int num_arguments = arguments.size();
+  benchmark::Initialize(&num_arguments, arguments.data());
+  if(benchmark::ReportUnrecognizedArguments(num_arguments, arguments.data())) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
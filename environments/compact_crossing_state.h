@@ -0,0 +1,334 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef COMPACT_CROSSING_STATE_H
+#define COMPACT_CROSSING_STATE_H
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include "mcts/hypothesis/hypothesis_state.h"
+
+#include "environments/crossing_state.h"
+
+namespace mcts {
+
+// Storage type of positions and last actions, the int domain is narrowed to 16 bit
+template <typename Domain>
+struct CompactCrossingStorage {
+    typedef Domain type;
+};
+
+template <>
+struct CompactCrossingStorage<int> {
+    typedef std::int16_t type;
+};
+
+// Structure-of-arrays variant of CrossingState with the same dynamics and interface.
+// Positions and last actions of all agents (ego first) are kept in one fixed capacity block inside the state,
+// flags are packed into a single byte and hypothesis set and agent indices are shared by all states.
+template <typename Domain>
+class CompactCrossingState : public mcts::HypothesisStateInterface<CompactCrossingState<Domain>>
+{
+public:
+    typedef typename CompactCrossingStorage<Domain>::type Storage;
+
+    // Capacity of the agent block including the ego agent, larger scenes are rejected on construction
+    static constexpr std::size_t MAX_NUM_AGENTS = 8;
+
+    CompactCrossingState(const std::unordered_map<AgentIdx, HypothesisId>& current_agents_hypothesis,
+                         const CrossingStateParameters<Domain>& parameters) :
+                            HypothesisStateInterface<CompactCrossingState<Domain>>(current_agents_hypothesis),
+                            shared_(std::make_shared<const Shared>(std::make_shared<const HypothesisSet<Domain>>(),
+                                                                   parameters.NUM_OTHER_AGENTS)),
+                            data_(),
+                            flags_(0),
+                            parameters_(parameters) {
+                                check_parameters(parameters, parameters.NUM_OTHER_AGENTS);
+                                for (AgentIdx agent_idx = 0; agent_idx < num_agents(); ++agent_idx) {
+                                    set_agent_state(agent_idx, AgentState<Domain>());
+                                }
+                            }
+
+    CompactCrossingState(const std::unordered_map<AgentIdx, HypothesisId>& current_agents_hypothesis,
+                         const CrossingStateParameters<Domain>& parameters,
+                         const HypothesisSetSPtr<Domain>& hypothesis) :
+                            CompactCrossingState(current_agents_hypothesis, parameters) {
+                                shared_ = std::make_shared<const Shared>(hypothesis, parameters.NUM_OTHER_AGENTS);
+                            }
+
+    CompactCrossingState(const std::unordered_map<AgentIdx, HypothesisId>& current_agents_hypothesis,
+                         const CrossingState<Domain>& state,
+                         const CrossingStateParameters<Domain>& parameters) :
+                            HypothesisStateInterface<CompactCrossingState<Domain>>(current_agents_hypothesis),
+                            shared_(std::make_shared<const Shared>(state.get_hypothesis_set(),
+                                                                   state.get_agent_states().size())),
+                            data_(),
+                            flags_(pack_flags(state.is_terminal(), state.ego_goal_reached(), state.ego_collided())),
+                            parameters_(parameters) {
+                                check_parameters(parameters, state.get_agent_states().size());
+                                set_agent_state(this->ego_agent_idx, state.get_ego_state());
+                                for (AgentIdx agent_idx = 1; agent_idx < num_agents(); ++agent_idx) {
+                                    set_agent_state(agent_idx, state.get_agent_state(agent_idx));
+                                }
+                            }
+
+    CompactCrossingState(const CompactCrossingState& other) :
+                            HypothesisStateInterface<CompactCrossingState<Domain>>(other.current_agents_hypothesis_),
+                            shared_(other.shared_),
+                            data_(other.data_),
+                            flags_(other.flags_),
+                            parameters_(other.parameters_) {}
+
+    ~CompactCrossingState() {};
+
+    std::shared_ptr<CompactCrossingState> clone() const
+    {
+        return std::make_shared<CompactCrossingState>(*this);
+    }
+
+    ActionIdx plan_action_current_hypothesis(const AgentIdx& agent_idx, Philox4x32& random_generator) const {
+        const HypothesisId agt_hyp_id = this->current_agents_hypothesis_.at(agent_idx);
+        return aconv(shared_->hypothesis->at(agt_hyp_id).act(get_agent_state(agent_idx),
+                                                             get_ego_state(), random_generator));
+    };
+
+    template<typename ActionType = Domain>
+    Probability get_probability(const HypothesisId& hypothesis, const AgentIdx& agent_idx, const Domain& action) const {
+        return shared_->hypothesis->at(hypothesis).get_probability(get_agent_state(agent_idx), get_ego_state(), action);
+    }
+
+    template<typename ActionType = Domain>
+    ActionType get_last_action(const AgentIdx& agent_idx) const {
+        return last_actions()[agent_idx];
+    }
+
+    Probability get_prior(const HypothesisId& hypothesis, const AgentIdx& agent_idx) const { return 0.5f;}
+
+    HypothesisId get_num_hypothesis(const AgentIdx& agent_idx) const {return shared_->hypothesis->size();}
+
+    std::shared_ptr<CompactCrossingState<Domain>> execute(const JointAction& joint_action, std::vector<Reward>& rewards, Cost& ego_cost) const {
+        auto next_state = std::shared_ptr<CompactCrossingState<Domain>>(new CompactCrossingState(*this, Uninitialized()));
+        Storage* next_positions = next_state->positions();
+        Storage* next_last_actions = next_state->last_actions();
+
+        const Domain crossing_point = parameters_.CROSSING_POINT();
+        const Domain old_x_ego = positions()[this->ego_agent_idx];
+        const Domain ego_action = idx_to_ego_crossing_action(joint_action[this->ego_agent_idx]);
+        const Domain new_x_ego = old_x_ego + ego_action;
+        const bool ego_out_of_map = new_x_ego < 0;
+        next_positions[this->ego_agent_idx] = narrow(new_x_ego);
+        next_last_actions[this->ego_agent_idx] = narrow(ego_action);
+        const bool ego_crosses = next_positions[this->ego_agent_idx] >= crossing_point && old_x_ego <= crossing_point;
+
+        bool collision = false;
+        for (AgentIdx agent_idx = 1; agent_idx < num_agents(); ++agent_idx) {
+            const Domain old_x = positions()[agent_idx];
+            const Domain action = aconv<Domain>(joint_action[agent_idx]);
+            const Domain new_x = old_x + action;
+            next_positions[agent_idx] = narrow((new_x >= 0) ? new_x : 0);
+            next_last_actions[agent_idx] = narrow(action);
+
+            // if ego state history encloses crossing point and other state history encloses crossing point
+            // a collision occurs
+            collision |= ego_crosses && next_positions[agent_idx] >= crossing_point && old_x <= crossing_point;
+        }
+
+        const bool goal_reached = (next_positions[this->ego_agent_idx] >= parameters_.EGO_GOAL_POS) && !collision;
+        const bool terminal = goal_reached || collision || ego_out_of_map;
+        next_state->flags_ = pack_flags(terminal, goal_reached, collision);
+
+        rewards.resize(num_agents());
+        rewards[0] = goal_reached * parameters_.REWARD_GOAL_REACHED
+                   + collision * parameters_.REWARD_COLLISION + parameters_.REWARD_COLLISION * ego_out_of_map
+                   + parameters_.REWARD_STEP;
+        if(parameters_.COST_ONLY_COLLISION) {
+          ego_cost = collision * 1.0f;
+        } else {
+          ego_cost = -1.0f*rewards[0];
+        }
+        return next_state;
+    }
+
+    ActionIdx get_num_actions(AgentIdx agent_idx) const {
+        if(agent_idx == this->ego_agent_idx) {
+            return parameters_.NUM_EGO_ACTIONS();
+        } else {
+            return parameters_.NUM_OTHER_ACTIONS;
+        }
+    }
+
+    bool is_terminal() const {
+        return flags_ & TERMINAL;
+    }
+
+    const AgentIdxVector& get_other_agent_idx() const {
+        return shared_->other_agent_idx;
+    }
+
+    const AgentIdx get_ego_agent_idx() const {
+        return 0;
+    }
+
+    std::string sprintf() const
+    {
+        std::stringstream ss;
+        ss << "Ego: x=" << Domain(positions()[this->ego_agent_idx]);
+        for (AgentIdx agent_idx = 1; agent_idx < num_agents(); ++agent_idx) {
+            ss << ", Ag" << agent_idx-1 << ": x=" << Domain(positions()[agent_idx]);
+        }
+        ss << std::endl;
+        return ss.str();
+    }
+
+    // Copy on write: states already referencing the previous set keep it unchanged
+    void add_hypothesis(const AgentPolicyCrossingState<Domain>& hypothesis) {
+        auto extended = std::make_shared<HypothesisSet<Domain>>(*shared_->hypothesis);
+        extended->push_back(hypothesis);
+        shared_ = std::make_shared<const Shared>(extended, num_agents()-1);
+    }
+
+    const HypothesisSetSPtr<Domain>& get_hypothesis_set() const {
+        return shared_->hypothesis;
+    }
+
+    bool ego_goal_reached() const {
+        return flags_ & GOAL_REACHED;
+    }
+
+    bool ego_collided() const {
+        return flags_ & COLLIDED;
+    }
+
+    int min_distance_to_ego() const {
+        int min_dist = std::numeric_limits<int>::max();
+        for (AgentIdx agent_idx = 1; agent_idx < num_agents(); ++agent_idx) {
+            const auto dist = distance_to_ego(agent_idx-1);
+            if (min_dist > dist) {
+                min_dist = dist;
+            }
+        }
+        return min_dist;
+    }
+
+    inline AgentState<Domain> get_agent_state(const AgentIdx& agent_idx) const {
+        return AgentState<Domain>(positions()[agent_idx], last_actions()[agent_idx]);
+    }
+
+    inline AgentState<Domain> get_ego_state() const {
+        return get_agent_state(this->ego_agent_idx);
+    }
+
+    std::vector<AgentState<Domain>> get_agent_states() const {
+        std::vector<AgentState<Domain>> agent_states;
+        agent_states.reserve(num_agents()-1);
+        for (AgentIdx agent_idx = 1; agent_idx < num_agents(); ++agent_idx) {
+            agent_states.push_back(get_agent_state(agent_idx));
+        }
+        return agent_states;
+    }
+
+    inline int distance_to_ego(const AgentIdx& other_agent_idx) const {
+        return positions()[this->ego_agent_idx] - positions()[other_agent_idx+1];
+    }
+
+    void draw(mcts::Viewer* viewer) const {
+        CrossingState<Domain>(this->current_agents_hypothesis_, parameters_, get_agent_states(), get_ego_state(),
+                              is_terminal(), ego_goal_reached(), ego_collided(), get_hypothesis_set()).draw(viewer);
+    }
+
+    const CrossingStateParameters<Domain>& get_parameters() const {
+        return parameters_;
+    }
+
+    Domain idx_to_ego_crossing_action(const ActionIdx& action) const {
+        // First action indices are for braking starting from zero
+        return action + parameters_.MIN_VELOCITY_EGO;
+    }
+
+    typedef Domain ActionType;
+
+private:
+    struct Shared {
+        Shared(const HypothesisSetSPtr<Domain>& hypothesis_set, const std::size_t& num_other_agents) :
+                    hypothesis(hypothesis_set), other_agent_idx(num_other_agents) {
+            std::iota(other_agent_idx.begin(), other_agent_idx.end(), 1); // start from 1 since 0 is ego agent
+        }
+        HypothesisSetSPtr<Domain> hypothesis;
+        AgentIdxVector other_agent_idx;
+    };
+
+    enum Flags : std::uint8_t {
+        TERMINAL = 1,
+        GOAL_REACHED = 2,
+        COLLIDED = 4
+    };
+
+    struct Uninitialized {};
+
+    // Shares everything but the agent data, which is filled by execute()
+    CompactCrossingState(const CompactCrossingState& other, Uninitialized) :
+                            HypothesisStateInterface<CompactCrossingState<Domain>>(other.current_agents_hypothesis_),
+                            shared_(other.shared_),
+                            flags_(0),
+                            parameters_(other.parameters_) {}
+
+    // Actions of the other agents are bit cast to action indices, interning is not supported. Positions up to the
+    // chain length and all velocities must be representable by the storage type, positions beyond saturate.
+    static void check_parameters(const CrossingStateParameters<Domain>& parameters, const std::size_t& num_other_agents) {
+        if(parameters.INTERN_OTHER_ACTIONS) {
+            throw std::invalid_argument("CompactCrossingState does not support INTERN_OTHER_ACTIONS");
+        }
+        if(num_other_agents + 1 > MAX_NUM_AGENTS) {
+            throw std::invalid_argument("CompactCrossingState supports at most " + std::to_string(MAX_NUM_AGENTS - 1) +
+                                        " other agents, got " + std::to_string(num_other_agents));
+        }
+        for (const Domain& value : {parameters.CHAIN_LENGTH, parameters.MIN_VELOCITY_EGO, parameters.MAX_VELOCITY_EGO,
+                                    parameters.MIN_VELOCITY_OTHER, parameters.MAX_VELOCITY_OTHER}) {
+            if(value < std::numeric_limits<Storage>::lowest() || value > std::numeric_limits<Storage>::max()) {
+                throw std::invalid_argument("CHAIN_LENGTH and velocities of CompactCrossingState must fit the storage type");
+            }
+        }
+    }
+
+    static std::uint8_t pack_flags(const bool& terminal, const bool& goal_reached, const bool& collided) {
+        return (terminal ? TERMINAL : 0) | (goal_reached ? GOAL_REACHED : 0) | (collided ? COLLIDED : 0);
+    }
+
+    static Storage narrow(const Domain& value) {
+        // saturate instead of wrapping around for positions far beyond the chain
+        return static_cast<Storage>(std::max<Domain>(std::min<Domain>(value, std::numeric_limits<Storage>::max()),
+                                                     std::numeric_limits<Storage>::lowest()));
+    }
+
+    void set_agent_state(const AgentIdx& agent_idx, const AgentState<Domain>& state) {
+        positions()[agent_idx] = narrow(state.x_pos);
+        last_actions()[agent_idx] = narrow(state.last_action);
+    }
+
+    inline AgentIdx num_agents() const { return shared_->other_agent_idx.size() + 1; }
+    inline Storage* positions() { return data_.data(); }
+    inline const Storage* positions() const { return data_.data(); }
+    inline Storage* last_actions() { return data_.data() + MAX_NUM_AGENTS; }
+    inline const Storage* last_actions() const { return data_.data() + MAX_NUM_AGENTS; }
+
+    std::shared_ptr<const Shared> shared_; // hypothesis set and agent indices, shared across all states of a tree
+    std::array<Storage, 2*MAX_NUM_AGENTS> data_; // positions of all agents followed by their last actions, no heap allocation
+    std::uint8_t flags_;
+
+    const CrossingStateParameters<Domain>& parameters_;
+};
+
+template <typename Domain>
+constexpr std::size_t CompactCrossingState<Domain>::MAX_NUM_AGENTS;
+
+} // namespace mcts
+
+#endif //COMPACT_CROSSING_STATE_H
@@ -10,7 +10,12 @@
 #include <iostream>
 #include <random>
 #include <unordered_map>
+#include <stdexcept>
+#include <string>
 #include "mcts/hypothesis/hypothesis_state.h"
+#include "mcts/action_interning.h"
+#include "mcts/memory_footprint.h"
+#include "mcts/search_recorder.h"
 
 #include "environments/viewer.h"
 #include "environments/crossing_state_common.h"
@@ -27,8 +32,9 @@ public:
     CrossingState(const std::unordered_map<AgentIdx, HypothesisId>& current_agents_hypothesis,
                   const CrossingStateParameters<Domain>& parameters) :
                             HypothesisStateInterface<CrossingState<Domain>>(current_agents_hypothesis),
-                            hypothesis_(),
+                            hypothesis_(std::make_shared<const HypothesisSet<Domain>>()),
                             other_agent_states_(parameters.NUM_OTHER_AGENTS),
+                            other_agent_idx_(make_other_agent_idx(parameters.NUM_OTHER_AGENTS)),
                             ego_state_(),
                             terminal_(false),
                             goal_reached_(false),
@@ -39,6 +45,13 @@ public:
                                 }
                             }
 
+    CrossingState(const std::unordered_map<AgentIdx, HypothesisId>& current_agents_hypothesis,
+                  const CrossingStateParameters<Domain>& parameters,
+                  const HypothesisSetSPtr<Domain>& hypothesis) :
+                            CrossingState(current_agents_hypothesis, parameters) {
+                                hypothesis_ = hypothesis;
+                            }
+
     CrossingState(const std::unordered_map<AgentIdx, HypothesisId>& current_agents_hypothesis,
                   const CrossingStateParameters<Domain>& parameters,
                   const std::vector<AgentState<Domain>>& other_agent_states,
@@ -46,11 +59,14 @@ public:
                   const bool& terminal,
                   const bool& goal_reached,
                   const bool& collided,
-                  const std::vector<AgentPolicyCrossingState<Domain>>& hypothesis
+                  const HypothesisSetSPtr<Domain>& hypothesis,
+                  const std::shared_ptr<const AgentIdxVector>& other_agent_idx = nullptr
                   ) : 
                             HypothesisStateInterface<CrossingState>(current_agents_hypothesis),
                             hypothesis_(hypothesis),
                             other_agent_states_(other_agent_states),
+                            other_agent_idx_(other_agent_idx ? other_agent_idx :
+                                                make_other_agent_idx(other_agent_states.size())),
                             ego_state_(ego_state),
                             terminal_(terminal),
                             goal_reached_(goal_reached),
@@ -63,18 +79,59 @@ public:
         return std::make_shared<CrossingState>(*this);
     }
 
-    ActionIdx plan_action_current_hypothesis(const AgentIdx& agent_idx) const {
+    std::shared_ptr<CrossingState> clone_with_hypothesis(const std::unordered_map<AgentIdx, HypothesisId>& current_agents_hypothesis) const
+    {
+        return std::make_shared<CrossingState>(current_agents_hypothesis, parameters_, other_agent_states_, ego_state_,
+                                               terminal_, goal_reached_, collided_,
+                                               hypothesis_, other_agent_idx_);
+    }
+
+    ActionIdx plan_action_current_hypothesis(const AgentIdx& agent_idx, Philox4x32& random_generator) const {
         const HypothesisId agt_hyp_id = this->current_agents_hypothesis_.at(agent_idx);
-        return aconv(hypothesis_.at(agt_hyp_id).act(other_agent_states_[agent_idx-1],
-                                                    ego_state_));
+        return get_action_idx(agent_idx, hypothesis_->at(agt_hyp_id).act(other_agent_states_[agent_idx-1],
+                                                    ego_state_, random_generator));
     };
 
+    // Heap bytes of the agent states and interned actions, the hypothesis set is shared and not counted
+    std::size_t get_memory_footprint() const {
+        std::size_t bytes = heap_bytes(other_agent_states_) + heap_bytes(other_action_interning_);
+        for (const auto& interning : other_action_interning_) {
+            bytes += heap_bytes(interning.get_actions());
+        }
+        return bytes;
+    }
+
+    // Interned action indices of the other agents are only valid if sampled from this state
+    bool requires_sampled_other_actions() const { return parameters_.INTERN_OTHER_ACTIONS; }
+
+    // Action index of another agent's action in joint actions executed by this state
+    ActionIdx get_action_idx(const AgentIdx& agent_idx, const Domain& action) const {
+        if(!parameters_.INTERN_OTHER_ACTIONS) {
+            return aconv(action);
+        }
+        return action_interning(agent_idx).intern(action);
+    }
+
+    // Action of another agent represented by an action index of this state. With interning, indices must stem from
+    // this state, e.g. sampled by HypothesisStatistic, Mcts thus rejects statistics enumerating raw indices at search start.
+    Domain get_action(const AgentIdx& agent_idx, const ActionIdx& action_idx) const {
+        if(!parameters_.INTERN_OTHER_ACTIONS) {
+            return aconv<Domain>(action_idx);
+        }
+        if(action_idx >= action_interning(agent_idx).size()) {
+            throw std::invalid_argument("Action index " + std::to_string(action_idx) + " of agent " + std::to_string(agent_idx) +
+                                        " was not interned by this state, INTERN_OTHER_ACTIONS requires statistics " +
+                                        "sampling the other agents' actions from this state");
+        }
+        return action_interning(agent_idx).get_action(action_idx);
+    }
+
     template<typename ActionType = Domain>
     Probability get_probability(const HypothesisId& hypothesis, const AgentIdx& agent_idx, const Domain& action) const { 
         if (agent_idx == this->ego_agent_idx) {
-            return hypothesis_.at(hypothesis).get_probability(ego_state_, ego_state_, action);
+            return hypothesis_->at(hypothesis).get_probability(ego_state_, ego_state_, action);
         } else {
-            return hypothesis_.at(hypothesis).get_probability(other_agent_states_[agent_idx-1], ego_state_, action);
+            return hypothesis_->at(hypothesis).get_probability(other_agent_states_[agent_idx-1], ego_state_, action);
         }
     }
 
@@ -89,7 +146,7 @@ public:
 
     Probability get_prior(const HypothesisId& hypothesis, const AgentIdx& agent_idx) const { return 0.5f;}
 
-    HypothesisId get_num_hypothesis(const AgentIdx& agent_idx) const {return hypothesis_.size();}
+    HypothesisId get_num_hypothesis(const AgentIdx& agent_idx) const {return hypothesis_->size();}
 
     std::shared_ptr<CrossingState<Domain>> execute(const JointAction& joint_action, std::vector<Reward>& rewards, Cost& ego_cost) const {
         // normally we map each single action value in joint action with a map to the floating point action. Here, not required
@@ -106,8 +163,9 @@ public:
         bool collision = false;
         for(size_t i = 0; i < other_agent_states_.size(); ++i) {
             const auto& old_state = other_agent_states_[i];
-            auto new_x = old_state.x_pos + static_cast<Domain>(aconv<Domain>(joint_action[i+1]));
-            next_other_agent_states[i] = AgentState<Domain>( (new_x>= 0) ? new_x : 0, aconv<Domain>(joint_action[i+1]));
+            const Domain action = get_action(i+1, joint_action[i+1]);
+            auto new_x = old_state.x_pos + action;
+            next_other_agent_states[i] = AgentState<Domain>( (new_x>= 0) ? new_x : 0, action);
 
             // if ego state history encloses crossing point and other state history encloses crossing point
             // a collision occurs
@@ -138,12 +196,17 @@ public:
                                                        terminal,
                                                        goal_reached,
                                                        collision,
-                                                       hypothesis_);
+                                                       hypothesis_,
+                                                       other_agent_idx_);
     }
 
     ActionIdx get_num_actions(AgentIdx agent_idx) const {
         if(agent_idx == this->ego_agent_idx) {
             return parameters_.NUM_EGO_ACTIONS();
+        } else if(parameters_.INTERN_OTHER_ACTIONS && parameters_.OTHER_ACTIONS_RESOLUTION > 0) {
+            const auto& resolution = parameters_.OTHER_ACTIONS_RESOLUTION;
+            return static_cast<ActionIdx>(std::round(static_cast<double>(parameters_.MAX_VELOCITY_OTHER) / resolution) -
+                                          std::round(static_cast<double>(parameters_.MIN_VELOCITY_OTHER) / resolution)) + 1;
         } else {
             return parameters_.NUM_OTHER_ACTIONS;
         }
@@ -153,10 +216,8 @@ public:
         return terminal_;
     }
 
-    const std::vector<AgentIdx> get_other_agent_idx() const {
-        std::vector<AgentIdx> agent_idx(other_agent_states_.size());
-        std::iota(agent_idx.begin(), agent_idx.end(), 1); // start from 1 since 0 is ego agent
-        return agent_idx; // adapt to number of agents
+    const AgentIdxVector& get_other_agent_idx() const {
+        return *other_agent_idx_;
     }
 
     const AgentIdx get_ego_agent_idx() const {
@@ -176,12 +237,19 @@ public:
         return ss.str();
     }
 
+    // Copy on write: states already referencing the previous set keep it unchanged
     void add_hypothesis(const AgentPolicyCrossingState<Domain>& hypothesis) {
-        hypothesis_.push_back(hypothesis);
+        auto extended = std::make_shared<HypothesisSet<Domain>>(*hypothesis_);
+        extended->push_back(hypothesis);
+        hypothesis_ = extended;
     }
 
     void clear_hypothesis() {
-        hypothesis_.clear();
+        hypothesis_ = std::make_shared<const HypothesisSet<Domain>>();
+    }
+
+    const HypothesisSetSPtr<Domain>& get_hypothesis_set() const {
+        return hypothesis_;
     }
 
     bool ego_goal_reached() const {
@@ -282,22 +350,149 @@ public:
 
     }
 
+    const CrossingStateParameters<Domain>& get_parameters() const {
+        return parameters_;
+    }
+
     Domain idx_to_ego_crossing_action(const ActionIdx& action) const {
         // First action indices are for braking starting from zero
         return action + parameters_.MIN_VELOCITY_EGO;
     }
 
+    // Parameters, agent states, hypothesis set and the action interning,
+    // the hypothesis map is not saved but bound on loading, e.g. to the current hypothesis of a loaded belief tracker
+    void save(RecordWriter& writer) const {
+        save_parameters(writer, parameters_);
+        writer.write<std::uint64_t>(other_agent_states_.size());
+        for (const auto& state : other_agent_states_) {
+            write_agent_state(writer, state);
+        }
+        write_agent_state(writer, ego_state_);
+        writer.write(terminal_);
+        writer.write(goal_reached_);
+        writer.write(collided_);
+        writer.write<std::uint64_t>(hypothesis_->size());
+        for (const auto& hypothesis : *hypothesis_) {
+            writer.write(hypothesis.get_desired_gap_range());
+        }
+        writer.write<std::uint64_t>(other_action_interning_.size());
+        for (const auto& interning : other_action_interning_) {
+            writer.write(interning.get_actions());
+        }
+    }
+
+    // Counterpart of save, the loaded parameters are stored in parameters which must outlive the state
+    static std::shared_ptr<CrossingState> load(RecordReader& reader,
+                                               const std::unordered_map<AgentIdx, HypothesisId>& current_agents_hypothesis,
+                                               CrossingStateParameters<Domain>& parameters) {
+        parameters = load_parameters(reader);
+        std::vector<AgentState<Domain>> other_agent_states(reader.read<std::uint64_t>());
+        for (auto& state : other_agent_states) {
+            state = read_agent_state(reader);
+        }
+        const auto ego_state = read_agent_state(reader);
+        const auto terminal = reader.read<bool>();
+        const auto goal_reached = reader.read<bool>();
+        const auto collided = reader.read<bool>();
+        HypothesisSet<Domain> hypothesis_set;
+        const auto num_hypothesis = reader.read<std::uint64_t>();
+        for (std::uint64_t hid = 0; hid < num_hypothesis; ++hid) {
+            hypothesis_set.push_back(AgentPolicyCrossingState<Domain>(reader.read<std::pair<Domain, Domain>>(), parameters));
+        }
+        auto state = std::make_shared<CrossingState>(current_agents_hypothesis, parameters, other_agent_states, ego_state,
+                                                     terminal, goal_reached, collided,
+                                                     make_hypothesis_set<Domain>(hypothesis_set));
+        state->other_action_interning_.resize(reader.read<std::uint64_t>(),
+                                              ActionInterning<Domain>(parameters.OTHER_ACTIONS_RESOLUTION));
+        for (auto& interning : state->other_action_interning_) {
+            for (const auto& action : reader.read<std::vector<Domain>>()) {
+                interning.intern(action);
+            }
+        }
+        return state;
+    }
+
     typedef Domain ActionType;
 private:
-    std::vector<AgentPolicyCrossingState<Domain>> hypothesis_;
+    static void save_parameters(RecordWriter& writer, const CrossingStateParameters<Domain>& parameters) {
+        writer.write(parameters.NUM_OTHER_AGENTS);
+        writer.write(parameters.OTHER_AGENTS_POLICY_RANDOM_SEED);
+        writer.write(parameters.COST_ONLY_COLLISION);
+        writer.write(parameters.TABULATE_OTHER_AGENTS_POLICY);
+        writer.write(parameters.MAX_VELOCITY_OTHER);
+        writer.write(parameters.MIN_VELOCITY_OTHER);
+        writer.write(parameters.NUM_OTHER_ACTIONS);
+        writer.write(parameters.INTERN_OTHER_ACTIONS);
+        writer.write(parameters.OTHER_ACTIONS_RESOLUTION);
+        writer.write(parameters.MAX_VELOCITY_EGO);
+        writer.write(parameters.MIN_VELOCITY_EGO);
+        writer.write(parameters.CHAIN_LENGTH);
+        writer.write(parameters.EGO_GOAL_POS);
+        writer.write(parameters.REWARD_COLLISION);
+        writer.write(parameters.REWARD_GOAL_REACHED);
+        writer.write(parameters.REWARD_STEP);
+    }
+
+    static CrossingStateParameters<Domain> load_parameters(RecordReader& reader) {
+        CrossingStateParameters<Domain> parameters;
+        reader.read(parameters.NUM_OTHER_AGENTS);
+        reader.read(parameters.OTHER_AGENTS_POLICY_RANDOM_SEED);
+        reader.read(parameters.COST_ONLY_COLLISION);
+        reader.read(parameters.TABULATE_OTHER_AGENTS_POLICY);
+        reader.read(parameters.MAX_VELOCITY_OTHER);
+        reader.read(parameters.MIN_VELOCITY_OTHER);
+        reader.read(parameters.NUM_OTHER_ACTIONS);
+        reader.read(parameters.INTERN_OTHER_ACTIONS);
+        reader.read(parameters.OTHER_ACTIONS_RESOLUTION);
+        reader.read(parameters.MAX_VELOCITY_EGO);
+        reader.read(parameters.MIN_VELOCITY_EGO);
+        reader.read(parameters.CHAIN_LENGTH);
+        reader.read(parameters.EGO_GOAL_POS);
+        reader.read(parameters.REWARD_COLLISION);
+        reader.read(parameters.REWARD_GOAL_REACHED);
+        reader.read(parameters.REWARD_STEP);
+        return parameters;
+    }
+
+    static void write_agent_state(RecordWriter& writer, const AgentState<Domain>& state) {
+        writer.write(state.x_pos);
+        writer.write(state.last_action);
+    }
+
+    static AgentState<Domain> read_agent_state(RecordReader& reader) {
+        AgentState<Domain> state;
+        reader.read(state.x_pos);
+        reader.read(state.last_action);
+        return state;
+    }
+
+    static std::shared_ptr<const AgentIdxVector> make_other_agent_idx(const std::size_t& num_other_agents) {
+        auto agent_idx = std::make_shared<AgentIdxVector>(num_other_agents);
+        std::iota(agent_idx->begin(), agent_idx->end(), 1); // start from 1 since 0 is ego agent
+        return agent_idx;
+    }
+
+    ActionInterning<Domain>& action_interning(const AgentIdx& agent_idx) const {
+        if(other_action_interning_.empty()) {
+            other_action_interning_.resize(other_agent_states_.size(),
+                                           ActionInterning<Domain>(parameters_.OTHER_ACTIONS_RESOLUTION));
+        }
+        return other_action_interning_[agent_idx-1];
+    }
+
+    HypothesisSetSPtr<Domain> hypothesis_; // immutable, shared across all states and concurrent searches, never copied per state
 
     std::vector<AgentState<Domain>> other_agent_states_;
+    std::shared_ptr<const AgentIdxVector> other_agent_idx_; // computed once at the root and passed on to child states
     AgentState<Domain> ego_state_;
     const bool terminal_;
     const bool goal_reached_;
     const bool collided_;
 
     const CrossingStateParameters<Domain>& parameters_;
+
+    // Dense action indices of the other agents' actions sampled or executed in this state, filled on demand
+    mutable std::vector<ActionInterning<Domain>> other_action_interning_;
 };
 
 } // namespace mcts
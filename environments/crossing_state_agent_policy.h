@@ -8,9 +8,12 @@
 #ifndef MCTS_CROSSING_STATE_AGENT_POLICY_H_
 #define MCTS_CROSSING_STATE_AGENT_POLICY_H_
 
+#include <algorithm>
 #include <iostream>
 #include <random>
 #include <unordered_map>
+#include <memory>
+#include <vector>
 #include "mcts/random_generator.h"
 #include "environments/crossing_state_common.h"
 
@@ -18,40 +21,41 @@
 namespace mcts {
 
 template <typename Domain>
-class AgentPolicyCrossingState : public RandomGenerator {
+class AgentPolicyCrossingState {
   public:
     AgentPolicyCrossingState(const std::pair<Domain, Domain>& desired_gap_range,
                             const CrossingStateParameters<Domain>& parameters) : 
-                            RandomGenerator(parameters.OTHER_AGENTS_POLICY_RANDOM_SEED),
                             desired_gap_range_(desired_gap_range),
-                            parameters_(parameters) {
+                            parameters_(parameters),
+                            table_() {
                                 MCTS_EXPECT_TRUE(desired_gap_range.first <= desired_gap_range.second);
+                                if(parameters.TABULATE_OTHER_AGENTS_POLICY) {
+                                  tabulate();
+                                }
                             }
 
-    Domain act(const AgentState<Domain>& agent_state, const AgentState<Domain>& ego_state) const;
+    // Samples a desired gap from the caller's random generator, the policy itself is immutable
+    // and shared by concurrent searches
+    Domain act(const AgentState<Domain>& agent_state, const AgentState<Domain>& ego_state, Philox4x32& random_generator) const;
 
     Probability get_probability(const AgentState<Domain>& agent_state, const AgentState<Domain>& ego_state, const Domain& action) const;
 
     Domain calculate_action(const AgentState<Domain>& agent_state, const AgentState<Domain> ego_state, const Domain& desired_gap_dst) const {
-        // If past crossing point, use last execute action
-        if(agent_state.x_pos < parameters_.CROSSING_POINT() ) {
-            // use a forward predicted ego state based on the last action
-            const auto gap_error = ego_state.x_pos + ego_state.last_action - agent_state.x_pos - desired_gap_dst;
-            // gap_error < 0 -> brake to increase distance
-            if (desired_gap_dst > 0) {
-                if(gap_error < 0) {
-                    return std::max(gap_error, parameters_.MIN_VELOCITY_OTHER);
-                } else {
-                    return std::min(gap_error, parameters_.MAX_VELOCITY_OTHER);
-                }
-            } else {
-                // Dont brake again if agents is already ahead of ego agent, but continue with same velocity
-                return std::max(std::min(gap_error, parameters_.MAX_VELOCITY_OTHER), agent_state.last_action);
-            }
-        } else {
-            return agent_state.last_action;
-        }
+        // If past crossing point, use last execute action, before use a forward predicted ego state based on the last action
+        return other_agent_policy_action(agent_state.x_pos, agent_state.last_action, ego_state.x_pos + ego_state.last_action,
+                                         desired_gap_dst, parameters_.CROSSING_POINT(),
+                                         parameters_.MIN_VELOCITY_OTHER, parameters_.MAX_VELOCITY_OTHER);
+    }
+
+    Domain calculate_action_from_gap_error(const Domain& gap_error, const Domain& last_action, const Domain& desired_gap_dst) const {
+        return other_agent_gap_action(gap_error, last_action, desired_gap_dst,
+                                      parameters_.MIN_VELOCITY_OTHER, parameters_.MAX_VELOCITY_OTHER);
+    }
+
+    bool is_tabulated() const { return static_cast<bool>(table_); }
 
+    const std::pair<Domain, Domain>& get_desired_gap_range() const {
+      return desired_gap_range_;
     }
 
     std::string info() const {
@@ -61,24 +65,103 @@ class AgentPolicyCrossingState : public RandomGenerator {
     }
 
   private: 
+        // Before the crossing point the policy depends on the agent and ego state only by the predicted
+        // distance ego.x_pos + ego.last_action - agent.x_pos and the last action of the agent. Outside of
+        // [min_distance, max_distance] all min and max operations saturate, such that distances are clamped.
+        struct PolicyTable {
+          Domain min_distance;
+          Domain max_distance;
+          std::size_t num_last_actions;
+          std::size_t num_gaps;
+          std::size_t num_actions;
+          std::vector<Domain> actions; // [distance][last_action][desired_gap]
+          std::vector<Probability> probabilities; // [distance][last_action][action]
+        };
+
+        void tabulate();
+
+        // Returns the table row of a state pair before the crossing point, -1 if the last action is not covered
+        long table_row(const AgentState<Domain>& agent_state, const AgentState<Domain>& ego_state) const {
+          if(agent_state.last_action < parameters_.MIN_VELOCITY_OTHER ||
+             agent_state.last_action > parameters_.MAX_VELOCITY_OTHER) {
+            return -1;
+          }
+          const Domain distance = std::min(std::max(ego_state.x_pos + ego_state.last_action - agent_state.x_pos,
+                                                    table_->min_distance), table_->max_distance);
+          return static_cast<long>(distance - table_->min_distance) * table_->num_last_actions +
+                     static_cast<long>(agent_state.last_action - parameters_.MIN_VELOCITY_OTHER);
+        }
+
         const std::pair<Domain, Domain> desired_gap_range_;
         const CrossingStateParameters<Domain>& parameters_;
+        // Shared between copies of the policy, e.g. hypothesis sets and true agent policies
+        std::shared_ptr<const PolicyTable> table_;
 };
 
 template <>
-inline int AgentPolicyCrossingState<int>::act(const AgentState<int>& agent_state, const AgentState<int>& ego_state) const {
+inline void AgentPolicyCrossingState<int>::tabulate() {
+    auto table = std::make_shared<PolicyTable>();
+    table->min_distance = std::min(parameters_.MIN_VELOCITY_OTHER, 0) - 1 + desired_gap_range_.first;
+    table->max_distance = std::max(parameters_.MAX_VELOCITY_OTHER, 0) + 1 + desired_gap_range_.second;
+    table->num_last_actions = parameters_.MAX_VELOCITY_OTHER - parameters_.MIN_VELOCITY_OTHER + 1;
+    table->num_gaps = desired_gap_range_.second - desired_gap_range_.first + 1;
+    table->num_actions = table->num_last_actions;
+    const std::size_t num_rows = (table->max_distance - table->min_distance + 1) * table->num_last_actions;
+    table->actions.resize(num_rows * table->num_gaps);
+    table->probabilities.resize(num_rows * table->num_actions);
+
+    std::vector<unsigned int> action_selected(table->num_actions);
+    std::size_t row = 0;
+    for(int distance = table->min_distance; distance <= table->max_distance; ++distance) {
+        for(int last_action = parameters_.MIN_VELOCITY_OTHER; last_action <= parameters_.MAX_VELOCITY_OTHER; ++last_action) {
+            std::fill(action_selected.begin(), action_selected.end(), 0);
+            for(std::size_t gap_idx = 0; gap_idx < table->num_gaps; ++gap_idx) {
+                const int desired_gap_dst = desired_gap_range_.first + static_cast<int>(gap_idx);
+                const int action = calculate_action_from_gap_error(distance - desired_gap_dst, last_action, desired_gap_dst);
+                if(action < parameters_.MIN_VELOCITY_OTHER || action > parameters_.MAX_VELOCITY_OTHER) {
+                    // velocity bounds do not enclose zero, keep the closed form
+                    return;
+                }
+                table->actions[row * table->num_gaps + gap_idx] = action;
+                action_selected[action - parameters_.MIN_VELOCITY_OTHER]++;
+            }
+            for(std::size_t action_idx = 0; action_idx < table->num_actions; ++action_idx) {
+                table->probabilities[row * table->num_actions + action_idx] =
+                      static_cast<float>(action_selected[action_idx])/static_cast<float>(table->num_gaps);
+            }
+            ++row;
+        }
+    }
+    table_ = table;
+}
+
+template <>
+inline void AgentPolicyCrossingState<float>::tabulate() {
+    // Continuous desired gaps and actions, the closed form probability is used
+}
+
+template <>
+inline int AgentPolicyCrossingState<int>::act(const AgentState<int>& agent_state, const AgentState<int>& ego_state,
+                                              Philox4x32& random_generator) const {
     // sample desired gap parameter
     std::uniform_int_distribution<int> dis(desired_gap_range_.first, desired_gap_range_.second);
-    int desired_gap_dst = dis(this->random_generator_);
+    int desired_gap_dst = dis(random_generator);
 
+    if(table_ && agent_state.x_pos < parameters_.CROSSING_POINT()) {
+        const auto row = table_row(agent_state, ego_state);
+        if(row >= 0) {
+            return table_->actions[row * table_->num_gaps + (desired_gap_dst - desired_gap_range_.first)];
+        }
+    }
     return calculate_action(agent_state, ego_state, desired_gap_dst);
 }
 
 template <>
-inline float AgentPolicyCrossingState<float>::act(const AgentState<float>& agent_state, const AgentState<float>& ego_state) const {
+inline float AgentPolicyCrossingState<float>::act(const AgentState<float>& agent_state, const AgentState<float>& ego_state,
+                                                  Philox4x32& random_generator) const {
     // sample desired gap parameter
     std::uniform_real_distribution<float> dis(desired_gap_range_.first, desired_gap_range_.second);
-    float desired_gap_dst = dis(this->random_generator_);
+    float desired_gap_dst = dis(random_generator);
 
     return calculate_action(agent_state, ego_state, desired_gap_dst);
 }
@@ -86,6 +169,18 @@ inline float AgentPolicyCrossingState<float>::act(const AgentState<float>& agent
 
 template <>
 inline Probability AgentPolicyCrossingState<int>::get_probability(const AgentState<int>& agent_state, const AgentState<int>& ego_state, const int& action) const {
+    if(table_) {
+        if(agent_state.x_pos >= parameters_.CROSSING_POINT()) {
+            return action == agent_state.last_action ? 1.0f : 0.0f;
+        }
+        const auto row = table_row(agent_state, ego_state);
+        if(row >= 0) {
+            if(action < parameters_.MIN_VELOCITY_OTHER || action > parameters_.MAX_VELOCITY_OTHER) {
+                return 0.0f;
+            }
+            return table_->probabilities[row * table_->num_actions + (action - parameters_.MIN_VELOCITY_OTHER)];
+        }
+    }
     std::vector<int> gap_distances(desired_gap_range_.second - desired_gap_range_.first+1);
     std::iota(gap_distances.begin(), gap_distances.end(),desired_gap_range_.first);
     unsigned int action_selected = 0;
@@ -244,6 +339,18 @@ inline Probability AgentPolicyCrossingState<float>::get_probability(const AgentS
     }
 }
 
+// The hypothesis set is immutable and shared by all states of a tree and by concurrent searches
+template <typename Domain>
+using HypothesisSet = std::vector<AgentPolicyCrossingState<Domain>>;
+
+template <typename Domain>
+using HypothesisSetSPtr = std::shared_ptr<const HypothesisSet<Domain>>;
+
+template <typename Domain>
+inline HypothesisSetSPtr<Domain> make_hypothesis_set(const HypothesisSet<Domain>& hypothesis) {
+    return std::make_shared<const HypothesisSet<Domain>>(hypothesis);
+}
+
 } // namespace mcts
 
 #endif // MCTS_CROSSING_STATE_AGENT_POLICY_H_
\ No newline at end of file
@@ -0,0 +1,142 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef MCTS_CROSSING_STATE_BATCH_HEURISTIC_H_
+#define MCTS_CROSSING_STATE_BATCH_HEURISTIC_H_
+
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "mcts/mcts.h"
+#include "environments/crossing_state_batch_simulator.h"
+
+namespace mcts {
+
+// Estimates the value of a crossing state leaf by the mean return of BATCH_SIZE random rollouts,
+// which are simulated together with CrossingStateBatchSimulator. Rollouts follow the same policies
+// and termination criteria as RandomHeuristic with UctStatistic (ego) and HypothesisStatistic (others).
+// Several leaves can be evaluated in one call, their rollouts then share the simulator's lanes.
+template <typename Domain>
+class CrossingStateBatchHeuristic :  public mcts::Heuristic<CrossingStateBatchHeuristic<Domain>>, public mcts::RandomGenerator
+{
+public:
+    CrossingStateBatchHeuristic(const MctsParameters& mcts_parameters) :
+            mcts::Heuristic<CrossingStateBatchHeuristic<Domain>>(mcts_parameters),
+            RandomGenerator(mcts_parameters.RANDOM_SEED, random_stream(mcts_parameters.THREAD_IDX, 0)),
+            simulator_(),
+            leaf_max_steps_() {}
+
+    // The simulator only holds the lanes of the last call, a copy creates its own
+    CrossingStateBatchHeuristic(const CrossingStateBatchHeuristic& other) :
+            mcts::Heuristic<CrossingStateBatchHeuristic<Domain>>(other),
+            RandomGenerator(other),
+            simulator_(),
+            leaf_max_steps_() {}
+
+    template<class S, class SE, class SO, class H>
+    std::pair<SE, std::unordered_map<AgentIdx, SO>> calculate_heuristic_values(const std::shared_ptr<StageNode<S,SE,SO,H>> &node) {
+        rollout(&node, &node + 1);
+        return heuristic_values<SE, SO>(*node->get_state(), 0);
+    }
+
+    template<class S, class SE, class SO, class H>
+    std::vector<std::pair<SE, std::unordered_map<AgentIdx, SO>>> calculate_heuristic_values(
+                                                    const std::vector<std::shared_ptr<StageNode<S,SE,SO,H>>> &nodes) {
+        std::vector<std::pair<SE, std::unordered_map<AgentIdx, SO>>> heuristic_values_per_node;
+        if(nodes.empty()) {
+            return heuristic_values_per_node;
+        }
+        rollout(nodes.data(), nodes.data() + nodes.size());
+        heuristic_values_per_node.reserve(nodes.size());
+        for (std::size_t leaf = 0; leaf < nodes.size(); ++leaf) {
+            heuristic_values_per_node.push_back(heuristic_values<SE, SO>(*nodes[leaf]->get_state(), leaf));
+        }
+        return heuristic_values_per_node;
+    }
+
+private:
+    // Simulates BATCH_SIZE lanes for each leaf in [first, last), leaf i owns the lanes [i*BATCH_SIZE, (i+1)*BATCH_SIZE)
+    template<class NodeSPtr>
+    void rollout(const NodeSPtr* first, const NodeSPtr* last) {
+        const std::size_t batch_size = this->mcts_parameters_.batch_rollout_heuristic.BATCH_SIZE;
+        const std::size_t num_leaves = last - first;
+        const auto& first_state = *(*first)->get_state();
+        if(!simulator_ || &simulator_->get_parameters() != &first_state.get_parameters() ||
+              simulator_->get_num_other_agents() != first_state.get_other_agent_idx().size()) {
+            simulator_.reset(new CrossingStateBatchSimulator<Domain>(first_state.get_parameters(),
+                                              first_state.get_other_agent_idx().size(), batch_size*num_leaves, 0));
+        }
+        simulator_->set_batch_size(batch_size*num_leaves, random_generator_());
+        leaf_max_steps_.resize(num_leaves);
+        for (std::size_t leaf = 0; leaf < num_leaves; ++leaf) {
+            const auto& node = first[leaf];
+            for (std::size_t lane = leaf*batch_size; lane < (leaf+1)*batch_size; ++lane) {
+                simulator_->set_episode(lane, *node->get_state());
+            }
+            // Rollouts continue up to the maximum search depth
+            const unsigned int max_depth = this->mcts_parameters_.MAX_SEARCH_DEPTH;
+            leaf_max_steps_[leaf] = node->get_depth() <= max_depth ? max_depth - node->get_depth() + 1 : 0;
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        const double k_discount_factor = this->mcts_parameters_.DISCOUNT_FACTOR;
+        double modified_discount_factor = k_discount_factor;
+        unsigned int num_iterations = 0;
+        std::size_t num_alive = simulator_->num_alive();
+        while(num_alive > 0 && num_iterations < this->mcts_parameters_.random_heuristic.MAX_NUMBER_OF_ITERATIONS &&
+                (std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::high_resolution_clock::now() - start ).count()
+                    < this->mcts_parameters_.random_heuristic.MAX_SEARCH_TIME )) {
+            // Leaves deeper in the tree reach the maximum search depth earlier
+            bool stopped = false;
+            for (std::size_t leaf = 0; leaf < num_leaves; ++leaf) {
+                if(leaf_max_steps_[leaf] == num_iterations) {
+                    for (std::size_t lane = leaf*batch_size; lane < (leaf+1)*batch_size; ++lane) {
+                        simulator_->stop(lane);
+                    }
+                    stopped = true;
+                }
+            }
+            if(stopped && simulator_->num_alive() == 0) {
+                break;
+            }
+            num_alive = simulator_->step(modified_discount_factor);
+            modified_discount_factor = modified_discount_factor*k_discount_factor;
+            num_iterations += 1;
+        }
+    }
+
+    template<class SE, class SO, class S>
+    std::pair<SE, std::unordered_map<AgentIdx, SO>> heuristic_values(const S& state, const std::size_t& leaf) const {
+        const std::size_t batch_size = this->mcts_parameters_.batch_rollout_heuristic.BATCH_SIZE;
+        Reward ego_mean_reward = 0.0f;
+        Cost mean_cost = 0.0f;
+        for (std::size_t lane = leaf*batch_size; lane < (leaf+1)*batch_size; ++lane) {
+            ego_mean_reward += simulator_->get_accum_rewards()[lane];
+            mean_cost += simulator_->get_accum_costs()[lane];
+        }
+        ego_mean_reward /= batch_size;
+        mean_cost /= batch_size;
+
+        // generate an extra node statistic for each agent, other agents receive no rewards in crossing states
+        SE ego_heuristic(0, state.get_ego_agent_idx(), this->mcts_parameters_);
+        ego_heuristic.set_heuristic_estimate(ego_mean_reward, mean_cost);
+        std::unordered_map<AgentIdx, SO> other_heuristic_estimates;
+        for (const auto& agent_idx : state.get_other_agent_idx())
+        {
+            SO statistic(0, agent_idx, this->mcts_parameters_);
+            statistic.set_heuristic_estimate(0.0f, mean_cost);
+            other_heuristic_estimates.insert(std::pair<AgentIdx, SO>(agent_idx, statistic));
+        }
+        return std::pair<SE, std::unordered_map<AgentIdx, SO>>(ego_heuristic, other_heuristic_estimates);
+    }
+
+    std::unique_ptr<CrossingStateBatchSimulator<Domain>> simulator_;
+    std::vector<unsigned int> leaf_max_steps_; // rollout steps until a leaf's lanes reach the maximum search depth
+};
+
+} // namespace mcts
+
+#endif // MCTS_CROSSING_STATE_BATCH_HEURISTIC_H_
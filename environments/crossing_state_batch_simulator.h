@@ -0,0 +1,236 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef MCTS_CROSSING_STATE_BATCH_SIMULATOR_H_
+#define MCTS_CROSSING_STATE_BATCH_SIMULATOR_H_
+
+#include <cstdint>
+#include <vector>
+#include "mcts/state.h"
+#include "environments/crossing_state_common.h"
+#include "environments/crossing_state_parameters.h"
+
+namespace mcts {
+
+// Simulates a batch of independent crossing episodes in lockstep.
+// Every quantity is stored as one array over the batch (lanes) so that the inner loops
+// are branch-free and vectorized by the compiler. The ego agent acts uniformly random,
+// the other agents follow AgentPolicyCrossingState with a per-lane desired gap range.
+template <typename Domain>
+class CrossingStateBatchSimulator {
+  public:
+    CrossingStateBatchSimulator(const CrossingStateParameters<Domain>& parameters,
+                                const std::size_t& num_other_agents,
+                                const std::size_t& batch_size,
+                                const std::uint32_t& random_seed) :
+                      parameters_(parameters),
+                      num_other_agents_(num_other_agents),
+                      batch_size_(batch_size),
+                      ego_x_(batch_size), ego_last_action_(batch_size),
+                      other_x_(batch_size*num_other_agents), other_last_action_(batch_size*num_other_agents),
+                      gap_min_(batch_size*num_other_agents), gap_max_(batch_size*num_other_agents),
+                      alive_(batch_size, 0),
+                      accum_rewards_(batch_size, 0.0), accum_costs_(batch_size, 0.0),
+                      rng_(batch_size),
+                      ego_action_(batch_size), next_ego_x_(batch_size),
+                      ego_crosses_(batch_size), collision_(batch_size) {
+                        seed(random_seed);
+                      }
+
+    void seed(const std::uint32_t& random_seed) {
+      // splitmix32 to decorrelate the xorshift states of neighbouring lanes, zero is not a valid state
+      std::uint32_t z = random_seed;
+      for (auto& state : rng_) {
+        z += 0x9e3779b9u;
+        std::uint32_t x = z;
+        x = (x ^ (x >> 16)) * 0x85ebca6bu;
+        x = (x ^ (x >> 13)) * 0xc2b2ae35u;
+        state = (x ^ (x >> 16)) | 1u;
+      }
+    }
+
+    // Changes the number of lanes and reseeds them, all lanes must be initialized with set_episode afterwards.
+    // Keeps the allocated arrays if they are large enough.
+    void set_batch_size(const std::size_t& batch_size, const std::uint32_t& random_seed) {
+      batch_size_ = batch_size;
+      for (auto* lane_data : {&ego_x_, &ego_last_action_, &ego_action_, &next_ego_x_}) {
+        lane_data->resize(batch_size);
+      }
+      for (auto* agent_lane_data : {&other_x_, &other_last_action_, &gap_min_, &gap_max_}) {
+        agent_lane_data->resize(batch_size*num_other_agents_);
+      }
+      for (auto* lane_flags : {&alive_, &ego_crosses_, &collision_}) {
+        lane_flags->resize(batch_size);
+      }
+      accum_rewards_.resize(batch_size);
+      accum_costs_.resize(batch_size);
+      rng_.resize(batch_size);
+      seed(random_seed);
+    }
+
+    // Initializes a lane from a crossing state and the current hypothesis of each other agent
+    template <typename S>
+    void set_episode(const std::size_t& lane, const S& state) {
+      MCTS_EXPECT_TRUE(state.get_other_agent_idx().size() == num_other_agents_);
+      const auto ego_state = state.get_ego_state();
+      ego_x_[lane] = ego_state.x_pos;
+      ego_last_action_[lane] = ego_state.last_action;
+      const auto& hypothesis_set = *state.get_hypothesis_set();
+      for (const auto& agent_idx : state.get_other_agent_idx()) {
+        const std::size_t idx = (agent_idx-1)*batch_size_ + lane;
+        const auto agent_state = state.get_agent_state(agent_idx);
+        other_x_[idx] = agent_state.x_pos;
+        other_last_action_[idx] = agent_state.last_action;
+        const auto& gap_range = hypothesis_set.at(state.get_current_hypothesis(agent_idx)).get_desired_gap_range();
+        gap_min_[idx] = gap_range.first;
+        gap_max_[idx] = gap_range.second;
+      }
+      alive_[lane] = !state.is_terminal();
+      accum_rewards_[lane] = 0.0;
+      accum_costs_[lane] = 0.0;
+    }
+
+    // Advances all lanes by one step, rewards and costs of alive lanes are accumulated with the given discount.
+    // Returns the number of lanes still alive afterwards.
+    std::size_t step(const double& discount) {
+      const Domain crossing_point = parameters_.CROSSING_POINT();
+      const Domain min_velocity_other = parameters_.MIN_VELOCITY_OTHER;
+      const Domain max_velocity_other = parameters_.MAX_VELOCITY_OTHER;
+      const std::uint32_t num_ego_actions = parameters_.NUM_EGO_ACTIONS();
+      const std::size_t B = batch_size_;
+
+      // Ego: uniformly random action as in a rollout with a fresh ego statistic
+      for (std::size_t b = 0; b < B; ++b) {
+        const std::uint32_t r = next_random(rng_[b]);
+        ego_action_[b] = static_cast<Domain>((static_cast<std::uint64_t>(r) * num_ego_actions) >> 32)
+                          + parameters_.MIN_VELOCITY_EGO;
+        next_ego_x_[b] = ego_x_[b] + ego_action_[b];
+        ego_crosses_[b] = (next_ego_x_[b] >= crossing_point) & (ego_x_[b] <= crossing_point);
+        collision_[b] = 0;
+      }
+
+      // Others: sample a desired gap, calculate the policy action and check for collisions with the ego agent
+      for (std::size_t i = 0; i < num_other_agents_; ++i) {
+        Domain* x = &other_x_[i*B];
+        Domain* last_action = &other_last_action_[i*B];
+        const Domain* gap_min = &gap_min_[i*B];
+        const Domain* gap_max = &gap_max_[i*B];
+        for (std::size_t b = 0; b < B; ++b) {
+          const Domain gap = sample_gap(gap_min[b], gap_max[b], next_random(rng_[b]));
+          const Domain action = other_agent_policy_action(x[b], last_action[b], ego_x_[b] + ego_last_action_[b], gap,
+                                                          crossing_point, min_velocity_other, max_velocity_other);
+
+          const Domain next_x = std::max(x[b] + action, Domain(0));
+          collision_[b] |= ego_crosses_[b] & (next_x >= crossing_point) & (x[b] <= crossing_point);
+          x[b] = next_x;
+          last_action[b] = action;
+        }
+      }
+
+      // Rewards, costs and terminal checks
+      std::size_t num_alive = 0;
+      for (std::size_t b = 0; b < B; ++b) {
+        const bool collision = collision_[b];
+        const bool out_of_map = next_ego_x_[b] < 0;
+        const bool goal_reached = (next_ego_x_[b] >= parameters_.EGO_GOAL_POS) & !collision;
+        const Reward reward = goal_reached * parameters_.REWARD_GOAL_REACHED
+                   + collision * parameters_.REWARD_COLLISION + parameters_.REWARD_COLLISION * out_of_map
+                   + parameters_.REWARD_STEP;
+        const Cost cost = parameters_.COST_ONLY_COLLISION ? collision * 1.0 : -1.0 * reward;
+        const double weight = alive_[b] * discount;
+        accum_rewards_[b] += weight * reward;
+        accum_costs_[b] += weight * cost;
+
+        ego_x_[b] = next_ego_x_[b];
+        ego_last_action_[b] = ego_action_[b];
+        alive_[b] &= !(goal_reached | collision | out_of_map);
+        num_alive += alive_[b];
+      }
+      return num_alive;
+    }
+
+    std::size_t get_batch_size() const { return batch_size_; }
+
+    std::size_t get_num_other_agents() const { return num_other_agents_; }
+
+    const CrossingStateParameters<Domain>& get_parameters() const { return parameters_; }
+
+    // Ends the episode of a lane, e.g. at the maximum search depth, it accumulates no further rewards
+    void stop(const std::size_t& lane) { alive_[lane] = 0; }
+
+    std::size_t num_alive() const {
+      std::size_t num_alive = 0;
+      for (const auto& alive : alive_) {
+        num_alive += alive;
+      }
+      return num_alive;
+    }
+
+    bool is_alive(const std::size_t& lane) const { return alive_[lane]; }
+
+    const std::vector<Reward>& get_accum_rewards() const { return accum_rewards_; }
+
+    const std::vector<Cost>& get_accum_costs() const { return accum_costs_; }
+
+    AgentState<Domain> get_ego_state(const std::size_t& lane) const {
+      return AgentState<Domain>(ego_x_[lane], ego_last_action_[lane]);
+    }
+
+    AgentState<Domain> get_agent_state(const std::size_t& lane, const AgentIdx& agent_idx) const {
+      const std::size_t idx = (agent_idx-1)*batch_size_ + lane;
+      return AgentState<Domain>(other_x_[idx], other_last_action_[idx]);
+    }
+
+  private:
+    static inline std::uint32_t next_random(std::uint32_t& state) {
+      // xorshift32
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      return state;
+    }
+
+    static inline Domain sample_gap(const Domain& min, const Domain& max, const std::uint32_t& random);
+
+    const CrossingStateParameters<Domain>& parameters_;
+    const std::size_t num_other_agents_;
+    std::size_t batch_size_;
+
+    // Lane data, other agents are stored agent-major: index = (agent_idx-1)*batch_size + lane
+    std::vector<Domain> ego_x_;
+    std::vector<Domain> ego_last_action_;
+    std::vector<Domain> other_x_;
+    std::vector<Domain> other_last_action_;
+    std::vector<Domain> gap_min_;
+    std::vector<Domain> gap_max_;
+    std::vector<std::uint8_t> alive_;
+    std::vector<Reward> accum_rewards_;
+    std::vector<Cost> accum_costs_;
+    std::vector<std::uint32_t> rng_;
+
+    // Scratch arrays reused in each step
+    std::vector<Domain> ego_action_;
+    std::vector<Domain> next_ego_x_;
+    std::vector<std::uint8_t> ego_crosses_;
+    std::vector<std::uint8_t> collision_;
+};
+
+template <>
+inline int CrossingStateBatchSimulator<int>::sample_gap(const int& min, const int& max, const std::uint32_t& random) {
+  // uniform integer in [min, max]
+  const std::uint32_t range = static_cast<std::uint32_t>(max - min) + 1u;
+  return min + static_cast<int>((static_cast<std::uint64_t>(random) * range) >> 32);
+}
+
+template <>
+inline float CrossingStateBatchSimulator<float>::sample_gap(const float& min, const float& max, const std::uint32_t& random) {
+  // uniform real in [min, max)
+  return min + (max - min) * (static_cast<float>(random >> 8) * (1.0f / 16777216.0f));
+}
+
+} // namespace mcts
+
+#endif // MCTS_CROSSING_STATE_BATCH_SIMULATOR_H_
@@ -8,6 +8,7 @@
 #ifndef MCTS_CROSSING_STATE_COMMON_H_
 #define MCTS_CROSSING_STATE_COMMON_H_
 
+#include <algorithm>
 #include "environments/crossing_state_parameters.h"
 #include "mcts/hypothesis/hypothesis_state.h"
 
@@ -26,6 +27,30 @@ inline ActionIdx aconv(const Domain& action) {
     return ((union { Domain i; ActionIdx u; }){ .i = action }).u;
 }
 
+// Policy of the other agents shared by AgentPolicyCrossingState and CrossingStateBatchSimulator, written with
+// selects only such that the simulator vectorizes it over lanes. Before the crossing point an agent closes the
+// error to its desired gap to the ego agent, whose position is predicted with the ego's last action.
+template <typename Domain>
+inline Domain other_agent_gap_action(const Domain& gap_error, const Domain& last_action, const Domain& desired_gap_dst,
+                                     const Domain& min_velocity, const Domain& max_velocity) {
+    // gap_error < 0 -> brake to increase distance
+    const Domain positive_gap_action = (gap_error < 0) ? std::max(gap_error, min_velocity)
+                                                       : std::min(gap_error, max_velocity);
+    // Dont brake again if agents is already ahead of ego agent, but continue with same velocity
+    const Domain negative_gap_action = std::max(std::min(gap_error, max_velocity), last_action);
+    return (desired_gap_dst > 0) ? positive_gap_action : negative_gap_action;
+}
+
+// Past the crossing point an agent keeps its last action
+template <typename Domain>
+inline Domain other_agent_policy_action(const Domain& x_pos, const Domain& last_action, const Domain& predicted_ego_x_pos,
+                                        const Domain& desired_gap_dst, const Domain& crossing_point,
+                                        const Domain& min_velocity, const Domain& max_velocity) {
+    const Domain gap_action = other_agent_gap_action<Domain>(predicted_ego_x_pos - x_pos - desired_gap_dst, last_action,
+                                                             desired_gap_dst, min_velocity, max_velocity);
+    return (x_pos < crossing_point) ? gap_action : last_action;
+}
+
 template <typename Domain>
 struct AgentState {
     AgentState() : x_pos(5), last_action(2.0f) {}
@@ -28,18 +28,26 @@ class CrossingStateEpisodeRunner {
                               const unsigned int& mcts_max_search_time,
                               const unsigned int& mcts_max_iterations,
                               Viewer* viewer) :
-                  agents_true_policies_(agents_true_policies),
+                  viewer_(viewer),
                   current_state_(),
                   last_state_(),
                   belief_tracker_(mcts_parameters),
+                  agents_true_policies_(agents_true_policies),
+                  true_policies_random_generators_(),
+                  hypothesis_(make_hypothesis_set(hypothesis)),
                   max_steps_(max_steps),
                   mcts_parameters_(mcts_parameters),
                   crossing_state_parameters_(crossing_state_parameters),
-                  viewer_(viewer)  {
+                  profile_(),
+                  tree_statistics_(),
+                  tracer_(nullptr),
+                  recorder_(nullptr)  {
                   current_state_ = std::make_shared<CrossingState<Domain>>(belief_tracker_.sample_current_hypothesis(),
-                                                                           crossing_state_parameters_);
-                  for(const auto& hp : hypothesis) {
-                    current_state_->add_hypothesis(hp);
+                                                                           crossing_state_parameters_,
+                                                                           hypothesis_);
+                  for (const auto& policy : agents_true_policies_) {
+                    true_policies_random_generators_.emplace(policy.first,
+                                            Philox4x32(crossing_state_parameters_.OTHER_AGENTS_POLICY_RANDOM_SEED));
                   }
                   last_state_ = current_state_;
                   // Init tracking
@@ -58,22 +66,34 @@ class CrossingStateEpisodeRunner {
       Cost cost;
 
       JointAction jointaction(current_state_->get_num_agents());
-      Mcts<CrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic> mcts(mcts_parameters_);
-      mcts.search(*current_state_, belief_tracker_);
-      jointaction[CrossingState<Domain>::ego_agent_idx] = mcts.returnBestAction();
-
-      AgentIdx action_idx = 1;
-      for (auto agent_idx : current_state_->get_other_agent_idx()) {
-          // Other agents act according to unknown true agents policy
-          const auto action = agents_true_policies_.at(agent_idx).act(current_state_->get_agent_state(agent_idx),
-                                                      current_state_->get_ego_state());
-          jointaction[action_idx] = aconv(action);
-          action_idx++;
-      }
+      {
+        ScopedTraceSpan step_span(tracer_ ? &tracer_->thread_buffer(mcts_parameters_.THREAD_IDX) : nullptr,
+                                  "step", "episode");
+        Mcts<CrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic> mcts(mcts_parameters_);
+        mcts.set_tracer(tracer_);
+        mcts.set_recorder(recorder_);
+        mcts.search(*current_state_, belief_tracker_);
+        profile_.merge(mcts.profile());
+        tree_statistics_ = mcts.treeStatistics();
+        jointaction[CrossingState<Domain>::ego_agent_idx] = mcts.returnBestAction();
+
+        AgentIdx action_idx = 1;
+        for (auto agent_idx : current_state_->get_other_agent_idx()) {
+            // Other agents act according to unknown true agents policy
+            const auto action = agents_true_policies_.at(agent_idx).act(current_state_->get_agent_state(agent_idx),
+                                                        current_state_->get_ego_state(),
+                                                        true_policies_random_generators_.at(agent_idx));
+            jointaction[action_idx] = current_state_->get_action_idx(agent_idx, action);
+            action_idx++;
+        }
 
-      last_state_ = current_state_;
-      current_state_ = last_state_->execute(jointaction, rewards, cost);
-      belief_tracker_.belief_update(*last_state_, *current_state_);
+        last_state_ = current_state_;
+        current_state_ = last_state_->execute(jointaction, rewards, cost);
+        belief_tracker_.belief_update(*last_state_, *current_state_);
+      }
+      if(tracer_) {
+        tracer_->flush();
+      }
       
       bool collision = current_state_->ego_collided();
       bool goal_reached = current_state_->ego_goal_reached();
@@ -125,15 +145,33 @@ class CrossingStateEpisodeRunner {
       }
     }
 
+    // Search phase profile summed over all steps
+    const SearchProfile& get_profile() const { return profile_; }
+
+    // Tree shape and estimated memory of the search of the last step
+    const TreeStatistics& get_tree_statistics() const { return tree_statistics_; }
+
+    // Traces each step and its search, flushed at the end of the step. nullptr disables tracing.
+    void set_tracer(SearchTracer* tracer) { tracer_ = tracer; }
+
+    // Records the search of each step for replay, nullptr disables recording.
+    void set_recorder(SearchRecorder* recorder) { recorder_ = recorder; }
+
   private:
     Viewer* viewer_;
     std::shared_ptr<CrossingState<Domain>> current_state_;
     std::shared_ptr<CrossingState<Domain>> last_state_;
     HypothesisBeliefTracker belief_tracker_; // todo: pass params
     std::unordered_map<AgentIdx, AgentPolicyCrossingState<Domain>> agents_true_policies_;
+    std::unordered_map<AgentIdx, Philox4x32> true_policies_random_generators_;
+    HypothesisSetSPtr<Domain> hypothesis_;
     const unsigned int max_steps_;
     const MctsParameters mcts_parameters_;
     const CrossingStateParameters<Domain> crossing_state_parameters_;
+    SearchProfile profile_;
+    TreeStatistics tree_statistics_;
+    SearchTracer* tracer_;
+    SearchRecorder* recorder_;
 };
 
 
@@ -17,9 +17,16 @@ struct CrossingStateParameters {
     unsigned int NUM_OTHER_AGENTS;
     unsigned int OTHER_AGENTS_POLICY_RANDOM_SEED;
     bool COST_ONLY_COLLISION;
+    // Precompute the other agents' policies as action and probability tables (integer domain only), opt-in,
+    // the tables equal the closed form but cost memory and construction time per policy
+    bool TABULATE_OTHER_AGENTS_POLICY;
     Domain MAX_VELOCITY_OTHER;
     Domain MIN_VELOCITY_OTHER;
     unsigned int NUM_OTHER_ACTIONS;
+    // Map other agents' actions to dense action indices per state instead of bit casting them,
+    // with a resolution > 0 actions are quantized and the number of other actions follows from the grid
+    bool INTERN_OTHER_ACTIONS;
+    Domain OTHER_ACTIONS_RESOLUTION;
     Domain MAX_VELOCITY_EGO;
     Domain MIN_VELOCITY_EGO;
     Domain NUM_EGO_ACTIONS() const { return MAX_VELOCITY_EGO - MIN_VELOCITY_EGO + 1; }
@@ -38,6 +45,7 @@ CrossingStateParameters<Domain> default_crossing_state_parameters() {
   CrossingStateParameters<Domain> parameters;
   parameters.NUM_OTHER_AGENTS = 2;
   parameters.COST_ONLY_COLLISION = false;
+  parameters.TABULATE_OTHER_AGENTS_POLICY = false;
   parameters.OTHER_AGENTS_POLICY_RANDOM_SEED = 1000;
   parameters.MAX_VELOCITY_OTHER = 3;
   parameters.MIN_VELOCITY_OTHER = -3;
@@ -51,6 +59,9 @@ CrossingStateParameters<Domain> default_crossing_state_parameters() {
     parameters.NUM_OTHER_ACTIONS = 30;
   }
 
+  parameters.INTERN_OTHER_ACTIONS = false;
+  parameters.OTHER_ACTIONS_RESOLUTION = 0;
+
   parameters.REWARD_COLLISION = -1000.0f;
   parameters.REWARD_GOAL_REACHED = 100.0f;
   parameters.REWARD_STEP = 0.0f;
@@ -0,0 +1,138 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef MCTS_SYNTHETIC_STATE_H_
+#define MCTS_SYNTHETIC_STATE_H_
+
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include "mcts/state.h"
+
+namespace mcts {
+
+struct SyntheticStateParameters {
+    unsigned int NUM_OTHER_AGENTS;
+    ActionIdx NUM_ACTIONS; // per agent
+    unsigned int BRANCHING; // distinct successor states of a state over all joint actions
+    unsigned int TERMINAL_DEPTH; // steps after which every state is terminal
+    unsigned int EXECUTE_COST; // rounds of artificial work per execute
+    unsigned int RANDOM_SEED; // selects the transition and reward functions
+};
+
+inline SyntheticStateParameters default_synthetic_state_parameters() {
+    SyntheticStateParameters parameters;
+    parameters.NUM_OTHER_AGENTS = 1;
+    parameters.NUM_ACTIONS = 4;
+    parameters.BRANCHING = 16;
+    parameters.TERMINAL_DEPTH = 10;
+    parameters.EXECUTE_COST = 0;
+    parameters.RANDOM_SEED = 1000;
+    return parameters;
+}
+
+// An environment without semantics for scaling studies. States are identified by a hash of their predecessor and
+// the successor index, the successor index and the rewards in [0, 1] are hashes of the state and joint action.
+class SyntheticState : public mcts::StateInterface<SyntheticState>
+{
+public:
+    explicit SyntheticState(const SyntheticStateParameters& parameters) :
+                  SyntheticState(parameters, mix(parameters.RANDOM_SEED), 0,
+                                 make_other_agent_idx(parameters.NUM_OTHER_AGENTS)) {}
+
+    SyntheticState(const SyntheticStateParameters& parameters, const std::uint64_t& id, const unsigned int& depth,
+                   const std::shared_ptr<const AgentIdxVector>& other_agent_idx) :
+                  id_(id),
+                  depth_(depth),
+                  other_agent_idx_(other_agent_idx),
+                  parameters_(parameters) {}
+
+    std::shared_ptr<SyntheticState> clone() const
+    {
+        return std::make_shared<SyntheticState>(*this);
+    }
+
+    std::shared_ptr<SyntheticState> execute(const JointAction& joint_action, std::vector<Reward>& rewards, Cost& ego_cost) const {
+        std::uint64_t hash = id_;
+        for (const auto& action : joint_action) {
+            hash = mix(hash ^ action);
+        }
+        // Artificial execution cost, the result is used such that the work is not optimized away
+        // but changes the transition only with negligible probability
+        std::uint64_t work = hash;
+        for (unsigned int round = 0; round < parameters_.EXECUTE_COST; ++round) {
+            work = mix(work);
+        }
+        if(work == 0) {
+            hash ^= 1;
+        }
+
+        rewards.resize(joint_action.size());
+        for (std::size_t agent = 0; agent < rewards.size(); ++agent) {
+            rewards[agent] = unit_interval(mix(hash + agent));
+        }
+        ego_cost = 1.0 - rewards[ego_agent_idx];
+        const std::uint64_t successor = hash % std::max(parameters_.BRANCHING, 1u);
+        return std::make_shared<SyntheticState>(parameters_, mix(id_ ^ (successor + 1)), depth_ + 1, other_agent_idx_);
+    }
+
+    ActionIdx get_num_actions(AgentIdx agent_idx) const {
+        return parameters_.NUM_ACTIONS;
+    }
+
+    bool is_terminal() const {
+        return depth_ >= parameters_.TERMINAL_DEPTH;
+    }
+
+    const AgentIdxVector& get_other_agent_idx() const {
+        return *other_agent_idx_;
+    }
+
+    const AgentIdx get_ego_agent_idx() const {
+        return 0;
+    }
+
+    std::uint64_t get_id() const { return id_; }
+
+    unsigned int get_depth() const { return depth_; }
+
+    std::string sprintf() const
+    {
+        std::stringstream ss;
+        ss << "SyntheticState (id: " << id_ << ", depth: " << depth_ << ")";
+        return ss.str();
+    }
+
+private:
+    // splitmix64 finalizer
+    static std::uint64_t mix(std::uint64_t x) {
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    static double unit_interval(const std::uint64_t& x) {
+        return static_cast<double>(x >> 11) / static_cast<double>(1ull << 53);
+    }
+
+    static std::shared_ptr<const AgentIdxVector> make_other_agent_idx(const std::size_t& num_other_agents) {
+        auto agent_idx = std::make_shared<AgentIdxVector>(num_other_agents);
+        std::iota(agent_idx->begin(), agent_idx->end(), 1); // start from 1 since 0 is ego agent
+        return agent_idx;
+    }
+
+    std::uint64_t id_;
+    unsigned int depth_;
+    std::shared_ptr<const AgentIdxVector> other_agent_idx_; // computed once at the root and passed on to child states
+
+    const SyntheticStateParameters& parameters_;
+};
+
+} // namespace mcts
+
+#endif // MCTS_SYNTHETIC_STATE_H_
@@ -196,7 +196,7 @@ TEST(hypothesis_crossing_state_float, collision_2 )
                                                         false,
                                                         false,
                                                         false,
-                                                        std::vector<AgentPolicyCrossingState<Domain>>());
+                                                        make_hypothesis_set<Domain>({}));
 
     std::vector<Reward> rewards;
     Cost cost;
@@ -231,13 +231,14 @@ TEST(hypothesis_crossing_state_float, hypothesis_friendly)
     bool collision = false;
 
     // Ego agent moves forward other agents stick to deterministic hypothesis keeping distance of 5
+    Philox4x32 random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
     for(int i = 0; i< 100; ++i) {
       belief_tracker.sample_current_hypothesis();
       auto jointaction = JointAction(state->get_num_agents());
       jointaction[CrossingState<Domain>::ego_agent_idx] = aconv<Domain>(1.0f);
       AgentIdx action_idx = 1;
       for (auto agent_idx : state->get_other_agent_idx()) {
-          const auto action = state->plan_action_current_hypothesis(agent_idx);
+          const auto action = state->plan_action_current_hypothesis(agent_idx, random_generator);
           jointaction[action_idx] = action;
           action_idx++;
       }
@@ -272,6 +273,7 @@ TEST(hypothesis_crossing_state_float, hypothesis_belief_correct)
     auto next_state = state;
 
     AgentPolicyCrossingState<Domain> true_agents_policy({0.3, 0.7}, params);
+    Philox4x32 true_policy_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
 
     std::vector<Reward> rewards;
     Cost cost;
@@ -284,7 +286,7 @@ TEST(hypothesis_crossing_state_float, hypothesis_belief_correct)
       AgentIdx action_idx = 1;
       for (auto agent_idx : state->get_other_agent_idx()) {
         const auto action = true_agents_policy.act(state->get_agent_state(agent_idx),
-                                                    state->get_ego_state());
+                                                    state->get_ego_state(), true_policy_random_generator);
         jointaction[action_idx] = aconv<Domain>(action);
         action_idx++;
       }
@@ -319,6 +321,7 @@ TEST(crossing_state, mcts_goal_reached_true_hypothesis)
     belief_tracker.belief_update(*state, *next_state);
 
     AgentPolicyCrossingState<Domain> true_agents_policy({2,3.5}, params);
+    Philox4x32 true_policy_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
 
     std::vector<Reward> rewards;
     Cost cost;
@@ -336,7 +339,7 @@ TEST(crossing_state, mcts_goal_reached_true_hypothesis)
         for (auto agent_idx : state->get_other_agent_idx()) {
           // Other agents act according to unknown true agents policy
           const auto action = true_agents_policy.act(state->get_agent_state(agent_idx),
-                                                      state->get_ego_state());
+                                                      state->get_ego_state(), true_policy_random_generator);
           jointaction[agent_idx] = aconv<Domain>(action);
           action_idx++;
       }
@@ -365,6 +368,7 @@ TEST(crossing_state, mcts_goal_reached_wrong_hypothesis)
     belief_tracker.belief_update(*state, *next_state);
 
     AgentPolicyCrossingState<Domain> true_agents_policy({-2,-1.8}, params);
+    Philox4x32 true_policy_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
 
     std::vector<Reward> rewards;
     Cost cost;
@@ -381,7 +385,7 @@ TEST(crossing_state, mcts_goal_reached_wrong_hypothesis)
       for (auto agent_idx : state->get_other_agent_idx()) {
         // Other agents act according to unknown true agents policy
         const auto action = true_agents_policy.act(state->get_agent_state(agent_idx),
-                                                    state->get_ego_state());
+                                                    state->get_ego_state(), true_policy_random_generator);
         jointaction[action_idx] = aconv<Domain>(action);
         action_idx++;
       }
@@ -402,6 +406,68 @@ TEST(crossing_state, mcts_goal_reached_wrong_hypothesis)
 
 }
 
+TEST(hypothesis_crossing_state_float, interned_actions)
+{
+    auto params = default_crossing_state_parameters<Domain>();
+    params.INTERN_OTHER_ACTIONS = true;
+    params.OTHER_ACTIONS_RESOLUTION = 0.5;
+    HypothesisBeliefTracker belief_tracker(mcts_default_parameters());
+    auto state = std::make_shared<CrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), params);
+
+    // Quantized grid from MIN_VELOCITY_OTHER to MAX_VELOCITY_OTHER bounds the number of actions
+    EXPECT_EQ(state->get_num_actions(1), 13);
+
+    // Dense indices in order of appearance, per agent, nearby actions share an index
+    EXPECT_EQ(state->get_action_idx(1, 1.1f), 0);
+    EXPECT_EQ(state->get_action_idx(1, -2.0f), 1);
+    EXPECT_EQ(state->get_action_idx(1, 0.9f), 0);
+    EXPECT_EQ(state->get_action_idx(2, -2.0f), 0);
+    EXPECT_FLOAT_EQ(state->get_action(1, 0), 1.0f);
+    EXPECT_FLOAT_EQ(state->get_action(1, 1), -2.0f);
+
+    // Executed states see the represented actions
+    std::vector<Reward> rewards;
+    Cost cost;
+    auto jointaction = JointAction(state->get_num_agents());
+    jointaction[CrossingState<Domain>::ego_agent_idx] = 2;
+    jointaction[1] = state->get_action_idx(1, 1.1f);
+    jointaction[2] = state->get_action_idx(2, -2.2f);
+    const auto next_state = state->execute(jointaction, rewards, cost);
+    EXPECT_FLOAT_EQ(next_state->get_last_action(1), 1.0f);
+    EXPECT_FLOAT_EQ(next_state->get_last_action(2), -2.0f);
+    EXPECT_FLOAT_EQ(next_state->get_agent_state(1).x_pos, state->get_agent_state(1).x_pos + 1.0f);
+
+    // The child state starts with an empty mapping
+    EXPECT_EQ(next_state->get_action_idx(1, 3.0f), 0);
+
+    // Raw indices not interned by the state are rejected, searches with UctStatistic for the other agents
+    // enumerating such indices are rejected before the first iteration
+    jointaction[1] = 5;
+    EXPECT_THROW(state->execute(jointaction, rewards, cost), std::invalid_argument);
+    Mcts<CrossingState<Domain>, UctStatistic, UctStatistic, RandomHeuristic> mcts(mcts_default_parameters());
+    EXPECT_THROW(mcts.search(*state, belief_tracker), std::invalid_argument);
+    EXPECT_EQ(mcts.numIterations(), 0u);
+}
+
+TEST(episode_runner, interned_actions_reached_goal) {
+  auto params = default_crossing_state_parameters<Domain>();
+  params.INTERN_OTHER_ACTIONS = true;
+  params.OTHER_ACTIONS_RESOLUTION = 0.25;
+  auto runner = CrossingStateEpisodeRunner<Domain>(
+      { {1 , AgentPolicyCrossingState<Domain>({5,6}, params)},
+        {2 , AgentPolicyCrossingState<Domain>({-3,-2}, params)}},
+      {AgentPolicyCrossingState<Domain>({-3,-2}, params),
+        AgentPolicyCrossingState<Domain>({5,6}, params)},
+        mcts_default_parameters(),
+        params,
+        30,
+        200,
+        10000,
+        nullptr);
+  auto result = runner.run();
+  EXPECT_TRUE(std::get<4>(result).second);
+}
+
 TEST(episode_runner, four_agents_reached_goal) {
   auto params = default_crossing_state_parameters<Domain>();
   params.NUM_OTHER_AGENTS = 4;
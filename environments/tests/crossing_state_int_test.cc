@@ -13,12 +13,22 @@
 #include "mcts/heuristics/random_heuristic.h"
 #include "mcts/hypothesis/hypothesis_statistic.h"
 #include "mcts/statistics/uct_statistic.h"
+#include "mcts/statistics/rave_statistic.h"
 #include "mcts/hypothesis/hypothesis_belief_tracker.h"
+#include "mcts/hypothesis/hypothesis_ensemble_search.h"
+#include "mcts/shared_memory_search.h"
+#include "mcts/batch_planner.h"
 
 #include "environments/crossing_state.h"
+#include "environments/compact_crossing_state.h"
+#include "environments/crossing_state_batch_heuristic.h"
 #include "environments/crossing_state_episode_runner.h"
 
 #include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <thread>
 
 using namespace std;
 using namespace mcts;
@@ -57,6 +67,88 @@ TEST(hypothesis_crossing_state, collision )
     EXPECT_TRUE(collision);
 }
 
+TEST(hypothesis_crossing_state, hypothesis_set_shared)
+{
+    const auto params = default_crossing_state_parameters<Domain>();
+    HypothesisBeliefTracker belief_tracker(mcts_default_parameters());
+    const auto hypothesis = make_hypothesis_set<Domain>({AgentPolicyCrossingState<Domain>({4,5}, params),
+                                                        AgentPolicyCrossingState<Domain>({5,6}, params)});
+    auto state = std::make_shared<CrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), params, hypothesis);
+
+    std::vector<Reward> rewards;
+    Cost cost;
+    auto jointaction = JointAction(state->get_num_agents(), aconv<Domain>(1));
+    jointaction[CrossingState<Domain>::ego_agent_idx] = 2;
+    const auto next_state = state->execute(jointaction, rewards, cost);
+    const auto cloned_state = next_state->clone();
+
+    // Child and cloned states reference the same hypothesis set instead of copying it
+    EXPECT_EQ(next_state->get_hypothesis_set().get(), hypothesis.get());
+    EXPECT_EQ(cloned_state->get_hypothesis_set().get(), hypothesis.get());
+    EXPECT_EQ(cloned_state->get_num_hypothesis(1), 2);
+
+    // Adding a hypothesis does not alter states sharing the previous set
+    state->add_hypothesis(AgentPolicyCrossingState<Domain>({5,5}, params));
+    EXPECT_EQ(state->get_num_hypothesis(1), 3);
+    EXPECT_EQ(next_state->get_num_hypothesis(1), 2);
+}
+
+TEST(hypothesis_crossing_state, other_agent_idx_cached)
+{
+    auto params = default_crossing_state_parameters<Domain>();
+    params.NUM_OTHER_AGENTS = 3;
+    HypothesisBeliefTracker belief_tracker(mcts_default_parameters());
+    auto state = std::make_shared<CrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), params);
+
+    std::vector<Reward> rewards;
+    Cost cost;
+    auto jointaction = JointAction(state->get_num_agents(), aconv<Domain>(1));
+    const auto next_state = state->execute(jointaction, rewards, cost);
+
+    EXPECT_EQ(state->get_other_agent_idx(), AgentIdxVector({1, 2, 3}));
+    EXPECT_EQ(state->get_num_agents(), 4);
+    // Child states reference the indices computed by the root state
+    EXPECT_EQ(&state->get_other_agent_idx(), &next_state->get_other_agent_idx());
+    EXPECT_EQ(&state->get_other_agent_idx(), &next_state->clone()->get_other_agent_idx());
+}
+
+TEST(hypothesis_crossing_state, tabulated_policy_equal_to_closed_form)
+{
+    auto params = default_crossing_state_parameters<Domain>();
+    auto params_closed_form = params;
+    params.TABULATE_OTHER_AGENTS_POLICY = true;
+    params_closed_form.TABULATE_OTHER_AGENTS_POLICY = false;
+
+    const std::vector<std::pair<Domain, Domain>> gap_ranges = {{-2,-1}, {-1,3}, {2,5}, {4,4}};
+    for (const auto& gap_range : gap_ranges) {
+        AgentPolicyCrossingState<Domain> tabulated(gap_range, params);
+        AgentPolicyCrossingState<Domain> closed_form(gap_range, params_closed_form);
+        EXPECT_TRUE(tabulated.is_tabulated());
+        EXPECT_FALSE(closed_form.is_tabulated());
+        Philox4x32 tabulated_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
+        Philox4x32 closed_form_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
+
+        // Cover the saturated distances, last actions outside the velocity bounds and the crossing point
+        for (Domain ego_x = 0; ego_x < params.CHAIN_LENGTH; ++ego_x) {
+          for (Domain ego_last = params.MIN_VELOCITY_EGO; ego_last <= params.MAX_VELOCITY_EGO; ++ego_last) {
+            for (Domain agent_x = -2; agent_x < params.CHAIN_LENGTH + 4; ++agent_x) {
+              for (Domain agent_last = params.MIN_VELOCITY_OTHER-1; agent_last <= params.MAX_VELOCITY_OTHER+1; ++agent_last) {
+                const AgentState<Domain> ego_state(ego_x, ego_last);
+                const AgentState<Domain> agent_state(agent_x, agent_last);
+                for (Domain action = params.MIN_VELOCITY_OTHER-1; action <= params.MAX_VELOCITY_OTHER+1; ++action) {
+                  EXPECT_EQ(tabulated.get_probability(agent_state, ego_state, action),
+                            closed_form.get_probability(agent_state, ego_state, action));
+                }
+                // Both generators use the same seed and thus sample the same desired gaps
+                EXPECT_EQ(tabulated.act(agent_state, ego_state, tabulated_random_generator),
+                          closed_form.act(agent_state, ego_state, closed_form_random_generator));
+              }
+            }
+          }
+        }
+    }
+}
+
 TEST(hypothesis_crossing_state, hypothesis_friendly)
 {
     const auto params = default_crossing_state_parameters<Domain>();
@@ -72,12 +164,13 @@ TEST(hypothesis_crossing_state, hypothesis_friendly)
     bool collision = false;
 
     // Ego agent moves forward other agents stick to deterministic hypothesis keeping distance of 5
+    Philox4x32 random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
     for(int i = 0; i< 100; ++i) {
       belief_tracker.sample_current_hypothesis();
       auto jointaction = JointAction(state->get_num_agents());
       jointaction[CrossingState<Domain>::ego_agent_idx] = 2;
       for (auto agent_idx : state->get_other_agent_idx()) {
-        const auto action = state->plan_action_current_hypothesis(agent_idx);
+        const auto action = state->plan_action_current_hypothesis(agent_idx, random_generator);
         jointaction[agent_idx] = action;
       }
       state = state->execute(jointaction, rewards, cost);
@@ -106,6 +199,7 @@ TEST(hypothesis_crossing_state, hypothesis_belief_correct)
     auto next_state = state;
 
     AgentPolicyCrossingState<Domain> true_agents_policy({5,5}, params);
+    Philox4x32 true_policy_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
 
     std::vector<Reward> rewards;
     Cost cost;
@@ -117,7 +211,7 @@ TEST(hypothesis_crossing_state, hypothesis_belief_correct)
       jointaction[CrossingState<Domain>::ego_agent_idx] =  2;
       for (auto agent_idx : state->get_other_agent_idx()) {
         const auto action = true_agents_policy.act(state->get_agent_state(agent_idx),
-                                                    state->get_ego_state());
+                                                    state->get_ego_state(), true_policy_random_generator);
         jointaction[agent_idx] = aconv<Domain>(action);
       }
       std::cout << "Step " << i << ", Action = " << jointaction << ", " << state->sprintf() << std::endl;
@@ -149,6 +243,7 @@ TEST(crossing_state, mcts_goal_reached_true_hypothesis)
     belief_tracker.belief_update(*state, *next_state);
 
     AgentPolicyCrossingState<Domain> true_agents_policy({5,5}, params);
+    Philox4x32 true_policy_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
 
     std::vector<Reward> rewards;
     Cost cost;
@@ -165,7 +260,7 @@ TEST(crossing_state, mcts_goal_reached_true_hypothesis)
       for (auto agent_idx : state->get_other_agent_idx()) {
         // Other agents act according to unknown true agents policy
         const auto action = true_agents_policy.act(state->get_agent_state(agent_idx),
-                                                    state->get_ego_state());
+                                                    state->get_ego_state(), true_policy_random_generator);
         jointaction[agent_idx] = aconv<Domain>(action);
       }
       std::cout << "Step " << i << ", Action = " << jointaction << ", " << state->sprintf() << std::endl;
@@ -180,6 +275,418 @@ TEST(crossing_state, mcts_goal_reached_true_hypothesis)
 
 }
 
+TEST(crossing_state, mcts_goal_reached_rave)
+{
+    const auto params = default_crossing_state_parameters<Domain>();
+    auto mcts_params = mcts_default_parameters();
+    mcts_params.MAX_NUMBER_OF_ITERATIONS = 2000;
+    HypothesisBeliefTracker belief_tracker(mcts_params);
+    auto state = std::make_shared<CrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), params,
+                  make_hypothesis_set<Domain>({AgentPolicyCrossingState<Domain>({4,5}, params),
+                                               AgentPolicyCrossingState<Domain>({5,6}, params)}));
+    belief_tracker.belief_update(*state, *state);
+
+    AgentPolicyCrossingState<Domain> true_agents_policy({5,5}, params);
+    Philox4x32 true_policy_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
+    std::vector<Reward> rewards;
+    Cost cost;
+    for(int i = 0; i < 100 && !state->is_terminal(); ++i) {
+      auto jointaction = JointAction(state->get_num_agents());
+      Mcts<CrossingState<Domain>, RaveStatistic, HypothesisStatistic, RandomHeuristic> mcts(mcts_params);
+      mcts.search(*state, belief_tracker);
+      jointaction[CrossingState<Domain>::ego_agent_idx] = mcts.returnBestAction();
+      for (auto agent_idx : state->get_other_agent_idx()) {
+        jointaction[agent_idx] = aconv<Domain>(true_agents_policy.act(state->get_agent_state(agent_idx),
+                                                                     state->get_ego_state(), true_policy_random_generator));
+      }
+      auto next_state = state->execute(jointaction, rewards, cost);
+      belief_tracker.belief_update(*state, *next_state);
+      state = next_state;
+    }
+    EXPECT_TRUE(state->ego_goal_reached());
+}
+
+TEST(crossing_state, mcts_goal_reached_sequential_halving)
+{
+    const auto params = default_crossing_state_parameters<Domain>();
+    auto mcts_params = mcts_default_parameters();
+    mcts_params.MAX_NUMBER_OF_ITERATIONS = 300;
+    mcts_params.root_action_selection.SEQUENTIAL_HALVING = true;
+    mcts_params.root_action_selection.GUMBEL_SAMPLING = true;
+    HypothesisBeliefTracker belief_tracker(mcts_params);
+    auto state = std::make_shared<CrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), params,
+                  make_hypothesis_set<Domain>({AgentPolicyCrossingState<Domain>({4,5}, params),
+                                               AgentPolicyCrossingState<Domain>({5,6}, params)}));
+    belief_tracker.belief_update(*state, *state);
+
+    AgentPolicyCrossingState<Domain> true_agents_policy({5,5}, params);
+    Philox4x32 true_policy_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
+    std::vector<Reward> rewards;
+    Cost cost;
+    for(int i = 0; i < 100 && !state->is_terminal(); ++i) {
+      auto jointaction = JointAction(state->get_num_agents());
+      Mcts<CrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic> mcts(mcts_params);
+      mcts.search(*state, belief_tracker);
+      jointaction[CrossingState<Domain>::ego_agent_idx] = mcts.returnBestAction();
+      for (auto agent_idx : state->get_other_agent_idx()) {
+        jointaction[agent_idx] = aconv<Domain>(true_agents_policy.act(state->get_agent_state(agent_idx),
+                                                                     state->get_ego_state(), true_policy_random_generator));
+      }
+      auto next_state = state->execute(jointaction, rewards, cost);
+      belief_tracker.belief_update(*state, *next_state);
+      state = next_state;
+    }
+    EXPECT_TRUE(state->ego_goal_reached());
+}
+
+TEST(hypothesis_ensemble_search, strata_allocation)
+{
+    using Ensemble = HypothesisEnsembleSearch<CrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic>;
+    // Joint beliefs 0.6, 0.15, 0.2, 0.05 -> shares 2.4, 0.6, 0.8, 0.2 on four threads
+    const std::unordered_map<AgentIdx, std::vector<Belief>> beliefs{{1, {0.75, 0.25}}, {2, {0.8, 0.2}}};
+    const auto strata = Ensemble::allocate_strata(beliefs, 4);
+    unsigned int num_threads = 0;
+    std::map<std::pair<HypothesisId, HypothesisId>, unsigned int> threads_per_stratum;
+    for (const auto& stratum : strata) {
+      EXPECT_GT(stratum.num_threads, 0u);
+      num_threads += stratum.num_threads;
+      threads_per_stratum[std::make_pair(stratum.hypothesis.at(1), stratum.hypothesis.at(2))] = stratum.num_threads;
+    }
+    EXPECT_EQ(num_threads, 4u);
+    EXPECT_EQ(threads_per_stratum.size(), 3u);
+    EXPECT_EQ(threads_per_stratum[std::make_pair(0, 0)], 2u);
+    EXPECT_EQ(threads_per_stratum[std::make_pair(0, 1)], 1u);
+    EXPECT_EQ(threads_per_stratum[std::make_pair(1, 0)], 1u);
+
+    // More threads than strata, every stratum is searched
+    const auto single_agent_strata = Ensemble::allocate_strata({{1, {0.75, 0.25}}}, 4);
+    ASSERT_EQ(single_agent_strata.size(), 2u);
+    EXPECT_EQ(single_agent_strata[0].num_threads, 3u);
+    EXPECT_EQ(single_agent_strata[1].num_threads, 1u);
+
+    // 3^20 joint assignments, only the most likely ones are enumerated
+    std::unordered_map<AgentIdx, std::vector<Belief>> many_agents_beliefs;
+    for (AgentIdx agent_idx = 1; agent_idx <= 20; ++agent_idx) {
+      many_agents_beliefs[agent_idx] = {0.1, 0.8, 0.1};
+    }
+    many_agents_beliefs[3] = {0.05, 0.15, 0.8};
+    const auto many_agents_strata = Ensemble::allocate_strata(many_agents_beliefs, 4);
+    ASSERT_FALSE(many_agents_strata.empty());
+    EXPECT_LE(many_agents_strata.size(), 4u);
+    for (const auto& agent_beliefs : many_agents_beliefs) {
+      EXPECT_EQ(many_agents_strata[0].hypothesis.at(agent_beliefs.first), agent_beliefs.first == 3 ? 2u : 1u);
+    }
+    EXPECT_GE(many_agents_strata[0].num_threads, many_agents_strata.back().num_threads);
+}
+
+TEST(hypothesis_ensemble_search, merge_action_values)
+{
+    using Ensemble = HypothesisEnsembleSearch<CrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic>;
+    // Action 1 is unvisited by the first worker, action 2 by all workers
+    const auto values = Ensemble::merge_action_values({0.75, 0.25}, {{-1.0, 0.0, 0.0}, {-3.0, -2.0, 0.0}},
+                                                      {{2, 0, 0}, {2, 4, 0}});
+    EXPECT_DOUBLE_EQ(values[0], (0.75*2*-1.0 + 0.25*2*-3.0)/(0.75*2 + 0.25*2));
+    EXPECT_DOUBLE_EQ(values[1], -2.0);
+    EXPECT_DOUBLE_EQ(values[2], 0.0);
+}
+
+TEST(crossing_state, mcts_goal_reached_hypothesis_ensemble)
+{
+    const auto params = default_crossing_state_parameters<Domain>();
+    auto mcts_params = mcts_default_parameters();
+    mcts_params.MAX_NUMBER_OF_ITERATIONS = 300;
+    mcts_params.hypothesis_ensemble.NUM_THREADS = 4;
+    HypothesisBeliefTracker belief_tracker(mcts_params);
+    auto state = std::make_shared<CrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), params,
+                  make_hypothesis_set<Domain>({AgentPolicyCrossingState<Domain>({4,5}, params),
+                                               AgentPolicyCrossingState<Domain>({5,6}, params)}));
+    belief_tracker.belief_update(*state, *state);
+
+    AgentPolicyCrossingState<Domain> true_agents_policy({5,5}, params);
+    Philox4x32 true_policy_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
+    std::vector<Reward> rewards;
+    Cost cost;
+    for(int i = 0; i < 100 && !state->is_terminal(); ++i) {
+      auto jointaction = JointAction(state->get_num_agents());
+      HypothesisEnsembleSearch<CrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic> ensemble(mcts_params);
+      ensemble.search(*state, belief_tracker);
+      EXPECT_EQ(ensemble.get_ego_action_values().size(), state->get_num_actions(CrossingState<Domain>::ego_agent_idx));
+      jointaction[CrossingState<Domain>::ego_agent_idx] = ensemble.returnBestAction();
+      for (auto agent_idx : state->get_other_agent_idx()) {
+        jointaction[agent_idx] = aconv<Domain>(true_agents_policy.act(state->get_agent_state(agent_idx),
+                                                                     state->get_ego_state(), true_policy_random_generator));
+      }
+      auto next_state = state->execute(jointaction, rewards, cost);
+      belief_tracker.belief_update(*state, *next_state);
+      state = next_state;
+    }
+    EXPECT_TRUE(state->ego_goal_reached());
+}
+
+TEST(hypothesis_ensemble_search, reproducible)
+{
+    // Workers draw from random streams of their thread index, results with an iteration budget only are equal between runs
+    using Ensemble = HypothesisEnsembleSearch<CrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic>;
+    const auto params = default_crossing_state_parameters<Domain>();
+    auto mcts_params = mcts_default_parameters();
+    mcts_params.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+    mcts_params.MAX_NUMBER_OF_ITERATIONS = 200;
+    mcts_params.random_heuristic.MAX_SEARCH_TIME = std::numeric_limits<double>::max();
+    mcts_params.hypothesis_ensemble.NUM_THREADS = 4;
+    HypothesisBeliefTracker belief_tracker(mcts_params);
+    auto state = std::make_shared<CrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), params,
+                  make_hypothesis_set<Domain>({AgentPolicyCrossingState<Domain>({4,5}, params),
+                                               AgentPolicyCrossingState<Domain>({5,6}, params)}));
+    belief_tracker.belief_update(*state, *state);
+
+    Ensemble ensemble(mcts_params);
+    ensemble.search(*state, belief_tracker);
+    Ensemble ensemble_repeated(mcts_params);
+    ensemble_repeated.search(*state, belief_tracker);
+    EXPECT_EQ(ensemble.numIterations(), 800u);
+    EXPECT_EQ(ensemble.get_ego_action_values(), ensemble_repeated.get_ego_action_values());
+    EXPECT_EQ(ensemble.returnBestAction(), ensemble_repeated.returnBestAction());
+
+    auto other_seed_params = mcts_params;
+    other_seed_params.RANDOM_SEED += 1;
+    Ensemble ensemble_other_seed(other_seed_params);
+    ensemble_other_seed.search(*state, belief_tracker);
+    EXPECT_NE(ensemble.get_ego_action_values(), ensemble_other_seed.get_ego_action_values());
+}
+
+TEST(hypothesis_ensemble_search, trace)
+{
+    using Ensemble = HypothesisEnsembleSearch<CrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic>;
+    const auto params = default_crossing_state_parameters<Domain>();
+    auto mcts_params = mcts_default_parameters();
+    mcts_params.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+    mcts_params.MAX_NUMBER_OF_ITERATIONS = 100;
+    mcts_params.hypothesis_ensemble.NUM_THREADS = 4;
+    HypothesisBeliefTracker belief_tracker(mcts_params);
+    auto state = std::make_shared<CrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), params,
+                  make_hypothesis_set<Domain>({AgentPolicyCrossingState<Domain>({4,5}, params),
+                                               AgentPolicyCrossingState<Domain>({5,6}, params)}));
+    belief_tracker.belief_update(*state, *state);
+
+    const char* tmp_dir = std::getenv("TEST_TMPDIR");
+    const std::string filename = std::string(tmp_dir ? tmp_dir : "/tmp") + "/hypothesis_ensemble_trace.json";
+    {
+        SearchTracer tracer(filename, 10);
+        Ensemble ensemble(mcts_params);
+        ensemble.set_tracer(&tracer);
+        ensemble.search(*state, belief_tracker);
+        tracer.close();
+        // Each worker: search span and 10 sampled iterations with selection, backpropagation and sampling spans
+        EXPECT_GE(tracer.get_num_events(), 4u * (1u + 10u * 4u));
+    }
+
+    std::ifstream file(filename);
+    const std::string trace((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    unsigned int num_searches = 0;
+    const std::string search_event = "\"name\":\"search\",";
+    for (auto pos = trace.find(search_event); pos != std::string::npos; pos = trace.find(search_event, pos + 1)) {
+        ++num_searches;
+    }
+    EXPECT_EQ(num_searches, 4u);
+    for (unsigned int thread_idx = 0; thread_idx < 4; ++thread_idx) {
+        EXPECT_NE(trace.find("\"args\":{\"name\":\"search thread " + std::to_string(thread_idx) + "\"}"), std::string::npos);
+    }
+    std::remove(filename.c_str());
+}
+
+TEST(crossing_state, search_record_replay)
+{
+    // Replaying a recorded search from its loaded inputs rebuilds the same root statistics
+    using CrossingStateMcts = Mcts<CrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic>;
+    const auto params = default_crossing_state_parameters<Domain>();
+    auto mcts_params = mcts_default_parameters();
+    mcts_params.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+    mcts_params.MAX_NUMBER_OF_ITERATIONS = 300;
+    mcts_params.random_heuristic.MAX_SEARCH_TIME = std::numeric_limits<double>::max();
+    HypothesisBeliefTracker belief_tracker(mcts_params);
+    auto state = std::make_shared<CrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), params,
+                  make_hypothesis_set<Domain>({AgentPolicyCrossingState<Domain>({4,5}, params),
+                                               AgentPolicyCrossingState<Domain>({-2,3}, params)}));
+    belief_tracker.belief_update(*state, *state);
+
+    const char* tmp_dir = std::getenv("TEST_TMPDIR");
+    const std::string filename = std::string(tmp_dir ? tmp_dir : "/tmp") + "/crossing_state_search.rec";
+    std::vector<double> recorded_action_values;
+    {
+        SearchRecorder recorder(filename);
+        // The first search advances the random generator of the belief tracker
+        for (unsigned int search = 0; search < 2; ++search) {
+            CrossingStateMcts mcts(mcts_params);
+            mcts.set_recorder(&recorder);
+            mcts.search(*state, belief_tracker);
+            recorded_action_values.clear();
+            for (ActionIdx action = 0; action < state->get_num_actions(state->get_ego_agent_idx()); ++action) {
+                recorded_action_values.push_back(mcts.rootActionValue(action));
+            }
+        }
+        EXPECT_EQ(recorder.get_num_records(), 2u);
+    }
+
+    const auto records = read_search_records(filename);
+    ASSERT_EQ(records.size(), 2u);
+    const auto& record = records.back();
+    EXPECT_EQ(record.search_type, typeid(CrossingStateMcts).name());
+    EXPECT_EQ(record.num_iterations, 300u);
+
+    RecordReader reader(record.inputs);
+    const auto replay_mcts_params = read_parameters(reader);
+    EXPECT_EQ(replay_mcts_params.MAX_NUMBER_OF_ITERATIONS, mcts_params.MAX_NUMBER_OF_ITERATIONS);
+    HypothesisBeliefTracker replay_belief_tracker(replay_mcts_params);
+    ASSERT_TRUE(reader.read<bool>());
+    replay_belief_tracker.load(reader);
+    CrossingStateParameters<Domain> replay_params;
+    const auto replay_state = CrossingState<Domain>::load(reader, replay_belief_tracker.get_current_hypothesis(),
+                                                          replay_params);
+    EXPECT_TRUE(reader.at_end());
+    EXPECT_EQ(replay_params.EGO_GOAL_POS, params.EGO_GOAL_POS);
+    EXPECT_EQ(replay_state->get_hypothesis_set()->size(), 2u);
+
+    CrossingStateMcts replay(replay_mcts_params);
+    replay.search(*replay_state, replay_belief_tracker);
+    EXPECT_EQ(replay.numIterations(), record.num_iterations);
+    EXPECT_EQ(replay.returnBestAction(), record.best_action);
+    for (ActionIdx action = 0; action < recorded_action_values.size(); ++action) {
+        EXPECT_EQ(replay.rootActionValue(action), recorded_action_values[action]);
+    }
+    std::remove(filename.c_str());
+}
+
+TEST(crossing_state, shared_memory_search)
+{
+    using Search = SharedMemorySearch<CrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic>;
+    const auto params = default_crossing_state_parameters<Domain>();
+    auto mcts_params = mcts_default_parameters();
+    mcts_params.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+    mcts_params.random_heuristic.MAX_SEARCH_TIME = std::numeric_limits<double>::max();
+    mcts_params.MAX_NUMBER_OF_ITERATIONS = 200;
+    HypothesisBeliefTracker belief_tracker(mcts_params);
+    auto state = std::make_shared<CrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), params,
+                  make_hypothesis_set<Domain>({AgentPolicyCrossingState<Domain>({4,5}, params),
+                                               AgentPolicyCrossingState<Domain>({5,6}, params)}));
+    belief_tracker.belief_update(*state, *state);
+    // Beliefs away from the priors which the workers must inherit from the coordinator
+    std::vector<Reward> rewards;
+    Cost cost;
+    auto jointaction = JointAction(state->get_num_agents(), aconv<Domain>(1));
+    jointaction[CrossingState<Domain>::ego_agent_idx] = 2;
+    const auto next_state = state->execute(jointaction, rewards, cost);
+    belief_tracker.belief_update(*state, *next_state);
+    state = next_state;
+    belief_tracker.sample_current_hypothesis();
+    const ActionIdx num_actions = state->get_num_actions(CrossingState<Domain>::ego_agent_idx);
+
+    // Workers forked by the search itself
+    Search search(mcts_params, 2, "/mamcts_crossing_state_" + std::to_string(getpid()));
+    search.search(*state, belief_tracker);
+    EXPECT_EQ(search.numIterations(), 400u);
+    EXPECT_LT(search.returnBestAction(), num_actions);
+
+    // Workers attaching to a segment of an external coordinator, as done from Python, with the
+    // coordinator's tracker restored from a record as after a transfer to another process
+    RecordWriter writer;
+    belief_tracker.save(writer);
+    HypothesisBeliefTracker received_belief_tracker(mcts_params);
+    RecordReader reader(writer.data());
+    received_belief_tracker.load(reader);
+    const std::string name = "/mamcts_crossing_state_external_" + std::to_string(getpid());
+    SharedRootStatistics coordinator(name, 2, num_actions);
+    run_forked_workers(2, [&](unsigned int worker_idx) {
+      Search::search_worker(*state, received_belief_tracker, mcts_params, name, worker_idx);
+    });
+    EXPECT_EQ(coordinator.num_published(), 2u);
+    EXPECT_EQ(coordinator.merged_num_iterations(), search.numIterations());
+    EXPECT_EQ(coordinator.best_action(), search.returnBestAction());
+    EXPECT_EQ(coordinator.merged_action_values(), search.get_ego_action_values());
+}
+
+TEST(crossing_state, plan_batch_equal_to_sequential)
+{
+    // Agents in different situations sharing one hypothesis set, planned in parallel
+    const auto params = default_crossing_state_parameters<Domain>();
+    auto mcts_params = mcts_default_parameters();
+    mcts_params.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+    mcts_params.random_heuristic.MAX_SEARCH_TIME = std::numeric_limits<double>::max();
+    mcts_params.MAX_NUMBER_OF_ITERATIONS = 100;
+    const auto hypothesis_set = make_hypothesis_set<Domain>({AgentPolicyCrossingState<Domain>({-2,1}, params),
+                                                             AgentPolicyCrossingState<Domain>({4,5}, params)});
+    AgentPolicyCrossingState<Domain> true_agents_policy({4,5}, params);
+    Philox4x32 true_policy_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
+
+    std::vector<HypothesisBeliefTracker> belief_trackers;
+    belief_trackers.reserve(6); // states refer to the hypothesis sampled by their tracker
+    std::vector<std::shared_ptr<CrossingState<Domain>>> states;
+    for (int num_steps = 0; num_steps < 6; ++num_steps) {
+      belief_trackers.emplace_back(mcts_params);
+      auto state = std::make_shared<CrossingState<Domain>>(belief_trackers.back().sample_current_hypothesis(), params,
+                                                           hypothesis_set);
+      belief_trackers.back().belief_update(*state, *state);
+      std::vector<Reward> rewards;
+      Cost cost;
+      for (int step = 0; step < num_steps && !state->is_terminal(); ++step) {
+        auto jointaction = JointAction(state->get_num_agents());
+        jointaction[CrossingState<Domain>::ego_agent_idx] = step % 3;
+        for (auto agent_idx : state->get_other_agent_idx()) {
+          jointaction[agent_idx] = aconv<Domain>(true_agents_policy.act(state->get_agent_state(agent_idx),
+                                                                       state->get_ego_state(), true_policy_random_generator));
+        }
+        auto next_state = state->execute(jointaction, rewards, cost);
+        belief_trackers.back().belief_update(*state, *next_state);
+        state = next_state;
+      }
+      states.push_back(state);
+    }
+
+    BatchPlanner<CrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic> planner(mcts_params, 4);
+    const auto best_actions = planner.plan_batch(states, belief_trackers);
+    ASSERT_EQ(best_actions.size(), states.size());
+    for (std::size_t idx = 0; idx < states.size(); ++idx) {
+      HypothesisBeliefTracker belief_tracker(belief_trackers[idx]);
+      const auto state = states[idx]->clone_with_hypothesis(belief_tracker.sample_current_hypothesis());
+      Mcts<CrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic> mcts(mcts_params);
+      mcts.search(*state, belief_tracker);
+      EXPECT_EQ(best_actions[idx], mcts.returnBestAction());
+    }
+    EXPECT_THROW(planner.plan_batch(states, {}), std::invalid_argument);
+}
+
+TEST(crossing_state, concurrent_searches_shared_hypothesis_set)
+{
+    // Separate searches on raw threads sharing one hypothesis set equal a sequential search
+    const auto params = default_crossing_state_parameters<Domain>();
+    auto mcts_params = mcts_default_parameters();
+    mcts_params.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+    mcts_params.random_heuristic.MAX_SEARCH_TIME = std::numeric_limits<double>::max();
+    mcts_params.MAX_NUMBER_OF_ITERATIONS = 200;
+    const auto hypothesis_set = make_hypothesis_set<Domain>({AgentPolicyCrossingState<Domain>({-2,1}, params),
+                                                             AgentPolicyCrossingState<Domain>({4,5}, params)});
+    const auto search = [&]() {
+      HypothesisBeliefTracker belief_tracker(mcts_params);
+      CrossingState<Domain> state(belief_tracker.sample_current_hypothesis(), params, hypothesis_set);
+      belief_tracker.belief_update(state, state);
+      Mcts<CrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic> mcts(mcts_params);
+      mcts.search(state, belief_tracker);
+      return mcts.returnBestAction();
+    };
+
+    const auto sequential_best_action = search();
+    std::vector<ActionIdx> best_actions(4);
+    std::vector<std::thread> threads;
+    for (std::size_t idx = 0; idx < best_actions.size(); ++idx) {
+      threads.emplace_back([&, idx]() { best_actions[idx] = search(); });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    for (const auto& best_action : best_actions) {
+      EXPECT_EQ(best_action, sequential_best_action);
+    }
+}
+
 TEST(crossing_state, mcts_goal_reached_wrong_hypothesis)
 {   
     const auto params = default_crossing_state_parameters<Domain>();
@@ -193,6 +700,7 @@ TEST(crossing_state, mcts_goal_reached_wrong_hypothesis)
     belief_tracker.belief_update(*state, *next_state);
 
     AgentPolicyCrossingState<Domain> true_agents_policy({-2,-2}, params);
+    Philox4x32 true_policy_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
 
     std::vector<Reward> rewards;
     Cost cost;
@@ -207,7 +715,7 @@ TEST(crossing_state, mcts_goal_reached_wrong_hypothesis)
       for (auto agent_idx : state->get_other_agent_idx()) {
         // Other agents act according to unknown true agents policy
         const auto action = true_agents_policy.act(state->get_agent_state(agent_idx),
-                                                    state->get_ego_state());
+                                                    state->get_ego_state(), true_policy_random_generator);
         jointaction[agent_idx] = aconv<Domain>(action);
       }
       std::cout << "Step " << i << ", Action = " << jointaction << ", " << state->sprintf() << std::endl;
@@ -227,6 +735,235 @@ TEST(crossing_state, mcts_goal_reached_wrong_hypothesis)
 
 }
 
+TEST(compact_crossing_state, equal_to_crossing_state)
+{
+    auto params = default_crossing_state_parameters<Domain>();
+    params.NUM_OTHER_AGENTS = 4;
+    HypothesisBeliefTracker belief_tracker(mcts_default_parameters());
+    const auto hypothesis = make_hypothesis_set<Domain>({AgentPolicyCrossingState<Domain>({4,5}, params),
+                                                        AgentPolicyCrossingState<Domain>({-2,1}, params)});
+    auto state = std::make_shared<CrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), params, hypothesis);
+    auto compact_state = std::make_shared<CompactCrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), *state, params);
+    belief_tracker.belief_update(*state, *state);
+
+    AgentPolicyCrossingState<Domain> true_agents_policy({-2,3}, params);
+    Philox4x32 true_policy_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
+    std::vector<Reward> rewards, compact_rewards;
+    Cost cost, compact_cost;
+    for(int i = 0; i < 30 && !state->is_terminal(); ++i) {
+      auto jointaction = JointAction(state->get_num_agents());
+      jointaction[CrossingState<Domain>::ego_agent_idx] = i % state->get_num_actions(0);
+      for (auto agent_idx : state->get_other_agent_idx()) {
+        jointaction[agent_idx] = aconv<Domain>(true_agents_policy.act(state->get_agent_state(agent_idx),
+                                                                     state->get_ego_state(), true_policy_random_generator));
+      }
+      state = state->execute(jointaction, rewards, cost);
+      compact_state = compact_state->execute(jointaction, compact_rewards, compact_cost)->clone();
+
+      EXPECT_EQ(state->sprintf(), compact_state->sprintf());
+      EXPECT_EQ(rewards, compact_rewards);
+      EXPECT_EQ(cost, compact_cost);
+      EXPECT_EQ(state->is_terminal(), compact_state->is_terminal());
+      EXPECT_EQ(state->ego_collided(), compact_state->ego_collided());
+      EXPECT_EQ(state->ego_goal_reached(), compact_state->ego_goal_reached());
+      EXPECT_EQ(state->min_distance_to_ego(), compact_state->min_distance_to_ego());
+      for (auto agent_idx : state->get_other_agent_idx()) {
+        EXPECT_EQ(state->get_last_action(agent_idx), compact_state->get_last_action(agent_idx));
+        EXPECT_EQ(state->get_probability(1, agent_idx, 1), compact_state->get_probability(1, agent_idx, 1));
+      }
+    }
+    EXPECT_LT(sizeof(CompactCrossingState<Domain>), sizeof(CrossingState<Domain>));
+
+    // Interned actions are not supported by the compact state
+    params.INTERN_OTHER_ACTIONS = true;
+    EXPECT_THROW(CompactCrossingState<Domain>(belief_tracker.sample_current_hypothesis(), params), std::invalid_argument);
+    EXPECT_THROW(CompactCrossingState<Domain>(belief_tracker.sample_current_hypothesis(), *state, params), std::invalid_argument);
+
+    // Neither do scenes beyond the capacity of the agent block or the range of the 16 bit storage
+    params.INTERN_OTHER_ACTIONS = false;
+    params.NUM_OTHER_AGENTS = CompactCrossingState<Domain>::MAX_NUM_AGENTS;
+    EXPECT_THROW(CompactCrossingState<Domain>(belief_tracker.sample_current_hypothesis(), params), std::invalid_argument);
+    params.NUM_OTHER_AGENTS = CompactCrossingState<Domain>::MAX_NUM_AGENTS - 1;
+    EXPECT_NO_THROW(CompactCrossingState<Domain>(belief_tracker.sample_current_hypothesis(), params));
+    params.CHAIN_LENGTH = std::numeric_limits<std::int16_t>::max() + 1;
+    EXPECT_THROW(CompactCrossingState<Domain>(belief_tracker.sample_current_hypothesis(), params), std::invalid_argument);
+    params.CHAIN_LENGTH = 21;
+    params.MIN_VELOCITY_OTHER = std::numeric_limits<std::int16_t>::lowest() - 1;
+    EXPECT_THROW(CompactCrossingState<Domain>(belief_tracker.sample_current_hypothesis(), params), std::invalid_argument);
+}
+
+TEST(compact_crossing_state, mcts_goal_reached)
+{
+    const auto params = default_crossing_state_parameters<Domain>();
+    HypothesisBeliefTracker belief_tracker(mcts_default_parameters());
+    auto state = std::make_shared<CompactCrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), params,
+                                    make_hypothesis_set<Domain>({AgentPolicyCrossingState<Domain>({5,5}, params)}));
+    belief_tracker.belief_update(*state, *state);
+
+    AgentPolicyCrossingState<Domain> true_agents_policy({5,5}, params);
+    Philox4x32 true_policy_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
+    std::vector<Reward> rewards;
+    Cost cost;
+    for(int i = 0; i < 100 && !state->is_terminal(); ++i) {
+      auto jointaction = JointAction(state->get_num_agents());
+      Mcts<CompactCrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic> mcts(mcts_default_parameters());
+      mcts.search(*state, belief_tracker);
+      jointaction[CompactCrossingState<Domain>::ego_agent_idx] = mcts.returnBestAction();
+      for (auto agent_idx : state->get_other_agent_idx()) {
+        jointaction[agent_idx] = aconv<Domain>(true_agents_policy.act(state->get_agent_state(agent_idx),
+                                                                     state->get_ego_state(), true_policy_random_generator));
+      }
+      auto next_state = state->execute(jointaction, rewards, cost);
+      belief_tracker.belief_update(*state, *next_state);
+      state = next_state;
+    }
+    EXPECT_TRUE(state->ego_goal_reached());
+}
+
+TEST(compact_crossing_state, tree_state_bytes)
+{
+    // State bytes include the agent data CrossingState holds on the heap, the compact state holds it inline
+    const auto params = default_crossing_state_parameters<Domain>();
+    auto mcts_params = mcts_default_parameters();
+    mcts_params.MAX_NUMBER_OF_ITERATIONS = 200;
+    HypothesisBeliefTracker belief_tracker(mcts_params);
+    const auto hypothesis_set = make_hypothesis_set<Domain>({AgentPolicyCrossingState<Domain>({5,5}, params)});
+    CrossingState<Domain> state(belief_tracker.sample_current_hypothesis(), params, hypothesis_set);
+    CompactCrossingState<Domain> compact_state(belief_tracker.get_current_hypothesis(), state, params);
+    belief_tracker.belief_update(state, state);
+    const std::size_t num_agents = params.NUM_OTHER_AGENTS + 1;
+
+    Mcts<CrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic> mcts(mcts_params);
+    mcts.search(state, belief_tracker);
+    const auto statistics = mcts.treeStatistics();
+    EXPECT_GE(statistics.state_bytes,
+              statistics.num_nodes * (sizeof(CrossingState<Domain>) + (num_agents - 1) * sizeof(AgentState<Domain>)));
+
+    Mcts<CompactCrossingState<Domain>, UctStatistic, HypothesisStatistic, RandomHeuristic> compact_mcts(mcts_params);
+    compact_mcts.search(compact_state, belief_tracker);
+    const auto compact_statistics = compact_mcts.treeStatistics();
+    EXPECT_EQ(compact_statistics.state_bytes, compact_statistics.num_nodes * sizeof(CompactCrossingState<Domain>));
+}
+
+TEST(crossing_state_batch_simulator, equal_to_crossing_state)
+{
+    auto params = default_crossing_state_parameters<Domain>();
+    params.NUM_OTHER_AGENTS = 3;
+    std::unordered_map<AgentIdx, HypothesisId> current_agents_hypothesis = {{1, 0}, {2, 1}, {3, 2}};
+    auto state = std::make_shared<CrossingState<Domain>>(current_agents_hypothesis, params,
+                  make_hypothesis_set<Domain>({AgentPolicyCrossingState<Domain>({5,5}, params),
+                                               AgentPolicyCrossingState<Domain>({-2,-2}, params),
+                                               AgentPolicyCrossingState<Domain>({2,2}, params)}));
+    const std::size_t batch_size = 37;
+    CrossingStateBatchSimulator<Domain> simulator(params, 3, batch_size, 1000);
+    std::vector<std::shared_ptr<CrossingState<Domain>>> lane_states(batch_size, state);
+    std::vector<Reward> expected_rewards(batch_size, 0.0f);
+    for (std::size_t lane = 0; lane < batch_size; ++lane) {
+      simulator.set_episode(lane, *state);
+    }
+
+    // Deterministic hypotheses: replay the ego actions chosen by the simulator on CrossingState
+    Philox4x32 random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
+    std::vector<Reward> rewards;
+    Cost cost;
+    double discount = 0.9;
+    for (int i = 0; i < 20 && simulator.num_alive() > 0; ++i) {
+      std::vector<bool> alive(batch_size);
+      for (std::size_t lane = 0; lane < batch_size; ++lane) {
+        alive[lane] = simulator.is_alive(lane);
+      }
+      simulator.step(discount);
+      for (std::size_t lane = 0; lane < batch_size; ++lane) {
+        if(!alive[lane]) {
+          continue;
+        }
+        auto& lane_state = lane_states[lane];
+        auto jointaction = JointAction(lane_state->get_num_agents());
+        jointaction[0] = simulator.get_ego_state(lane).last_action - params.MIN_VELOCITY_EGO;
+        for (auto agent_idx : lane_state->get_other_agent_idx()) {
+          jointaction[agent_idx] = lane_state->plan_action_current_hypothesis(agent_idx, random_generator);
+        }
+        lane_state = lane_state->execute(jointaction, rewards, cost);
+        expected_rewards[lane] += discount*rewards[0];
+
+        EXPECT_EQ(lane_state->get_ego_state().x_pos, simulator.get_ego_state(lane).x_pos);
+        for (auto agent_idx : lane_state->get_other_agent_idx()) {
+          EXPECT_EQ(lane_state->get_agent_state(agent_idx).x_pos, simulator.get_agent_state(lane, agent_idx).x_pos);
+          EXPECT_EQ(lane_state->get_agent_state(agent_idx).last_action, simulator.get_agent_state(lane, agent_idx).last_action);
+        }
+        EXPECT_EQ(lane_state->is_terminal(), !simulator.is_alive(lane));
+        EXPECT_NEAR(expected_rewards[lane], simulator.get_accum_rewards()[lane], 0.001);
+      }
+      discount *= 0.9;
+    }
+}
+
+TEST(crossing_state_batch_heuristic, mcts_goal_reached)
+{
+    const auto params = default_crossing_state_parameters<Domain>();
+    auto mcts_params = mcts_default_parameters();
+    mcts_params.MAX_NUMBER_OF_ITERATIONS = 2000;
+    HypothesisBeliefTracker belief_tracker(mcts_params);
+    auto state = std::make_shared<CrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), params,
+                  make_hypothesis_set<Domain>({AgentPolicyCrossingState<Domain>({4,5}, params),
+                                               AgentPolicyCrossingState<Domain>({5,6}, params)}));
+    belief_tracker.belief_update(*state, *state);
+
+    AgentPolicyCrossingState<Domain> true_agents_policy({5,5}, params);
+    Philox4x32 true_policy_random_generator(params.OTHER_AGENTS_POLICY_RANDOM_SEED);
+    std::vector<Reward> rewards;
+    Cost cost;
+    for(int i = 0; i < 100 && !state->is_terminal(); ++i) {
+      auto jointaction = JointAction(state->get_num_agents());
+      Mcts<CrossingState<Domain>, UctStatistic, HypothesisStatistic, CrossingStateBatchHeuristic<Domain>> mcts(mcts_params);
+      mcts.search(*state, belief_tracker);
+      jointaction[CrossingState<Domain>::ego_agent_idx] = mcts.returnBestAction();
+      for (auto agent_idx : state->get_other_agent_idx()) {
+        jointaction[agent_idx] = aconv<Domain>(true_agents_policy.act(state->get_agent_state(agent_idx),
+                                                                     state->get_ego_state(), true_policy_random_generator));
+      }
+      auto next_state = state->execute(jointaction, rewards, cost);
+      belief_tracker.belief_update(*state, *next_state);
+      state = next_state;
+    }
+    EXPECT_TRUE(state->ego_goal_reached());
+}
+
+TEST(crossing_state_batch_heuristic, multiple_leaves)
+{
+    using Heuristic = CrossingStateBatchHeuristic<Domain>;
+    using Node = StageNode<CrossingState<Domain>, UctStatistic, HypothesisStatistic, Heuristic>;
+    const auto params = default_crossing_state_parameters<Domain>();
+    auto mcts_params = mcts_default_parameters();
+    mcts_params.MAX_SEARCH_DEPTH = 100;
+    mcts_params.random_heuristic.MAX_SEARCH_TIME = std::numeric_limits<double>::max();
+    HypothesisBeliefTracker belief_tracker(mcts_params);
+    auto state = std::make_shared<CrossingState<Domain>>(belief_tracker.sample_current_hypothesis(), params,
+                  make_hypothesis_set<Domain>({AgentPolicyCrossingState<Domain>({4,5}, params),
+                                               AgentPolicyCrossingState<Domain>({5,6}, params)}));
+    belief_tracker.belief_update(*state, *state);
+    belief_tracker.sample_current_hypothesis();
+    const auto node = std::make_shared<Node>(nullptr, state->clone(), JointAction(), 1, mcts_params);
+    const auto too_deep_node = std::make_shared<Node>(nullptr, state->clone(), JointAction(), 101, mcts_params);
+
+    // The lanes of the first leaf are seeded as in a single leaf call
+    Heuristic single_leaf_heuristic(mcts_params);
+    const auto single_leaf_values = single_leaf_heuristic.calculate_heuristic_values(node);
+    Heuristic multi_leaf_heuristic(mcts_params);
+    const auto multi_leaf_values = multi_leaf_heuristic.calculate_heuristic_values(
+                                                std::vector<std::shared_ptr<Node>>{node, too_deep_node, node});
+    ASSERT_EQ(multi_leaf_values.size(), 3u);
+    EXPECT_EQ(multi_leaf_values[0].first.print_node_information(), single_leaf_values.first.print_node_information());
+    EXPECT_NE(single_leaf_values.first.print_node_information(), "V=0, N=0");
+    EXPECT_EQ(multi_leaf_values[1].first.print_node_information(), "V=0, N=0");
+    EXPECT_NE(multi_leaf_values[2].first.print_node_information(), "V=0, N=0");
+
+    // Reused simulator for the next single leaf calls
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_NE(multi_leaf_heuristic.calculate_heuristic_values(node).first.print_node_information(), "V=0, N=0");
+    }
+}
+
 TEST(episode_runner, four_agents_reached_goal) {
   auto params = default_crossing_state_parameters<Domain>();
   params.NUM_OTHER_AGENTS = 4;
@@ -250,6 +987,34 @@ TEST(episode_runner, four_agents_reached_goal) {
   EXPECT_TRUE(std::get<4>(result).second);
 }
 
+TEST(episode_runner, five_agents_stage_widening_reached_goal) {
+  auto params = default_crossing_state_parameters<Domain>();
+  params.NUM_OTHER_AGENTS = 5;
+  params.CHAIN_LENGTH = 41;
+  params.EGO_GOAL_POS = 26;
+  auto mcts_params = mcts_default_parameters();
+  mcts_params.stage_node.PROGRESSIVE_WIDENING = true;
+  mcts_params.stage_node.PROGRESSIVE_WIDENING_K = 2;
+  mcts_params.stage_node.PROGRESSIVE_WIDENING_ALPHA = 0.5;
+  auto runner = CrossingStateEpisodeRunner<Domain>(
+      { {1 , AgentPolicyCrossingState<Domain>({5,5}, params)},
+        {2 , AgentPolicyCrossingState<Domain>({4,4}, params)},
+        {3 , AgentPolicyCrossingState<Domain>({6,6}, params)},
+        {4 , AgentPolicyCrossingState<Domain>({-2,-2}, params)},
+        {5 , AgentPolicyCrossingState<Domain>({5,6}, params)}},
+      {AgentPolicyCrossingState<Domain>({4,5}, params),
+        AgentPolicyCrossingState<Domain>({-2,3}, params),
+        AgentPolicyCrossingState<Domain>({5,6}, params)},
+        mcts_params,
+        params,
+        30,
+        200,
+        10000,
+        nullptr);
+  auto result = runner.run();
+  EXPECT_TRUE(std::get<4>(result).second);
+}
+
 TEST(episode_runner, run_some_steps) {
   auto params = default_crossing_state_parameters<Domain>();
   params.CHAIN_LENGTH = 3;
@@ -16,6 +16,7 @@ def default_mcts_parameters():
     parameters = MctsParameters()
     parameters.DISCOUNT_FACTOR = 0.9
     parameters.RANDOM_SEED = 1000
+    parameters.THREAD_IDX = 0
     parameters.MAX_SEARCH_TIME = 1000
     parameters.MAX_NUMBER_OF_ITERATIONS = 10000
     parameters.MAX_SEARCH_DEPTH = 1000
@@ -16,6 +16,7 @@ def default_mcts_parameters():
     parameters = MctsParameters()
     parameters.DISCOUNT_FACTOR = 0.9
     parameters.RANDOM_SEED = 1000
+    parameters.THREAD_IDX = 0
     parameters.MAX_SEARCH_TIME = 1000
     parameters.MAX_NUMBER_OF_ITERATIONS = 10000
     parameters.MAX_SEARCH_DEPTH = 1000
@@ -87,5 +88,79 @@ class PickleTests(unittest.TestCase):
         episode_result = runner.run(False)
         print(episode_result)
 
+    def test_episode_runner_profile(self):
+        from mamcts import SearchPhase, SearchProfile
+        crossing_state_params = CrossingStateDefaultParametersInt()
+        runner = CrossingStateEpisodeRunnerInt(
+            {1 : AgentPolicyCrossingStateInt((5,5), crossing_state_params),
+             2 : AgentPolicyCrossingStateInt((5,5), crossing_state_params) },
+            [AgentPolicyCrossingStateInt((4,5), crossing_state_params),
+             AgentPolicyCrossingStateInt((5,6), crossing_state_params)],
+             default_mcts_parameters(),
+             crossing_state_params,
+             30,
+             200,
+             10000,
+             None)
+        runner.step()
+        profile = runner.profile
+        print(profile)
+        if SearchProfile.enabled:
+            self.assertGreater(profile.calls(SearchPhase.BACKPROPAGATION), 0)
+            self.assertEqual(sum(profile.latency_histogram(SearchPhase.ROLLOUT)), profile.calls(SearchPhase.ROLLOUT))
+        else:
+            self.assertEqual(profile.calls(SearchPhase.BACKPROPAGATION), 0)
+        self.assertIn("hypothesis_sampling", profile.as_dict())
+
+    def test_episode_runner_tree_statistics(self):
+        crossing_state_params = CrossingStateDefaultParametersInt()
+        runner = CrossingStateEpisodeRunnerInt(
+            {1 : AgentPolicyCrossingStateInt((5,5), crossing_state_params),
+             2 : AgentPolicyCrossingStateInt((5,5), crossing_state_params) },
+            [AgentPolicyCrossingStateInt((4,5), crossing_state_params),
+             AgentPolicyCrossingStateInt((5,6), crossing_state_params)],
+             default_mcts_parameters(),
+             crossing_state_params,
+             30,
+             200,
+             10000,
+             None)
+        runner.step()
+        statistics = runner.tree_statistics
+        print(statistics)
+        self.assertGreater(statistics.num_nodes, 1)
+        self.assertEqual(statistics.num_leaf_nodes + statistics.num_interior_nodes, statistics.num_nodes)
+        self.assertEqual(sum(statistics.nodes_per_depth), statistics.num_nodes)
+        self.assertGreater(statistics.branching_factor(0), 0)
+        self.assertGreater(statistics.total_bytes, 0)
+
+    def test_episode_runner_trace(self):
+        import json, os, tempfile
+        from mamcts import SearchTracer
+        crossing_state_params = CrossingStateDefaultParametersInt()
+        runner = CrossingStateEpisodeRunnerInt(
+            {1 : AgentPolicyCrossingStateInt((5,5), crossing_state_params),
+             2 : AgentPolicyCrossingStateInt((5,5), crossing_state_params) },
+            [AgentPolicyCrossingStateInt((4,5), crossing_state_params),
+             AgentPolicyCrossingStateInt((5,6), crossing_state_params)],
+             default_mcts_parameters(),
+             crossing_state_params,
+             30,
+             200,
+             10000,
+             None)
+        filename = os.path.join(tempfile.mkdtemp(), "trace.json")
+        tracer = SearchTracer(filename, sampling_interval=10)
+        runner.set_tracer(tracer)
+        runner.step()
+        runner.step()
+        tracer.close()
+        with open(filename) as trace_file:
+            events = json.load(trace_file)
+        self.assertEqual(len([e for e in events if e["name"] == "step"]), 2)
+        self.assertEqual(len([e for e in events if e["name"] == "search"]), 2)
+        self.assertGreater(len([e for e in events if e["name"] == "iteration"]), 0)
+        self.assertEqual(tracer.num_dropped, 0)
+
 if __name__ == '__main__':
     unittest.main()
\ No newline at end of file
@@ -0,0 +1,64 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef MCTS_ACTION_INTERNING_H
+#define MCTS_ACTION_INTERNING_H
+
+#include <cmath>
+#include <vector>
+#include "mcts/state.h"
+#include "mcts/common.h"
+
+namespace mcts {
+
+// Maps actions of a continuous (or sparse) domain to dense action indices 0,1,2,... in order of
+// first appearance. With a resolution > 0 actions are snapped to a grid of this resolution before
+// interning, such that nearby actions share an index and the represented action is the grid value.
+template <typename Domain>
+class ActionInterning {
+public:
+    explicit ActionInterning(const Domain& resolution = Domain(0)) :
+                            resolution_(resolution),
+                            actions_() {}
+
+    ActionIdx intern(const Domain& action) {
+        const Domain value = quantize(action);
+        // Few actions exist per agent and node, a linear search beats hashing here
+        for (ActionIdx action_idx = 0; action_idx < actions_.size(); ++action_idx) {
+            if (actions_[action_idx] == value) {
+                return action_idx;
+            }
+        }
+        actions_.push_back(value);
+        return actions_.size() - 1;
+    }
+
+    const Domain& get_action(const ActionIdx& action_idx) const {
+        MCTS_EXPECT_TRUE(action_idx < actions_.size());
+        return actions_[action_idx];
+    }
+
+    Domain quantize(const Domain& action) const {
+        if (resolution_ > 0) {
+            return static_cast<Domain>(std::round(static_cast<double>(action) / resolution_) * resolution_);
+        }
+        return action;
+    }
+
+    ActionIdx size() const { return actions_.size(); }
+
+    const std::vector<Domain>& get_actions() const { return actions_; }
+
+    const Domain& get_resolution() const { return resolution_; }
+
+private:
+    Domain resolution_;
+    std::vector<Domain> actions_; // index -> represented action
+};
+
+} // namespace mcts
+
+#endif // MCTS_ACTION_INTERNING_H
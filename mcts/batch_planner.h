@@ -0,0 +1,103 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef MCTS_BATCH_PLANNER_H
+#define MCTS_BATCH_PLANNER_H
+
+#include <functional>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+#include "mcts/mcts.h"
+#include "mcts/thread_pool.h"
+#include "mcts/hypothesis/hypothesis_belief_tracker.h"
+
+namespace mcts {
+
+/*
+ * Plans many independent problems, e.g. several vehicles or scenarios per tick, with one Mcts search each
+ * on a thread pool kept alive across calls. Every search uses the same parameters such that the best action
+ * of a problem equals the one of a sequential search. Hypothesis states are cloned to refer to their own
+ * copy of the belief tracker, the immutable hypothesis set is shared and policies draw from the search's generators.
+ */
+template<class S, class SE, class SO, class H>
+class BatchPlanner {
+public:
+    // num_threads = 0 uses the hardware concurrency
+    BatchPlanner(const MctsParameters& mcts_parameters, const unsigned int& num_threads = 0) :
+                            mcts_parameters_(mcts_parameters),
+                            thread_pool_(num_threads),
+                            search_observer_() {}
+
+    template< class Q = S>
+    typename std::enable_if<std::is_base_of<RequiresHypothesis, Q>::value, std::vector<ActionIdx>>::type
+    plan_batch(const std::vector<std::shared_ptr<S>>& states, const std::vector<HypothesisBeliefTracker>& belief_trackers) {
+        if (states.size() != belief_trackers.size()) {
+            throw std::invalid_argument("Each state requires a belief tracker");
+        }
+        std::vector<std::future<ActionIdx>> best_actions;
+        for (std::size_t idx = 0; idx < states.size(); ++idx) {
+            best_actions.push_back(thread_pool_.submit([this, &states, &belief_trackers, idx]() {
+                HypothesisBeliefTracker belief_tracker(belief_trackers[idx]);
+                const auto state = states[idx]->clone_with_hypothesis(belief_tracker.sample_current_hypothesis());
+                Mcts<S, SE, SO, H> mcts(mcts_parameters_);
+                mcts.search(*state, belief_tracker);
+                if(search_observer_) {
+                    search_observer_(mcts);
+                }
+                return mcts.returnBestAction();
+            }));
+        }
+        return collect(best_actions);
+    }
+
+    // States must not share mutable members, e.g. random generators, with each other
+    template< class Q = S>
+    typename std::enable_if<!std::is_base_of<RequiresHypothesis, Q>::value, std::vector<ActionIdx>>::type
+    plan_batch(const std::vector<std::shared_ptr<S>>& states) {
+        std::vector<std::future<ActionIdx>> best_actions;
+        for (std::size_t idx = 0; idx < states.size(); ++idx) {
+            best_actions.push_back(thread_pool_.submit([this, &states, idx]() {
+                Mcts<S, SE, SO, H> mcts(mcts_parameters_);
+                mcts.search(*states[idx]);
+                if(search_observer_) {
+                    search_observer_(mcts);
+                }
+                return mcts.returnBestAction();
+            }));
+        }
+        return collect(best_actions);
+    }
+
+    unsigned int num_threads() const { return thread_pool_.num_threads(); }
+
+    // Called on the pool threads with each finished search, e.g. to validate the trees
+    void set_search_observer(const std::function<void(const Mcts<S, SE, SO, H>&)>& search_observer) {
+        search_observer_ = search_observer;
+    }
+
+private:
+    static std::vector<ActionIdx> collect(std::vector<std::future<ActionIdx>>& best_actions) {
+        // Wait for all searches before rethrowing, running tasks reference the inputs
+        for (auto& best_action : best_actions) {
+            best_action.wait();
+        }
+        std::vector<ActionIdx> result;
+        for (auto& best_action : best_actions) {
+            result.push_back(best_action.get());
+        }
+        return result;
+    }
+
+    const MctsParameters mcts_parameters_;
+    ThreadPool thread_pool_;
+    std::function<void(const Mcts<S, SE, SO, H>&)> search_observer_;
+};
+
+} // namespace mcts
+
+#endif // MCTS_BATCH_PLANNER_H
@@ -57,7 +57,7 @@ class UctTest;
         } \
     } while (false)
 #else
-#   define MCTS_EXPECT_TRUE(condition, message) do { } while (false)
+#   define MCTS_EXPECT_TRUE(condition, ...) do { } while (false)
 #endif
 
 struct RequiresHypothesis 
@@ -66,5 +66,8 @@ struct RequiresHypothesis
 struct RequiresCost 
 {};
 
+struct RequiresRolloutActions
+{};
+
 } // namespace mcts
 #endif
@@ -13,12 +13,13 @@
 
  namespace mcts {
 // assumes all agents have equal number of actions and the same node statistic
-class RandomHeuristic :  public mcts::Heuristic<RandomHeuristic>, mcts::RandomGenerator
+class RandomHeuristic :  public mcts::Heuristic<RandomHeuristic>, public mcts::RandomGenerator
 {
 public:
     RandomHeuristic(const MctsParameters& mcts_parameters) :
             mcts::Heuristic<RandomHeuristic>(mcts_parameters),
-            RandomGenerator(mcts_parameters.RANDOM_SEED) {}
+            RandomGenerator(mcts_parameters.RANDOM_SEED, random_stream(mcts_parameters.THREAD_IDX, 0)),
+            num_rollout_steps_(0) {}
 
     template<class S, class SE, class SO, class H>
     std::pair<SE, std::unordered_map<AgentIdx, SO>> calculate_heuristic_values(const std::shared_ptr<StageNode<S,SE,SO,H>> &node) {
@@ -53,21 +54,37 @@ public:
         double modified_discount_factor = k_discount_factor;
         int num_iterations = 0;
         auto current_depth = node->get_depth();
+
+        // Action sequences of the rollout are only recorded for statistics which use them
+        const bool record_ego_actions = std::is_base_of<RequiresRolloutActions, SE>::value;
+        const bool record_other_actions = std::is_base_of<RequiresRolloutActions, SO>::value;
+        std::vector<ActionIdx> ego_rollout_actions;
+        std::unordered_map<AgentIdx, std::vector<ActionIdx>> other_rollout_actions;
         
+        MCTS_PERF_REGION(PERF_ROLLOUT_LOOP);
         while((!state->is_terminal())&&(num_iterations<mcts_parameters_.random_heuristic.MAX_NUMBER_OF_ITERATIONS)&&
                 (std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::high_resolution_clock::now() - start ).count() 
                     < mcts_parameters_.random_heuristic.MAX_SEARCH_TIME ) &&
                   current_depth <= mcts_parameters_.MAX_SEARCH_DEPTH) {
             // Build joint action by calling statistics for each agent
+            const auto& other_agent_idx = state->get_other_agent_idx();
             JointAction jointaction(state->get_num_agents());
             SE ego_statistic(state->get_num_actions(state->get_ego_agent_idx()),
                           state->get_ego_agent_idx(),
                           mcts_parameters_);
+            ego_statistic.set_random_stream(draw_random_stream());
             jointaction[S::ego_agent_idx] = ego_statistic.choose_next_action(*state);
+            if(record_ego_actions) {
+              ego_rollout_actions.push_back(jointaction[S::ego_agent_idx]);
+            }
             AgentIdx action_idx = 1;
-            for (const auto& ai : state->get_other_agent_idx()) {
+            for (const auto& ai : other_agent_idx) {
               SO statistic(state->get_num_actions(ai), ai, mcts_parameters_);
+              statistic.set_random_stream(draw_random_stream());
               jointaction[action_idx] = statistic.choose_next_action(*state);
+              if(record_other_actions) {
+                other_rollout_actions[ai].push_back(jointaction[action_idx]);
+              }
               action_idx++;
             }
 
@@ -77,7 +94,7 @@ public:
 
             ego_accum_reward += modified_discount_factor*step_rewards[S::ego_agent_idx];
             AgentIdx reward_idx = 1;
-            for (const auto& ai : state->get_other_agent_idx()) {
+            for (const auto& ai : other_agent_idx) {
               other_accum_rewards[ai] = modified_discount_factor*step_rewards[reward_idx];
               action_idx++;
             }
@@ -87,23 +104,42 @@ public:
 
             state = new_state->clone();
             num_iterations +=1;
+            num_rollout_steps_ += 1;
             current_depth += 1;
          };
         // generate an extra node statistic for each agent
         SE ego_heuristic(0, node->get_state()->get_ego_agent_idx(), mcts_parameters_);
         ego_heuristic.set_heuristic_estimate(ego_accum_reward, accum_cost);
+        set_rollout_actions(ego_heuristic, ego_rollout_actions);
         std::unordered_map<AgentIdx, SO> other_heuristic_estimates;
         AgentIdx reward_idx=1;
         for (auto agent_idx : node->get_state()->get_other_agent_idx())
         {
             SO statistic(0, agent_idx, mcts_parameters_);
             statistic.set_heuristic_estimate(other_accum_rewards[agent_idx], accum_cost);
+            set_rollout_actions(statistic, other_rollout_actions[agent_idx]);
             other_heuristic_estimates.insert(std::pair<AgentIdx, SO>(agent_idx, statistic));
             reward_idx++;
         }
         return std::pair<SE, std::unordered_map<AgentIdx, SO>>(ego_heuristic, other_heuristic_estimates);
     }
 
+    // Rollout steps over all heuristic calculations of this heuristic
+    unsigned long get_num_rollout_steps() const { return num_rollout_steps_; }
+
+private:
+    template<class Stat>
+    static typename std::enable_if<std::is_base_of<RequiresRolloutActions, Stat>::value>::type
+    set_rollout_actions(Stat& statistic, const std::vector<ActionIdx>& rollout_actions) {
+        statistic.set_rollout_actions(rollout_actions);
+    }
+
+    template<class Stat>
+    static typename std::enable_if<!std::is_base_of<RequiresRolloutActions, Stat>::value>::type
+    set_rollout_actions(Stat& statistic, const std::vector<ActionIdx>& rollout_actions) {}
+
+    unsigned long num_rollout_steps_;
+
 };
 
  } // namespace mcts
@@ -13,6 +13,8 @@
 #include "mcts/mcts_parameters.h"
 #include "mcts/hypothesis/common.h"
 #include "mcts/random_generator.h"
+#include "mcts/perf_counters.h"
+#include "mcts/search_recorder.h"
 #include "mcts/hypothesis/hypothesis_state.h"
 
 
@@ -28,7 +30,8 @@ class HypothesisBeliefTracker : public mcts::RandomGenerator {
 
 
     HypothesisBeliefTracker(const MctsParameters& mcts_parameters) : 
-                            RandomGenerator(mcts_parameters.hypothesis_belief_tracker.RANDOM_SEED_HYPOTHESIS_SAMPLING),
+                            RandomGenerator(mcts_parameters.hypothesis_belief_tracker.RANDOM_SEED_HYPOTHESIS_SAMPLING,
+                                            random_stream(mcts_parameters.THREAD_IDX, 0)),
                             history_length_(mcts_parameters.hypothesis_belief_tracker.HISTORY_LENGTH),
                             probability_discount_(mcts_parameters.hypothesis_belief_tracker.PROBABILITY_DISCOUNT),
                             posterior_type_(static_cast<PosteriorType>(mcts_parameters.hypothesis_belief_tracker.POSTERIOR_TYPE)),
@@ -36,6 +39,7 @@ class HypothesisBeliefTracker : public mcts::RandomGenerator {
                               mcts_parameters.hypothesis_belief_tracker.FIXED_HYPOTHESIS_SET)),
                             tracked_probabilities_(),
                             tracked_beliefs_(),
+                            tracked_agents_(),
                             current_sampled_hypothesis_() {};
 
     template <typename S>
@@ -52,12 +56,26 @@ class HypothesisBeliefTracker : public mcts::RandomGenerator {
 
     void update_fixed_hypothesis_set(const std::unordered_map<AgentIdx, HypothesisId>& hypothesis_set);
 
+    const std::unordered_map<AgentIdx, HypothesisId>& get_fixed_hypothesis_set() const {
+      return fixed_hypothesis_set_;
+    }
+
+    const std::unordered_map<AgentIdx, HypothesisId>& get_current_hypothesis() const {
+      return current_sampled_hypothesis_;
+    }
+
+    // Tracked beliefs, sampled hypothesis and sampling generator, settings are taken from the parameters
+    void save(RecordWriter& writer) const;
+
+    void load(RecordReader& reader);
+
 private:
     unsigned int history_length_;
     float probability_discount_;
     PosteriorType posterior_type_;
     std::unordered_map<AgentIdx, std::vector<std::deque<Probability>>> tracked_probabilities_;
     std::unordered_map<AgentIdx, std::vector<Belief>> tracked_beliefs_;//< contains the beliefs for each hypothesis for each agent 
+    std::vector<AgentIdx> tracked_agents_; //< order of sampling, independent of the hash map's insertion history
     std::unordered_map<AgentIdx, HypothesisId> current_sampled_hypothesis_; //< the currently sampled hypothesis shared across all hypothesis states
     std::unordered_map<AgentIdx, HypothesisId> fixed_hypothesis_set_; // < if not empty a fixed hypothesis set is used in each iteration (e.g. for the omniscient approach)
 };
@@ -66,6 +84,7 @@ private:
 template <typename S>
 void HypothesisBeliefTracker::belief_update(const HypothesisStateInterface<S>& state, 
                                             const HypothesisStateInterface<S>& next_state) {
+  MCTS_PERF_REGION(PERF_BELIEF_UPDATE);
   if(!fixed_hypothesis_set_.empty()) {
     // no belief update required, if fixed hypothesis set is given
     return;
@@ -75,6 +94,7 @@ void HypothesisBeliefTracker::belief_update(const HypothesisStateInterface<S>& s
     auto belief_track_it = tracked_beliefs_.find(agent_idx);
     if(belief_track_it == tracked_beliefs_.end()) {
       // Init belief and probability tracking
+      tracked_agents_.push_back(agent_idx);
       auto& belief_track_agent = tracked_beliefs_[agent_idx];
       auto& probability_track_agent = tracked_probabilities_[agent_idx];
       const auto num_hypothesis = state.get_num_hypothesis(agent_idx);
@@ -137,10 +157,11 @@ inline const std::unordered_map<AgentIdx, HypothesisId>& HypothesisBeliefTracker
     return current_sampled_hypothesis_;
   }
 
-  for (const auto& it : tracked_beliefs_) {
+  for (const auto& agent_idx : tracked_agents_) {
     // Sample one hypothesis for each agent
-    std::discrete_distribution<HypothesisId> hypothesis_distribution(it.second.begin(), it.second.end());
-    auto& hypothesis_id = current_sampled_hypothesis_[it.first];
+    const auto& beliefs = tracked_beliefs_.at(agent_idx);
+    std::discrete_distribution<HypothesisId> hypothesis_distribution(beliefs.begin(), beliefs.end());
+    auto& hypothesis_id = current_sampled_hypothesis_[agent_idx];
     hypothesis_id = hypothesis_distribution(random_generator_);
   }
   return current_sampled_hypothesis_;
@@ -168,6 +189,24 @@ inline std::string HypothesisBeliefTracker::sprintf() const {
   return ss.str();
 }
 
+inline void HypothesisBeliefTracker::save(RecordWriter& writer) const {
+  writer.write(tracked_probabilities_);
+  writer.write(tracked_beliefs_);
+  writer.write(tracked_agents_);
+  writer.write(current_sampled_hypothesis_);
+  writer.write(fixed_hypothesis_set_);
+  writer.write(random_generator_);
+}
+
+inline void HypothesisBeliefTracker::load(RecordReader& reader) {
+  reader.read(tracked_probabilities_);
+  reader.read(tracked_beliefs_);
+  reader.read(tracked_agents_);
+  reader.read(current_sampled_hypothesis_);
+  reader.read(fixed_hypothesis_set_);
+  reader.read(random_generator_);
+}
+
 inline void HypothesisBeliefTracker::update_fixed_hypothesis_set(const std::unordered_map<AgentIdx, HypothesisId>& hypothesis_set) {
   fixed_hypothesis_set_ = hypothesis_set;
 }
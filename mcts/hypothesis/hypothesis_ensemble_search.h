@@ -0,0 +1,289 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef MCTS_HYPOTHESIS_HYPOTHESIS_ENSEMBLE_SEARCH_H
+#define MCTS_HYPOTHESIS_HYPOTHESIS_ENSEMBLE_SEARCH_H
+
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "mcts/mcts.h"
+#include "mcts/hypothesis/hypothesis_belief_tracker.h"
+
+namespace mcts {
+
+// A joint hypothesis assignment of the other agents with its belief, searched by num_threads trees
+struct HypothesisStratum {
+  std::unordered_map<AgentIdx, HypothesisId> hypothesis;
+  Belief belief;
+  unsigned int num_threads;
+};
+
+/*
+ * Root-parallel search in which every thread owns a tree dedicated to one joint hypothesis assignment (stratum).
+ * Threads are distributed over the strata in proportion to the joint beliefs of the belief tracker, each tree
+ * is searched with this assignment fixed such that the hypothesis statistics of a tree hold a single hypothesis
+ * per agent. The ego action values at the roots are combined weighted by the stratum beliefs and the visits of the actions.
+ * Each tree runs MAX_NUMBER_OF_ITERATIONS within MAX_SEARCH_TIME. The state must implement clone_with_hypothesis.
+ */
+template<class S, class SE, class SO, class H>
+class HypothesisEnsembleSearch {
+public:
+    HypothesisEnsembleSearch(const MctsParameters& mcts_parameters) :
+                            mcts_parameters_(mcts_parameters),
+                            strata_(),
+                            ego_action_values_(),
+                            ego_action_counts_(),
+                            num_iterations_(0),
+                            tracer_(nullptr),
+                            search_observer_() {}
+
+    template< class Q = S>
+    typename std::enable_if<std::is_base_of<RequiresHypothesis, Q>::value>::type
+    search(const S& current_state, const HypothesisBeliefTracker& belief_tracker);
+
+    // Action with the highest merged value among the ones visited by any worker
+    ActionIdx returnBestAction() const;
+
+    unsigned int numIterations() const { return num_iterations_; }
+
+    const std::vector<double>& get_ego_action_values() const { return ego_action_values_; }
+
+    const std::vector<unsigned int>& get_ego_action_counts() const { return ego_action_counts_; }
+
+    const std::vector<HypothesisStratum>& get_strata() const { return strata_; }
+
+    // Workers trace into the buffers of their worker index
+    void set_tracer(SearchTracer* tracer) { tracer_ = tracer; }
+
+    // Called by each worker with its finished search, e.g. to validate the worker trees, concurrently across workers
+    void set_search_observer(const std::function<void(const Mcts<S, SE, SO, H>&)>& search_observer) {
+        search_observer_ = search_observer;
+    }
+
+    // Distributes threads by largest remainder on the joint beliefs over the num_threads most likely joint
+    // hypothesis assignments, enumerated best-first, assignments receiving no thread are omitted
+    static std::vector<HypothesisStratum> allocate_strata(const std::unordered_map<AgentIdx, std::vector<Belief>>& beliefs,
+                                                          const unsigned int& num_threads);
+
+    // Per action mean of the worker values weighted by worker weight times visits of the action,
+    // zero for actions no worker visited
+    static std::vector<double> merge_action_values(const std::vector<double>& worker_weights,
+                                                   const std::vector<std::vector<double>>& action_values,
+                                                   const std::vector<std::vector<unsigned int>>& action_counts);
+
+private:
+    const MctsParameters mcts_parameters_;
+    std::vector<HypothesisStratum> strata_;
+    std::vector<double> ego_action_values_;
+    std::vector<unsigned int> ego_action_counts_;
+    unsigned int num_iterations_;
+    SearchTracer* tracer_;
+    std::function<void(const Mcts<S, SE, SO, H>&)> search_observer_;
+};
+
+template<class S, class SE, class SO, class H>
+template<class Q>
+typename std::enable_if<std::is_base_of<RequiresHypothesis, Q>::value>::type
+HypothesisEnsembleSearch<S, SE, SO, H>::search(const S& current_state, const HypothesisBeliefTracker& belief_tracker) {
+    const unsigned int num_threads = mcts_parameters_.hypothesis_ensemble.NUM_THREADS > 0 ?
+                                       mcts_parameters_.hypothesis_ensemble.NUM_THREADS :
+                                       std::max(1u, std::thread::hardware_concurrency());
+    if(!belief_tracker.get_fixed_hypothesis_set().empty()) {
+        strata_ = {HypothesisStratum{belief_tracker.get_fixed_hypothesis_set(), 1.0, num_threads}};
+    } else {
+        strata_ = allocate_strata(belief_tracker.get_beliefs(), num_threads);
+    }
+
+    // One worker per thread, workers of a stratum differ in their random streams
+    std::vector<std::pair<std::size_t, unsigned int>> workers; // stratum index, worker index
+    for (std::size_t stratum_idx = 0; stratum_idx < strata_.size(); ++stratum_idx) {
+        for (unsigned int thread = 0; thread < strata_[stratum_idx].num_threads; ++thread) {
+            workers.push_back(std::make_pair(stratum_idx, workers.size()));
+        }
+    }
+
+    const ActionIdx num_actions = current_state.get_num_actions(current_state.get_ego_agent_idx());
+    std::vector<std::vector<double>> worker_action_values(workers.size(), std::vector<double>(num_actions, 0.0));
+    std::vector<std::vector<unsigned int>> worker_action_counts(workers.size(), std::vector<unsigned int>(num_actions, 0));
+    std::vector<unsigned int> worker_iterations(workers.size(), 0);
+    std::vector<std::thread> threads;
+    for (std::size_t worker_idx = 0; worker_idx < workers.size(); ++worker_idx) {
+        threads.emplace_back([&, worker_idx]() {
+            const auto& stratum = strata_[workers[worker_idx].first];
+            MctsParameters worker_parameters(mcts_parameters_);
+            worker_parameters.THREAD_IDX = workers[worker_idx].second;
+            HypothesisBeliefTracker worker_belief_tracker(belief_tracker);
+            worker_belief_tracker.set_random_stream(random_stream(worker_parameters.THREAD_IDX, 0));
+            worker_belief_tracker.update_fixed_hypothesis_set(stratum.hypothesis);
+            const auto worker_state = current_state.clone_with_hypothesis(worker_belief_tracker.sample_current_hypothesis());
+
+            Mcts<S, SE, SO, H> mcts(worker_parameters);
+            mcts.set_tracer(tracer_);
+            mcts.search(*worker_state, worker_belief_tracker);
+            for (ActionIdx action = 0; action < num_actions; ++action) {
+                worker_action_values[worker_idx][action] = mcts.rootActionValue(action);
+                worker_action_counts[worker_idx][action] = mcts.rootActionCount(action);
+            }
+            worker_iterations[worker_idx] = mcts.numIterations();
+            if(search_observer_) {
+                search_observer_(mcts);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Workers of a stratum share its belief, unvisited actions of a worker do not contribute
+    Belief belief_sum = 0.0;
+    for (const auto& stratum : strata_) {
+        belief_sum += stratum.belief;
+    }
+    std::vector<double> worker_weights;
+    ego_action_counts_ = std::vector<unsigned int>(num_actions, 0);
+    num_iterations_ = 0;
+    for (std::size_t worker_idx = 0; worker_idx < workers.size(); ++worker_idx) {
+        const auto& stratum = strata_[workers[worker_idx].first];
+        worker_weights.push_back((belief_sum > 0.0 ? stratum.belief / belief_sum : 1.0 / strata_.size()) / stratum.num_threads);
+        for (ActionIdx action = 0; action < num_actions; ++action) {
+            ego_action_counts_[action] += worker_action_counts[worker_idx][action];
+        }
+        num_iterations_ += worker_iterations[worker_idx];
+    }
+    ego_action_values_ = merge_action_values(worker_weights, worker_action_values, worker_action_counts);
+}
+
+template<class S, class SE, class SO, class H>
+ActionIdx HypothesisEnsembleSearch<S, SE, SO, H>::returnBestAction() const {
+    ActionIdx best_action = 0;
+    double largest_value = -std::numeric_limits<double>::max();
+    for (ActionIdx action = 0; action < ego_action_values_.size(); ++action) {
+        if (ego_action_counts_[action] > 0 && ego_action_values_[action] > largest_value) {
+            largest_value = ego_action_values_[action];
+            best_action = action;
+        }
+    }
+    return best_action;
+}
+
+template<class S, class SE, class SO, class H>
+std::vector<double> HypothesisEnsembleSearch<S, SE, SO, H>::merge_action_values(
+                                    const std::vector<double>& worker_weights,
+                                    const std::vector<std::vector<double>>& action_values,
+                                    const std::vector<std::vector<unsigned int>>& action_counts) {
+    const std::size_t num_actions = action_values.empty() ? 0 : action_values.front().size();
+    std::vector<double> weighted_values(num_actions, 0.0);
+    std::vector<double> weights(num_actions, 0.0);
+    for (std::size_t worker_idx = 0; worker_idx < action_values.size(); ++worker_idx) {
+        for (std::size_t action = 0; action < num_actions; ++action) {
+            const double weight = worker_weights[worker_idx] * action_counts[worker_idx][action];
+            weighted_values[action] += weight * action_values[worker_idx][action];
+            weights[action] += weight;
+        }
+    }
+    for (std::size_t action = 0; action < num_actions; ++action) {
+        weighted_values[action] = weights[action] > 0.0 ? weighted_values[action] / weights[action] : 0.0;
+    }
+    return weighted_values;
+}
+
+template<class S, class SE, class SO, class H>
+std::vector<HypothesisStratum> HypothesisEnsembleSearch<S, SE, SO, H>::allocate_strata(
+                                    const std::unordered_map<AgentIdx, std::vector<Belief>>& beliefs,
+                                    const unsigned int& num_threads) {
+    // Each agent's hypotheses by descending belief, a joint assignment is a rank per agent
+    std::vector<std::pair<AgentIdx, std::vector<HypothesisId>>> ranked_hypotheses;
+    const std::map<AgentIdx, std::vector<Belief>> ordered_beliefs(beliefs.begin(), beliefs.end());
+    for (const auto& agent_beliefs : ordered_beliefs) {
+        std::vector<HypothesisId> ranking(agent_beliefs.second.size());
+        std::iota(ranking.begin(), ranking.end(), 0);
+        std::stable_sort(ranking.begin(), ranking.end(), [&agent_beliefs](const HypothesisId& lhs, const HypothesisId& rhs) {
+                                                          return agent_beliefs.second[lhs] > agent_beliefs.second[rhs]; });
+        if (ranking.empty()) {
+            return {};
+        }
+        ranked_hypotheses.push_back(std::make_pair(agent_beliefs.first, ranking));
+    }
+    const auto joint_belief = [&](const std::vector<std::size_t>& ranks) {
+        Belief belief = 1.0;
+        for (std::size_t idx = 0; idx < ranks.size(); ++idx) {
+            belief *= ordered_beliefs.at(ranked_hypotheses[idx].first)[ranked_hypotheses[idx].second[ranks[idx]]];
+        }
+        return belief;
+    };
+
+    // Best-first enumeration of the num_threads most likely joint assignments, as no further assignment can receive
+    // a thread. Successors of an assignment lower the rank of one agent, ties by lexicographic ranks.
+    typedef std::pair<Belief, std::vector<std::size_t>> RankedAssignment;
+    const auto more_likely = [](const RankedAssignment& lhs, const RankedAssignment& rhs) {
+                                return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second); };
+    std::set<RankedAssignment, decltype(more_likely)> frontier(more_likely);
+    std::set<std::vector<std::size_t>> visited;
+    const std::vector<std::size_t> best_ranks(ranked_hypotheses.size(), 0);
+    frontier.insert(std::make_pair(joint_belief(best_ranks), best_ranks));
+    visited.insert(best_ranks);
+    std::vector<HypothesisStratum> joint_assignments;
+    while (!frontier.empty() && joint_assignments.size() < num_threads) {
+        const auto best = *frontier.begin();
+        frontier.erase(frontier.begin());
+        HypothesisStratum assignment{{}, best.first, 0};
+        for (std::size_t idx = 0; idx < best.second.size(); ++idx) {
+            assignment.hypothesis[ranked_hypotheses[idx].first] = ranked_hypotheses[idx].second[best.second[idx]];
+        }
+        joint_assignments.push_back(assignment);
+        for (std::size_t idx = 0; idx < best.second.size(); ++idx) {
+            if (best.second[idx] + 1 < ranked_hypotheses[idx].second.size()) {
+                auto successor = best.second;
+                successor[idx] += 1;
+                if (visited.insert(successor).second) {
+                    frontier.insert(std::make_pair(joint_belief(successor), successor));
+                }
+            }
+        }
+    }
+
+    Belief belief_sum = 0.0;
+    for (const auto& assignment : joint_assignments) {
+        belief_sum += assignment.belief;
+    }
+
+    // Largest remainder method over the enumerated assignments, ties by enumeration order
+    unsigned int num_allocated = 0;
+    std::vector<std::pair<double, std::size_t>> remainders;
+    for (std::size_t idx = 0; idx < joint_assignments.size(); ++idx) {
+        const double share = belief_sum > 0.0 ? num_threads * joint_assignments[idx].belief / belief_sum
+                                              : static_cast<double>(num_threads) / joint_assignments.size();
+        joint_assignments[idx].num_threads = static_cast<unsigned int>(std::floor(share));
+        num_allocated += joint_assignments[idx].num_threads;
+        remainders.push_back(std::make_pair(share - joint_assignments[idx].num_threads, idx));
+    }
+    std::stable_sort(remainders.begin(), remainders.end(), [](const std::pair<double, std::size_t>& lhs,
+                                                              const std::pair<double, std::size_t>& rhs) {
+                                                                return lhs.first > rhs.first; });
+    for (std::size_t idx = 0; num_allocated < num_threads && idx < remainders.size(); ++idx) {
+        joint_assignments[remainders[idx].second].num_threads += 1;
+        num_allocated += 1;
+    }
+
+    std::vector<HypothesisStratum> strata;
+    for (const auto& assignment : joint_assignments) {
+        if(assignment.num_threads > 0) {
+            strata.push_back(assignment);
+        }
+    }
+    return strata;
+}
+
+} // namespace mcts
+
+#endif // MCTS_HYPOTHESIS_HYPOTHESIS_ENSEMBLE_SEARCH_H
@@ -7,7 +7,10 @@
 #ifndef MCTS_HYPOTHESIS_STATE_H
 #define MCTS_HYPOTHESIS_STATE_H
 
+#include <unordered_map>
+#include <vector>
 #include "mcts/hypothesis/common.h"
+#include "mcts/random_generator.h"
 #include "mcts/state.h"
 
 
@@ -21,7 +24,14 @@ public:
     HypothesisStateInterface(const std::unordered_map<AgentIdx, HypothesisId>& current_agents_hypothesis) 
                     : current_agents_hypothesis_(current_agents_hypothesis) {}
 
-    ActionIdx plan_action_current_hypothesis(const AgentIdx& agent_idx) const;
+    // Samples an action from the current hypothesis of the agent. Randomness is drawn from the caller's
+    // generator only, such that states sharing hypothesis policies can be searched concurrently.
+    ActionIdx plan_action_current_hypothesis(const AgentIdx& agent_idx, Philox4x32& random_generator) const;
+
+    // Appends num_actions actions sampled from the current hypothesis of the agent. States with expensive
+    // hypothesis policies may hide this default to share preprocessing between the samples.
+    void plan_actions_current_hypothesis(const AgentIdx& agent_idx, const unsigned int& num_actions,
+                                         std::vector<ActionIdx>& actions, Philox4x32& random_generator) const;
 
     template<typename ActionType = ActionIdx>
     Probability get_probability(const HypothesisId& hypothesis, const AgentIdx& agent_idx, const ActionType& action) const;
@@ -35,13 +45,28 @@ public:
 
     HypothesisId get_current_hypothesis(const AgentIdx& agent_idx) const;
 
+    // Copy of the state following another hypothesis assignment. The copy must not share mutable data with this state
+    // such that both can be searched concurrently.
+    std::shared_ptr<Implementation> clone_with_hypothesis(const std::unordered_map<AgentIdx, HypothesisId>& current_agents_hypothesis) const;
+
 protected:
     const std::unordered_map<AgentIdx, HypothesisId>& current_agents_hypothesis_; // shared across all states
 };
 
 template<typename Implementation>
-inline ActionIdx HypothesisStateInterface<Implementation>::plan_action_current_hypothesis(const AgentIdx& agent_idx) const {
- return StateInterface<Implementation>::impl().plan_action_current_hypothesis(agent_idx);
+inline ActionIdx HypothesisStateInterface<Implementation>::plan_action_current_hypothesis(const AgentIdx& agent_idx,
+                                                    Philox4x32& random_generator) const {
+ return StateInterface<Implementation>::impl().plan_action_current_hypothesis(agent_idx, random_generator);
+}
+
+template<typename Implementation>
+inline void HypothesisStateInterface<Implementation>::plan_actions_current_hypothesis(const AgentIdx& agent_idx,
+                                                    const unsigned int& num_actions, std::vector<ActionIdx>& actions,
+                                                    Philox4x32& random_generator) const {
+ actions.reserve(actions.size() + num_actions);
+ for (unsigned int i = 0; i < num_actions; ++i) {
+   actions.push_back(StateInterface<Implementation>::impl().plan_action_current_hypothesis(agent_idx, random_generator));
+ }
 }
 
 template<typename Implementation>
@@ -68,6 +93,12 @@ inline HypothesisId HypothesisStateInterface<Implementation>::get_num_hypothesis
  return StateInterface<Implementation>::impl().get_num_hypothesis(agent_idx);
 }
 
+template<typename Implementation>
+inline std::shared_ptr<Implementation> HypothesisStateInterface<Implementation>::clone_with_hypothesis(
+                                  const std::unordered_map<AgentIdx, HypothesisId>& current_agents_hypothesis) const {
+ return StateInterface<Implementation>::impl().clone_with_hypothesis(current_agents_hypothesis);
+}
+
 template<typename Implementation>
 inline HypothesisId HypothesisStateInterface<Implementation>::get_current_hypothesis(const AgentIdx& agent_idx) const {
  return current_agents_hypothesis_.at(agent_idx);
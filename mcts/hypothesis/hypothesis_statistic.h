@@ -9,6 +9,7 @@
 
 #include <cmath>
 #include <map>
+#include <memory>
 
 #include "mcts/mcts.h"
 #include "mcts/hypothesis/common.h"
@@ -19,7 +20,7 @@ namespace mcts {
 
 constexpr HypothesisId HYPOTHESIS_ID_NOT_SET = 100000;
 class HypothesisStatistic : public mcts::NodeStatistic<HypothesisStatistic>,
-                                   mcts::RandomGenerator,
+                                   public mcts::RandomGenerator,
                                    mcts::RequiresHypothesis
 {
 public:
@@ -27,7 +28,7 @@ public:
 
     HypothesisStatistic(ActionIdx num_actions, AgentIdx agent_idx, const MctsParameters& mcts_parameters) :
                     NodeStatistic<HypothesisStatistic>(num_actions, agent_idx, mcts_parameters),
-                    RandomGenerator(mcts_parameters.RANDOM_SEED),
+                    RandomGenerator(mcts_parameters.RANDOM_SEED, random_stream(mcts_parameters.THREAD_IDX, 0)),
                     ego_cost_value_(0.0f),
                     latest_ego_cost_(0.0f),
                     ucb_statistics_(),
@@ -42,7 +43,32 @@ public:
                     cost_based_action_selection_(mcts_parameters.hypothesis_statistic.COST_BASED_ACTION_SELECTION),
                     progressive_widening_hypothesis_based_(mcts_parameters.hypothesis_statistic.PROGRESSIVE_WIDENING_HYPOTHESIS_BASED),
                     progressive_widening_k(mcts_parameters.hypothesis_statistic.PROGRESSIVE_WIDENING_K),
-                    progressive_widening_alpha(mcts_parameters.hypothesis_statistic.PROGRESSIVE_WIDENING_ALPHA)
+                    progressive_widening_alpha(mcts_parameters.hypothesis_statistic.PROGRESSIVE_WIDENING_ALPHA),
+                    action_candidate_batch_size_(mcts_parameters.hypothesis_statistic.ACTION_CANDIDATE_BATCH_SIZE),
+                    action_candidates_()
+                    {}
+
+    // Copies the drawn action candidates instead of sharing them
+    HypothesisStatistic(const HypothesisStatistic& other) :
+                    NodeStatistic<HypothesisStatistic>(other),
+                    RandomGenerator(other),
+                    ego_cost_value_(other.ego_cost_value_),
+                    latest_ego_cost_(other.latest_ego_cost_),
+                    ucb_statistics_(other.ucb_statistics_),
+                    total_node_visits_hypothesis_(other.total_node_visits_hypothesis_),
+                    hypothesis_id_current_iteration_(other.hypothesis_id_current_iteration_),
+                    total_node_visits_(other.total_node_visits_),
+                    num_expanded_actions_(other.num_expanded_actions_),
+                    upper_cost_bound(other.upper_cost_bound),
+                    lower_cost_bound(other.lower_cost_bound),
+                    k_discount_factor(other.k_discount_factor),
+                    k_exploration_constant(other.k_exploration_constant),
+                    cost_based_action_selection_(other.cost_based_action_selection_),
+                    progressive_widening_hypothesis_based_(other.progressive_widening_hypothesis_based_),
+                    progressive_widening_k(other.progressive_widening_k),
+                    progressive_widening_alpha(other.progressive_widening_alpha),
+                    action_candidate_batch_size_(other.action_candidate_batch_size_),
+                    action_candidates_(other.action_candidates_ ? new ActionCandidates(*other.action_candidates_) : nullptr)
                     {}
 
     inline void init_hypothesis_variables(const HypothesisId hypothesis_id) {
@@ -71,7 +97,7 @@ public:
             1) Sample action from hypothesis
             2) Initialized UCBPair for this acion for this hypothesis (counts are updated during backprop.)
             3) Return this action */
-            ActionIdx sampled_action = impl.plan_action_current_hypothesis(agent_idx_);
+            ActionIdx sampled_action = sample_action_current_hypothesis(state.impl());
             auto& ucb_pair = ucb_statistics_[hypothesis_id_current_iteration_][sampled_action];
             num_expanded_actions_ += 1;
             return sampled_action;
@@ -91,6 +117,14 @@ public:
         }
     }
 
+    // The given action is credited under the hypothesis of this iteration
+    template <class S>
+    void prepare_given_action(const StateInterface<S>& state) {
+        const HypothesisStateInterface<S>& impl = state.impl();
+        hypothesis_id_current_iteration_ = impl.get_current_hypothesis(agent_idx_);
+        init_hypothesis_variables(hypothesis_id_current_iteration_);
+    }
+
     void update_from_heuristic(const NodeStatistic<HypothesisStatistic>& heuristic_statistic)
     {
         const HypothesisStatistic& heuristic_statistic_impl = heuristic_statistic.impl();
@@ -120,6 +154,24 @@ public:
 
     ActionIdx get_best_action() { throw std::logic_error("Not a meaningful call for this statistic");};
 
+    double get_action_value(const ActionIdx& action) const { throw std::logic_error("Not a meaningful call for this statistic");};
+
+    unsigned int get_action_count(const ActionIdx& action) const { throw std::logic_error("Not a meaningful call for this statistic");};
+
+    std::size_t get_memory_footprint() const {
+        std::size_t bytes = heap_bytes(ucb_statistics_) + heap_bytes(total_node_visits_hypothesis_);
+        for (const auto& hypothesis_statistics : ucb_statistics_) {
+            bytes += heap_bytes(hypothesis_statistics.second);
+        }
+        if(action_candidates_) {
+            bytes += sizeof(ActionCandidates) + heap_bytes(*action_candidates_);
+            for (const auto& hypothesis_candidates : *action_candidates_) {
+                bytes += heap_bytes(hypothesis_candidates.second);
+            }
+        }
+        return bytes;
+    }
+
     void set_heuristic_estimate(const Reward& accum_rewards, const Cost& accum_ego_cost) {
         ego_cost_value_ = accum_ego_cost;
     };
@@ -170,6 +222,25 @@ public:
     }
 
 private: // methods
+    // Draws from the generator of this statistic, the random streams of the search thus also cover the hypothesis policies
+    template <class S>
+    inline ActionIdx sample_action_current_hypothesis(const S& state) {
+        if(action_candidate_batch_size_ == 0) {
+            return state.plan_action_current_hypothesis(agent_idx_, random_generator_);
+        }
+        // Hand out candidates of this node drawn previously for the hypothesis, redraw a batch if exhausted
+        if(!action_candidates_) {
+            action_candidates_.reset(new ActionCandidates());
+        }
+        auto& candidates = (*action_candidates_)[hypothesis_id_current_iteration_];
+        if(candidates.empty()) {
+            state.plan_actions_current_hypothesis(agent_idx_, action_candidate_batch_size_, candidates, random_generator_);
+        }
+        const ActionIdx sampled_action = candidates.back();
+        candidates.pop_back();
+        return sampled_action;
+    }
+
     inline bool require_progressive_widening_hypothesis_based(const HypothesisId& hypothesis_id) const {
         const auto num_expanded = num_expanded_actions(hypothesis_id);
         const auto widening_term = progressive_widening_k * std::pow(num_node_visits(hypothesis_id),
@@ -216,6 +287,11 @@ private: // members
 
     const double progressive_widening_k;
     const double progressive_widening_alpha;
+
+    const unsigned int action_candidate_batch_size_;
+    typedef std::unordered_map<HypothesisId, std::vector<ActionIdx>> ActionCandidates;
+    // Sampled but not yet expanded actions, only allocated when candidates are drawn in batches
+    std::unique_ptr<ActionCandidates> action_candidates_;
 };
 
 } // namespace mcts
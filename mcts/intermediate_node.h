@@ -37,6 +37,9 @@ namespace mcts {
 
         ActionIdx choose_next_action();
 
+        // The stage node selects the action instead of the statistic, e.g. redirected to an existing child
+        void prepare_given_action();
+
         ActionIdx get_best_action();
 
         AgentIdx get_agent_idx() const;
@@ -64,6 +67,11 @@ namespace mcts {
             return NodeStatistic<Stats>::choose_next_action(state_);
     }
 
+    template<class S, class Stats>
+    void IntermediateNode<S, Stats>::prepare_given_action() {
+            Stats::prepare_given_action(state_);
+    }
+
     template<class S, class Stats>
     ActionIdx IntermediateNode<S, Stats>::get_best_action() {
             return NodeStatistic<Stats>::get_best_action();
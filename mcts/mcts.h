@@ -14,7 +14,17 @@
 #include <chrono>  // for high_resolution_clock
 #include "common.h"
 #include "mcts_parameters.h"
+#include "random_generator.h"
+#include "search_profile.h"
+#include "search_tracer.h"
+#include "search_recorder.h"
+#include "perf_counters.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
 #include <string>
+#include <typeinfo>
  
 
 namespace mcts {
@@ -36,8 +46,14 @@ public:
 
     Mcts(const MctsParameters& mcts_parameters) : root_(),
                                                   num_iterations_(0),
+                                                  root_best_action_(0),
                                                   mcts_parameters_(mcts_parameters), 
-                                                  heuristic_(mcts_parameters)
+                                                  heuristic_(mcts_parameters),
+                                                  profile_(),
+                                                  tracer_(nullptr),
+                                                  trace_buffer_(nullptr),
+                                                  perf_report_(),
+                                                  recorder_(nullptr)
                                                   {}
 
     ~Mcts() {}
@@ -52,13 +68,62 @@ public:
     unsigned int searchTime();
     std::string nodeInfo();
     ActionIdx returnBestAction();
+    double rootActionValue(const ActionIdx& action); // value of an ego action at the root
+    unsigned int rootActionCount(const ActionIdx& action); // visits of an ego action at the root
+    unsigned int numNodes() const; // stage nodes created by the last search
+    TreeStatistics treeStatistics() const; // shape and estimated memory of the last search tree
     void printTreeToDotFile(std::string filename="tree");
 
     void set_heuristic_function(const H& heuristic) {heuristic_ = heuristic;}
+    const H& get_heuristic_function() const {return heuristic_;}
+
+    // Time per search phase of the last search, only recorded when compiled with MCTS_PROFILING
+    const SearchProfile& profile() const {return profile_;}
+
+    // Records spans of the following searches, nullptr disables tracing. The tracer must outlive the searches.
+    void set_tracer(SearchTracer* tracer) {tracer_ = tracer;}
+
+    // Hardware counters per region of the last search, only recorded when compiled with MCTS_PERF_COUNTERS
+    const PerfReport& perf_report() const {return perf_report_;}
+
+    // Records inputs and outcome of the following searches for replay, nullptr disables recording.
+    // The recorder must outlive the searches and the state must implement save(RecordWriter&).
+    void set_recorder(SearchRecorder* recorder) {recorder_ = recorder;}
 
 private:
 
-    void iterate(const StageNodeSPtr& root_node);
+    void iterate(const StageNodeSPtr& root_node, const ActionIdx& root_ego_action = EGO_ACTION_NOT_SET);
+
+    // Rejects states whose other agents' action indices are only valid if sampled from the state, e.g. interned
+    // actions, if SO enumerates raw action indices instead of sampling from the hypotheses of the state
+    void check_other_agents_statistic(const S& state) const;
+
+    // Descent step of the selection, profiled as expansion if it creates a new stage node
+    std::pair<bool, bool> select_or_expand(StageNodeSPtr& node, const ActionIdx& ego_action = EGO_ACTION_NOT_SET);
+
+    // Random heuristics draw from a stream of their own per iteration, rollouts thus do not depend
+    // on the random numbers consumed by previous iterations
+    template< class Q = H>
+    typename std::enable_if<std::is_convertible<Q*, RandomGenerator*>::value>::type
+    set_heuristic_random_stream() {
+        heuristic_.set_random_stream(random_stream(mcts_parameters_.THREAD_IDX, num_iterations_ + 1));
+    }
+
+    template< class Q = H>
+    typename std::enable_if<!std::is_convertible<Q*, RandomGenerator*>::value>::type
+    set_heuristic_random_stream() {}
+
+    // Trace buffer if the current iteration is traced, nullptr otherwise
+    TraceBuffer* sampled_trace_buffer() const {
+        return (trace_buffer_ && tracer_->is_sampled(num_iterations_)) ? trace_buffer_ : nullptr;
+    }
+
+    template<class BeforeIteration>
+    void search_sequential_halving(const std::chrono::high_resolution_clock::time_point& start,
+                                   const BeforeIteration& before_iteration);
+
+    double root_action_score(const ActionIdx& action, const std::vector<double>& gumbel_scores,
+                             const std::vector<unsigned int>& visits, const unsigned int& max_visits) const;
 
     StageNodeSPtr root_;
 
@@ -66,10 +131,27 @@ private:
 
     unsigned int search_time_;
 
+    ActionIdx root_best_action_; // survivor of sequential halving
+
     const MctsParameters mcts_parameters_;
 
     H heuristic_;
 
+    SearchProfile profile_;
+
+    SearchTracer* tracer_;
+
+    TraceBuffer* trace_buffer_;
+
+    PerfReport perf_report_;
+
+    SearchRecorder* recorder_;
+
+    // Parameters, belief tracker (if any) and root state as read by the replay
+    std::string record_inputs(const S& current_state, const HypothesisBeliefTracker* belief_tracker) const;
+
+    void write_record(const std::string& inputs);
+
     std::string sprintf(const StageNodeSPtr& root_node) const;
 
     MCTS_TEST
@@ -79,8 +161,9 @@ template<class S, class SE, class SO, class H>
 template<class Q>
 typename std::enable_if<std::is_base_of<RequiresHypothesis, Q>::value>::type
 Mcts<S, SE, SO, H>::search(const S& current_state, HypothesisBeliefTracker& belief_tracker) {
+    check_other_agents_statistic(current_state);
+    const std::string recorded_inputs = recorder_ ? record_inputs(current_state, &belief_tracker) : std::string();
     auto start = std::chrono::high_resolution_clock::now();
-    StageNode<S,SE, SO, H>::reset_counter();
 
     const auto max_iterations = mcts_parameters_.MAX_NUMBER_OF_ITERATIONS;
     const auto max_search_time_ms = mcts_parameters_.MAX_SEARCH_TIME;
@@ -88,68 +171,241 @@ Mcts<S, SE, SO, H>::search(const S& current_state, HypothesisBeliefTracker& beli
     root_ = std::make_shared<StageNode<S,SE, SO, H>,StageNodeSPtr, std::shared_ptr<S>, const JointAction&,
             const unsigned int&> (nullptr, current_state.clone(),JointAction(),0,  mcts_parameters_);
     num_iterations_ = 0;
-    while (std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::high_resolution_clock::now() - start ).count() < max_search_time_ms && num_iterations_<max_iterations) {
-        belief_tracker.sample_current_hypothesis();
-        iterate(root_);
-        num_iterations_ += 1;
+    profile_.reset();
+    trace_buffer_ = tracer_ ? &tracer_->thread_buffer(mcts_parameters_.THREAD_IDX) : nullptr;
+    ScopedTraceSpan search_span(trace_buffer_, "search", "search");
+    const PerfReport perf_report_before = PerfReport::thread_report();
+    if(mcts_parameters_.root_action_selection.SEQUENTIAL_HALVING) {
+        search_sequential_halving(start, [this, &belief_tracker]() {
+            MCTS_PROFILE_PHASE(profile_, HYPOTHESIS_SAMPLING);
+            ScopedTraceSpan sampling_span(sampled_trace_buffer(), "hypothesis_sampling", "search");
+            MCTS_PERF_REGION(PERF_HYPOTHESIS_SAMPLING);
+            belief_tracker.sample_current_hypothesis();
+        });
+    } else {
+        while (std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::high_resolution_clock::now() - start ).count() < max_search_time_ms && num_iterations_<max_iterations) {
+            {
+                MCTS_PROFILE_PHASE(profile_, HYPOTHESIS_SAMPLING);
+                ScopedTraceSpan sampling_span(sampled_trace_buffer(), "hypothesis_sampling", "search");
+                MCTS_PERF_REGION(PERF_HYPOTHESIS_SAMPLING);
+                belief_tracker.sample_current_hypothesis();
+            }
+            iterate(root_);
+            num_iterations_ += 1;
+        }
     }
     search_time_ = std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::high_resolution_clock::now() - start ).count();
+    perf_report_ = PerfReport::thread_report();
+    perf_report_.subtract(perf_report_before);
+    if(recorder_) {
+        write_record(recorded_inputs);
+    }
 }
 
 template<class S, class SE, class SO, class H>
 void Mcts<S,SE,SO,H>::search(const S& current_state)
 {
+    check_other_agents_statistic(current_state);
+    const std::string recorded_inputs = recorder_ ? record_inputs(current_state, nullptr) : std::string();
     auto start = std::chrono::high_resolution_clock::now();
 
-    StageNode<S,SE, SO, H>::reset_counter();
-
     const auto max_iterations = mcts_parameters_.MAX_NUMBER_OF_ITERATIONS;
     const auto max_search_time_ms = mcts_parameters_.MAX_SEARCH_TIME;
 
     root_ = std::make_shared<StageNode<S,SE, SO, H>,StageNodeSPtr, std::shared_ptr<S>, const JointAction&,
             const unsigned int&> (nullptr, current_state.clone(), JointAction(),0, mcts_parameters_);
     num_iterations_ = 0;
-    while (std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::high_resolution_clock::now() - start ).count() < max_search_time_ms && num_iterations_<max_iterations) {
-        iterate(root_);
-        num_iterations_ += 1;
+    profile_.reset();
+    trace_buffer_ = tracer_ ? &tracer_->thread_buffer(mcts_parameters_.THREAD_IDX) : nullptr;
+    ScopedTraceSpan search_span(trace_buffer_, "search", "search");
+    const PerfReport perf_report_before = PerfReport::thread_report();
+    if(mcts_parameters_.root_action_selection.SEQUENTIAL_HALVING) {
+        search_sequential_halving(start, []() {});
+    } else {
+        while (std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::high_resolution_clock::now() - start ).count() < max_search_time_ms && num_iterations_<max_iterations) {
+            iterate(root_);
+            num_iterations_ += 1;
+        }
     }
     search_time_ = std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::high_resolution_clock::now() - start ).count();
+    perf_report_ = PerfReport::thread_report();
+    perf_report_.subtract(perf_report_before);
+    if(recorder_) {
+        write_record(recorded_inputs);
+    }
+}
+
+// States restricting the action indices of the other agents implement bool requires_sampled_other_actions() const
+template<class Q>
+inline auto requires_sampled_other_actions(const Q& state) -> decltype(state.requires_sampled_other_actions()) {
+    return state.requires_sampled_other_actions();
+}
+
+template<class Q, class... Ignored>
+inline bool requires_sampled_other_actions(const Q& state, const Ignored&...) {
+    return false;
+}
+
+template<class S, class SE, class SO, class H>
+void Mcts<S,SE,SO,H>::check_other_agents_statistic(const S& state) const {
+    if(!std::is_base_of<RequiresHypothesis, SO>::value && requires_sampled_other_actions(state)) {
+        throw std::invalid_argument("The state requires the other agents' actions to be sampled from its hypotheses, "
+                                    "e.g. by HypothesisStatistic, which the statistic of the other agents does not");
+    }
+}
+
+template<class S, class SE, class SO, class H>
+template<class BeforeIteration>
+void Mcts<S,SE,SO,H>::search_sequential_halving(const std::chrono::high_resolution_clock::time_point& start,
+                                                const BeforeIteration& before_iteration)
+{
+    // Sequential halving over the root ego actions: each round splits an equal share of the iteration budget
+    // over the remaining candidates and keeps the better half. With Gumbel sampling, candidates are the top actions
+    // of Gumbel noise plus log prior (sampling without replacement) and the same noise enters the ranking.
+    const auto& parameters = mcts_parameters_.root_action_selection;
+    const auto max_iterations = mcts_parameters_.MAX_NUMBER_OF_ITERATIONS;
+    const auto max_search_time_ms = mcts_parameters_.MAX_SEARCH_TIME;
+    const S& state = *root_->get_state();
+    const ActionIdx num_actions = state.get_num_actions(state.get_ego_agent_idx());
+    const std::vector<double> priors = state.get_action_priors(state.get_ego_agent_idx());
+
+    Philox4x32 random_generator(mcts_parameters_.RANDOM_SEED, random_stream(mcts_parameters_.THREAD_IDX, 0));
+    std::vector<double> gumbel_scores(num_actions, 0.0);
+    std::extreme_value_distribution<double> gumbel_distribution(0.0, 1.0);
+    for (ActionIdx action = 0; action < num_actions; ++action) {
+        const double log_prior = (priors.size() == num_actions && priors[action] > 0) ? std::log(priors[action]) : 0.0;
+        gumbel_scores[action] = log_prior + (parameters.GUMBEL_SAMPLING ? gumbel_distribution(random_generator) : 0.0);
+    }
+
+    std::vector<ActionIdx> candidates(num_actions);
+    std::iota(candidates.begin(), candidates.end(), 0);
+    std::shuffle(candidates.begin(), candidates.end(), random_generator);
+    std::stable_sort(candidates.begin(), candidates.end(), [&gumbel_scores](const ActionIdx& lhs, const ActionIdx& rhs) {
+                                                            return gumbel_scores[lhs] > gumbel_scores[rhs]; });
+    if(parameters.NUM_CANDIDATE_ACTIONS > 0 && parameters.NUM_CANDIDATE_ACTIONS < num_actions) {
+        candidates.resize(parameters.NUM_CANDIDATE_ACTIONS);
+    }
+
+    const auto has_budget = [&]() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::high_resolution_clock::now() - start ).count()
+                  < max_search_time_ms && num_iterations_ < max_iterations;
+    };
+    // Nothing to halve with a single candidate, e.g. one ego action or NUM_CANDIDATE_ACTIONS = 1,
+    // it is searched with the plain budget
+    if(candidates.size() == 1) {
+        while(has_budget()) {
+            before_iteration();
+            iterate(root_, candidates.front());
+            num_iterations_ += 1;
+        }
+        root_best_action_ = candidates.front();
+        return;
+    }
+
+    const unsigned int num_rounds = std::max(1u, static_cast<unsigned int>(std::ceil(std::log2(candidates.size()))));
+    const auto elapsed_ms = [&]() {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    };
+    std::vector<unsigned int> visits(num_actions, 0);
+    unsigned int max_visits = 0;
+    bool budget_left = true;
+    for (unsigned int round = 0; candidates.size() > 1 && budget_left; ++round) {
+        const unsigned int visits_per_action = std::max<unsigned int>(1, max_iterations / (num_rounds * candidates.size()));
+        // A round also ends after its share of the remaining search time, such that searches bounded by
+        // MAX_SEARCH_TIME halve as well. Each candidate is visited at least once per round.
+        const double round_end_ms = elapsed_ms() + (max_search_time_ms - elapsed_ms()) / (round < num_rounds ? num_rounds - round : 1);
+        for (unsigned int visit = 0; visit < visits_per_action && budget_left && (visit == 0 || elapsed_ms() < round_end_ms); ++visit) {
+            for (const auto& action : candidates) {
+                budget_left = has_budget();
+                if(!budget_left) {
+                    break;
+                }
+                before_iteration();
+                iterate(root_, action);
+                num_iterations_ += 1;
+                visits[action] += 1;
+                max_visits = std::max(max_visits, visits[action]);
+            }
+        }
+
+        std::stable_sort(candidates.begin(), candidates.end(), [&](const ActionIdx& lhs, const ActionIdx& rhs) {
+            return root_action_score(lhs, gumbel_scores, visits, max_visits) > root_action_score(rhs, gumbel_scores, visits, max_visits); });
+        if(budget_left) {
+            candidates.resize((candidates.size() + 1) / 2);
+        }
+    }
+    root_best_action_ = candidates.front();
+}
+
+template<class S, class SE, class SO, class H>
+double Mcts<S,SE,SO,H>::root_action_score(const ActionIdx& action, const std::vector<double>& gumbel_scores,
+                                          const std::vector<unsigned int>& visits, const unsigned int& max_visits) const
+{
+    if(visits[action] == 0) {
+        // Not evaluated when the budget ran out early
+        return -std::numeric_limits<double>::infinity();
+    }
+    const double lower_bound = mcts_parameters_.uct_statistic.LOWER_BOUND;
+    const double upper_bound = mcts_parameters_.uct_statistic.UPPER_BOUND;
+    const double value_normalized = std::min(1.0, std::max(0.0,
+                                       (root_->getActionValue(action) - lower_bound) / (upper_bound - lower_bound)));
+    const auto& parameters = mcts_parameters_.root_action_selection;
+    if(!parameters.GUMBEL_SAMPLING) {
+        return value_normalized;
+    }
+    return gumbel_scores[action] + (parameters.GUMBEL_C_VISIT + max_visits) * parameters.GUMBEL_C_SCALE * value_normalized;
 }
 
 template<class S, class SE, class SO, class H>
-void Mcts<S,SE,SO,H>::iterate(const StageNodeSPtr& root_node)
+void Mcts<S,SE,SO,H>::iterate(const StageNodeSPtr& root_node, const ActionIdx& root_ego_action)
 {
     StageNodeSPtr node = root_node;
     StageNodeSPtr node_p;
+    TraceBuffer* const trace_buffer = sampled_trace_buffer();
+    ScopedTraceSpan iteration_span(trace_buffer, "iteration", "search", "iteration", num_iterations_);
 
     // --------------Select & Expand  -----------------
     // We descend the tree for all joint actions already available -> last node is the newly expanded one
-    std::pair<bool, bool> traversing_result(true, true);
-    while(traversing_result.first) {
-        traversing_result = node->select_or_expand(node);
+    std::pair<bool, bool> traversing_result;
+    {
+        ScopedTraceSpan selection_span(trace_buffer, "selection", "search");
+        MCTS_PERF_REGION(PERF_DESCENT);
+        traversing_result = select_or_expand(node, root_ego_action);
+        while(traversing_result.first) {
+            traversing_result = select_or_expand(node);
+        }
     }
 
     // -------------- Heuristic Update ----------------
     // Heuristic until terminal node only if state not terminal or max depth not reached
     if(traversing_result.second) {
+      MCTS_PROFILE_PHASE(profile_, ROLLOUT);
+      MCTS_PERF_REGION(PERF_ROLLOUT);
+      ScopedTraceSpan rollout_span(trace_buffer, "rollout", "heuristic", "depth", node->get_depth());
+      set_heuristic_random_stream();
       const auto& heuristics = heuristic_.calculate_heuristic_values(node);
       node->update_statistics(heuristics.first, heuristics.second);
     }
 
     // --------------- Backpropagation ----------------
     // Backpropagate, starting from parent node of newly expanded node
-    node_p = node->get_parent().lock();
-    while(true)
     {
-        node_p->update_statistics(node);
-        if(node_p->is_root())
+        MCTS_PROFILE_PHASE(profile_, BACKPROPAGATION);
+        MCTS_PERF_REGION(PERF_BACKPROPAGATION);
+        ScopedTraceSpan backpropagation_span(trace_buffer, "backpropagation", "search");
+        node_p = node->get_parent().lock();
+        while(true)
         {
-            break;
-        }
-        else
-        {
-            node = node->get_parent().lock();
-            node_p = node_p->get_parent().lock();
+            node_p->update_statistics(node);
+            if(node_p->is_root())
+            {
+                break;
+            }
+            else
+            {
+                node = node->get_parent().lock();
+                node_p = node_p->get_parent().lock();
+            }
         }
     }
 
@@ -158,6 +414,20 @@ void Mcts<S,SE,SO,H>::iterate(const StageNodeSPtr& root_node)
 #endif
 }
 
+template<class S, class SE, class SO, class H>
+std::pair<bool, bool> Mcts<S,SE,SO,H>::select_or_expand(StageNodeSPtr& node, const ActionIdx& ego_action)
+{
+#ifdef MCTS_PROFILING
+    const auto start = std::chrono::high_resolution_clock::now();
+    const std::pair<bool, bool> traversing_result = node->select_or_expand(node, ego_action);
+    profile_.record((!traversing_result.first && traversing_result.second) ? EXPANSION : SELECTION,
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count());
+    return traversing_result;
+#else
+    return node->select_or_expand(node, ego_action);
+#endif
+}
+
 template<class S, class SE, class SO, class H>
 std::string Mcts<S,SE,SO,H>::sprintf(const StageNodeSPtr& root_node) const
 {
@@ -177,15 +447,59 @@ unsigned int Mcts<S,SE,SO,H>::searchTime(){
 
 template<class S, class SE, class SO, class H>
 std::string Mcts<S,SE,SO,H>::nodeInfo(){
-    return sprintf(root_);
+    return treeStatistics().sprintf();
+}
+
+template<class S, class SE, class SO, class H>
+std::string Mcts<S,SE,SO,H>::record_inputs(const S& current_state, const HypothesisBeliefTracker* belief_tracker) const {
+    RecordWriter writer;
+    write_parameters(writer, mcts_parameters_);
+    writer.write(belief_tracker != nullptr);
+    if(belief_tracker) {
+        belief_tracker->save(writer);
+    }
+    save_state(writer, current_state);
+    return writer.data();
+}
+
+template<class S, class SE, class SO, class H>
+void Mcts<S,SE,SO,H>::write_record(const std::string& inputs) {
+    recorder_->write(SearchRecord{typeid(Mcts).name(), num_iterations_, returnBestAction(), search_time_, inputs});
 }
 
 template<class S, class SE, class SO, class H>
 ActionIdx Mcts<S,SE,SO,H>::returnBestAction(){
+    if(mcts_parameters_.root_action_selection.SEQUENTIAL_HALVING) {
+        return root_best_action_;
+    }
     ActionIdx idx_max = root_->get_best_action();
     return idx_max; 
 }
 
+template<class S, class SE, class SO, class H>
+double Mcts<S,SE,SO,H>::rootActionValue(const ActionIdx& action){
+    return root_->getActionValue(action);
+}
+
+template<class S, class SE, class SO, class H>
+unsigned int Mcts<S,SE,SO,H>::rootActionCount(const ActionIdx& action){
+    return root_->getActionCount(action);
+}
+
+template<class S, class SE, class SO, class H>
+unsigned int Mcts<S,SE,SO,H>::numNodes() const {
+    return root_ ? root_->get_num_nodes() : 0;
+}
+
+template<class S, class SE, class SO, class H>
+TreeStatistics Mcts<S,SE,SO,H>::treeStatistics() const {
+    TreeStatistics statistics;
+    if(root_) {
+        root_->collect_tree_statistics(statistics);
+    }
+    return statistics;
+}
+
 template<class S, class SE, class SO, class H>
 void Mcts<S,SE,SO,H>::printTreeToDotFile(std::string filename){ 
     root_->printTree(filename);
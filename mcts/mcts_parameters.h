@@ -18,6 +18,7 @@ struct MctsParameters{
   //MCTS
   double DISCOUNT_FACTOR;
   unsigned int RANDOM_SEED;
+  unsigned int THREAD_IDX; // index of a parallel search, selects its random streams for the same RANDOM_SEED
   unsigned int MAX_NUMBER_OF_ITERATIONS;
   unsigned int MAX_SEARCH_TIME;
   unsigned int MAX_SEARCH_DEPTH;
@@ -27,10 +28,38 @@ struct MctsParameters{
       unsigned int MAX_NUMBER_OF_ITERATIONS;
   };
 
+  struct BatchRolloutHeuristicParameters {
+      unsigned int BATCH_SIZE;
+  };
+
+  struct StageNodeParameters {
+      bool PROGRESSIVE_WIDENING; // cap the number of child joint actions, reach existing children of the ego action once reached
+      double PROGRESSIVE_WIDENING_K;
+      double PROGRESSIVE_WIDENING_ALPHA;
+  };
+
+  struct RootActionSelectionParameters {
+      bool SEQUENTIAL_HALVING; // split the iteration budget over root ego actions in halving rounds instead of UCB selection
+      unsigned int NUM_CANDIDATE_ACTIONS; // ego actions entering the first round, 0 = all
+      bool GUMBEL_SAMPLING; // sample candidates and rank them with Gumbel noise on the log action priors
+      double GUMBEL_C_VISIT; // value scale sigma(q) = (C_VISIT + max visits) * C_SCALE * q, q normalized by uct bounds
+      double GUMBEL_C_SCALE;
+  };
+
   struct UctStatisticParameters {
       double LOWER_BOUND;
       double UPPER_BOUND;
       double EXPLORATION_CONSTANT;
+      bool PROGRESSIVE_WIDENING; // otherwise each action is expanded once before UCB selection
+      bool PRIOR_ORDERED_WIDENING; // introduce actions by descending state action prior instead of randomly
+      double PROGRESSIVE_WIDENING_K;
+      double PROGRESSIVE_WIDENING_ALPHA;
+  };
+
+  struct RaveStatisticParameters {
+      int BLEND_SCHEDULE; // RaveStatistic::BlendSchedule
+      double EQUIVALENCE_PARAMETER; // node visits at which UCT and AMAF values are weighted equally
+      double AMAF_BIAS; // assumed bias of the normalized AMAF values for the minimum MSE schedule
   };
 
   struct HypothesisStatisticParameters {
@@ -41,6 +70,11 @@ struct MctsParameters{
       double PROGRESSIVE_WIDENING_K;
       double PROGRESSIVE_WIDENING_ALPHA;
       double EXPLORATION_CONSTANT;
+      unsigned int ACTION_CANDIDATE_BATCH_SIZE; // 0 = sample each expanded action separately
+  };
+
+  struct HypothesisEnsembleParameters {
+      unsigned int NUM_THREADS; // one tree per thread, 0 = hardware concurrency
   };
 
   struct HypothesisBeliefTrackerParameters {
@@ -53,8 +87,13 @@ struct MctsParameters{
 
   HypothesisStatisticParameters hypothesis_statistic;
   UctStatisticParameters uct_statistic;
+  RaveStatisticParameters rave_statistic;
   RandomHeuristicParameters random_heuristic;
+  BatchRolloutHeuristicParameters batch_rollout_heuristic;
+  StageNodeParameters stage_node;
+  RootActionSelectionParameters root_action_selection;
   HypothesisBeliefTrackerParameters hypothesis_belief_tracker;
+  HypothesisEnsembleParameters hypothesis_ensemble;
 };
 
 
@@ -62,6 +101,7 @@ inline MctsParameters mcts_default_parameters() {
   MctsParameters parameters;
   parameters.DISCOUNT_FACTOR = 0.9;
   parameters.RANDOM_SEED = 1000;
+  parameters.THREAD_IDX = 0;
   parameters.MAX_NUMBER_OF_ITERATIONS = 10000;
   parameters.MAX_SEARCH_TIME = 1000;
   parameters.MAX_SEARCH_DEPTH = 10000;
@@ -69,9 +109,29 @@ inline MctsParameters mcts_default_parameters() {
   parameters.random_heuristic.MAX_SEARCH_TIME = 10;
   parameters.random_heuristic.MAX_NUMBER_OF_ITERATIONS = 1000;
 
+  parameters.batch_rollout_heuristic.BATCH_SIZE = 16;
+
+  parameters.stage_node.PROGRESSIVE_WIDENING = false;
+  parameters.stage_node.PROGRESSIVE_WIDENING_K = 1;
+  parameters.stage_node.PROGRESSIVE_WIDENING_ALPHA = 0.5;
+
+  parameters.root_action_selection.SEQUENTIAL_HALVING = false;
+  parameters.root_action_selection.NUM_CANDIDATE_ACTIONS = 0;
+  parameters.root_action_selection.GUMBEL_SAMPLING = false;
+  parameters.root_action_selection.GUMBEL_C_VISIT = 50;
+  parameters.root_action_selection.GUMBEL_C_SCALE = 1.0;
+
   parameters.uct_statistic.LOWER_BOUND = -1000;
   parameters.uct_statistic.UPPER_BOUND = 100;
   parameters.uct_statistic.EXPLORATION_CONSTANT = 0.7;
+  parameters.uct_statistic.PROGRESSIVE_WIDENING = false;
+  parameters.uct_statistic.PRIOR_ORDERED_WIDENING = false;
+  parameters.uct_statistic.PROGRESSIVE_WIDENING_K = 1;
+  parameters.uct_statistic.PROGRESSIVE_WIDENING_ALPHA = 0.5;
+
+  parameters.rave_statistic.BLEND_SCHEDULE = 0; // = RaveStatistic::EQUIVALENCE
+  parameters.rave_statistic.EQUIVALENCE_PARAMETER = 50;
+  parameters.rave_statistic.AMAF_BIAS = 0.05;
 
   parameters.hypothesis_statistic.COST_BASED_ACTION_SELECTION = false;
   parameters.hypothesis_statistic.LOWER_COST_BOUND = 0;
@@ -80,6 +140,7 @@ inline MctsParameters mcts_default_parameters() {
   parameters.hypothesis_statistic.PROGRESSIVE_WIDENING_ALPHA = 0.5;
   parameters.hypothesis_statistic.PROGRESSIVE_WIDENING_K = 1;
   parameters.hypothesis_statistic.EXPLORATION_CONSTANT = 0.7;
+  parameters.hypothesis_statistic.ACTION_CANDIDATE_BATCH_SIZE = 0;
 
   parameters.hypothesis_belief_tracker.RANDOM_SEED_HYPOTHESIS_SAMPLING = 1000;
   parameters.hypothesis_belief_tracker.HISTORY_LENGTH = 4;
@@ -87,6 +148,8 @@ inline MctsParameters mcts_default_parameters() {
   parameters.hypothesis_belief_tracker.POSTERIOR_TYPE = 0; // = HypothesisBeliefTracker::PRODUCT;
   parameters.hypothesis_belief_tracker.FIXED_HYPOTHESIS_SET = {};
 
+  parameters.hypothesis_ensemble.NUM_THREADS = 0;
+
   return parameters;
 }
 } // namespace mcts
@@ -0,0 +1,51 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef MCTS_MEMORY_FOOTPRINT_H
+#define MCTS_MEMORY_FOOTPRINT_H
+
+#include <cstddef>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace mcts {
+
+// Estimated heap bytes held by standard containers, excluding the container object itself and heap memory
+// of the elements. Node based containers are assumed to allocate one node per element holding the element,
+// tree nodes three pointers and a color, hash nodes a next pointer and the cached hash.
+
+template<class T, class A>
+inline std::size_t heap_bytes(const std::vector<T, A>& vector) {
+    return vector.capacity() * sizeof(T);
+}
+
+template<class K, class V, class C, class A>
+inline std::size_t heap_bytes(const std::map<K, V, C, A>& map) {
+    return map.size() * (sizeof(typename std::map<K, V, C, A>::value_type) + 4 * sizeof(void*));
+}
+
+template<class K, class V, class H, class E, class A>
+inline std::size_t heap_bytes(const std::unordered_map<K, V, H, E, A>& map) {
+    return map.size() * (sizeof(typename std::unordered_map<K, V, H, E, A>::value_type) + 2 * sizeof(void*))
+              + map.bucket_count() * sizeof(void*);
+}
+
+// States holding heap memory implement std::size_t get_memory_footprint() const, the estimated heap bytes
+// owned by the state excluding memory shared with other states, others are assumed to hold none
+template<class Q>
+inline auto state_heap_bytes(const Q& state) -> decltype(state.get_memory_footprint()) {
+    return state.get_memory_footprint();
+}
+
+template<class Q, class... Ignored>
+inline std::size_t state_heap_bytes(const Q& state, const Ignored&...) {
+    return 0;
+}
+
+} // namespace mcts
+
+#endif // MCTS_MEMORY_FOOTPRINT_H
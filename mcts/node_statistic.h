@@ -10,6 +10,7 @@
 #include "state.h"
 #include <map>
 #include "common.h"
+#include "memory_footprint.h"
 #include "mcts_parameters.h"
 
 namespace mcts {
@@ -30,9 +31,16 @@ public:
                  mcts_parameters_(mcts_parameters) {}
     template <class S>
     ActionIdx choose_next_action(const StateInterface<S>& state);
+    // Prepares the update of an action not chosen by this statistic but given by the stage node, the
+    // action was chosen in an earlier iteration. Statistics with per-iteration selection state override it.
+    template <class S>
+    void prepare_given_action(const StateInterface<S>& state) {}
     void update_statistic(const NodeStatistic<Implementation>& changed_child_statistic); // update statistic during backpropagation from child node
     void update_from_heuristic(const NodeStatistic<Implementation>& heuristic_statistic); // update statistic during backpropagation from heuristic estimate
     ActionIdx get_best_action();
+    double get_action_value(const ActionIdx& action) const; // current value estimate of an action
+    unsigned int get_action_count(const ActionIdx& action) const; // number of times an action was selected
+    std::size_t get_memory_footprint() const; // estimated heap bytes held by the statistic
 
     void set_heuristic_estimate(const Reward& accum_rewards, const Cost& accum_ego_cost);
 
@@ -74,6 +82,21 @@ ActionIdx NodeStatistic<Implementation>::get_best_action()  {
     return impl().get_best_action();
 }
 
+template <class Implementation>
+double NodeStatistic<Implementation>::get_action_value(const ActionIdx& action) const {
+    return impl().get_action_value(action);
+}
+
+template <class Implementation>
+unsigned int NodeStatistic<Implementation>::get_action_count(const ActionIdx& action) const {
+    return impl().get_action_count(action);
+}
+
+template <class Implementation>
+std::size_t NodeStatistic<Implementation>::get_memory_footprint() const {
+    return impl().get_memory_footprint();
+}
+
 template <class Implementation>
 std::string NodeStatistic<Implementation>::print_node_information() const {
     return impl().print_node_information();
@@ -0,0 +1,262 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef MCTS_PERF_COUNTERS_H
+#define MCTS_PERF_COUNTERS_H
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace mcts {
+
+enum PerfCounter {
+    CYCLES = 0,
+    INSTRUCTIONS = 1,
+    CACHE_MISSES = 2,
+    BRANCH_MISSES = 3,
+    NUM_PERF_COUNTERS = 4
+};
+
+inline std::string perf_counter_name(const PerfCounter& counter) {
+    static const char* names[NUM_PERF_COUNTERS] = {"cycles", "instructions", "cache_misses", "branch_misses"};
+    return names[counter];
+}
+
+// Instrumented code regions, nested regions are also counted in their enclosing regions
+enum PerfRegion {
+    PERF_DESCENT = 0, // selection and expansion of an iteration
+    PERF_ROLLOUT = 1, // heuristic evaluation of an iteration
+    PERF_BACKPROPAGATION = 2,
+    PERF_HYPOTHESIS_SAMPLING = 3,
+    PERF_STAGE_NODE_SELECT_OR_EXPAND = 4,
+    PERF_UCT_CHOOSE_NEXT_ACTION = 5,
+    PERF_ROLLOUT_LOOP = 6, // simulation loop of the random heuristic
+    PERF_BELIEF_UPDATE = 7,
+    NUM_PERF_REGIONS = 8
+};
+
+inline std::string perf_region_name(const PerfRegion& region) {
+    static const char* names[NUM_PERF_REGIONS] = {"descent", "rollout", "backpropagation", "hypothesis_sampling",
+                                                  "stage_node_select_or_expand", "uct_choose_next_action",
+                                                  "rollout_loop", "belief_update"};
+    return names[region];
+}
+
+typedef std::array<std::uint64_t, NUM_PERF_COUNTERS> PerfCounterValues;
+
+/*
+ * Hardware counters of the calling thread, opened as one perf_event_open group to be read atomically. User space
+ * only. Counters the kernel or CPU does not provide (e.g. perf_event_paranoid > 2, most virtual machines) read zero.
+ */
+class PerfCounterGroup {
+public:
+    PerfCounterGroup() : fds_(), group_index_(), num_open_(0) {
+        fds_.fill(-1);
+        group_index_.fill(-1);
+        static const std::uint64_t configs[NUM_PERF_COUNTERS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                                 PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        int leader = -1;
+        for (unsigned int counter = 0; counter < NUM_PERF_COUNTERS; ++counter) {
+            fds_[counter] = open_counter(configs[counter], leader);
+            if(fds_[counter] >= 0) {
+                leader = leader < 0 ? fds_[counter] : leader;
+                group_index_[counter] = num_open_++;
+            }
+        }
+        if(leader >= 0) {
+            ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+    }
+
+    ~PerfCounterGroup() {
+        for (const auto& fd : fds_) {
+            if(fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    PerfCounterGroup(const PerfCounterGroup&) = delete;
+    PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+    bool is_available(const PerfCounter& counter) const { return fds_[counter] >= 0; }
+
+    // Counts since opening the group
+    PerfCounterValues read_values() const {
+        PerfCounterValues values;
+        values.fill(0);
+        if(num_open_ == 0) {
+            return values;
+        }
+        // PERF_FORMAT_GROUP layout: number of counters followed by their values in group order
+        std::uint64_t buffer[NUM_PERF_COUNTERS + 1];
+        const auto leader = group_leader();
+        if(::read(leader, buffer, sizeof(buffer)) < static_cast<ssize_t>((num_open_ + 1) * sizeof(std::uint64_t))) {
+            return values;
+        }
+        for (unsigned int counter = 0; counter < NUM_PERF_COUNTERS; ++counter) {
+            if(group_index_[counter] >= 0) {
+                values[counter] = buffer[1 + group_index_[counter]];
+            }
+        }
+        return values;
+    }
+
+    // Group of the calling thread, opened on first use
+    static PerfCounterGroup& thread_group() {
+        static thread_local PerfCounterGroup group;
+        return group;
+    }
+
+private:
+    static int open_counter(const std::uint64_t& config, const int& group_fd) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = config;
+        attr.disabled = group_fd < 0 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0));
+    }
+
+    int group_leader() const {
+        for (const auto& fd : fds_) {
+            if(fd >= 0) {
+                return fd;
+            }
+        }
+        return -1;
+    }
+
+    std::array<int, NUM_PERF_COUNTERS> fds_;
+    std::array<int, NUM_PERF_COUNTERS> group_index_;
+    int num_open_;
+};
+
+/*
+ * Calls and accumulated hardware counts per instrumented region. Regions record into the report of their thread,
+ * only in builds defining MCTS_PERF_COUNTERS. Each region reads the counters twice with a system call, this
+ * overhead is included in the counts of enclosing regions and dominates short kernels such as action selection,
+ * compare layouts by the counts of the same region.
+ */
+class PerfReport {
+public:
+    PerfReport() { reset(); }
+
+    static constexpr bool enabled() {
+#ifdef MCTS_PERF_COUNTERS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void record(const PerfRegion& region, const PerfCounterValues& counts) {
+        calls_[region] += 1;
+        for (unsigned int counter = 0; counter < NUM_PERF_COUNTERS; ++counter) {
+            counts_[region][counter] += counts[counter];
+        }
+    }
+
+    void merge(const PerfReport& other) {
+        for (unsigned int region = 0; region < NUM_PERF_REGIONS; ++region) {
+            calls_[region] += other.calls_[region];
+            for (unsigned int counter = 0; counter < NUM_PERF_COUNTERS; ++counter) {
+                counts_[region][counter] += other.counts_[region][counter];
+            }
+        }
+    }
+
+    // Removes the recordings of an earlier snapshot of this report
+    void subtract(const PerfReport& earlier) {
+        for (unsigned int region = 0; region < NUM_PERF_REGIONS; ++region) {
+            calls_[region] -= earlier.calls_[region];
+            for (unsigned int counter = 0; counter < NUM_PERF_COUNTERS; ++counter) {
+                counts_[region][counter] -= earlier.counts_[region][counter];
+            }
+        }
+    }
+
+    void reset() {
+        calls_.fill(0);
+        for (auto& counts : counts_) {
+            counts.fill(0);
+        }
+    }
+
+    std::uint64_t get_calls(const PerfRegion& region) const { return calls_[region]; }
+
+    std::uint64_t get_count(const PerfRegion& region, const PerfCounter& counter) const { return counts_[region][counter]; }
+
+    double get_count_per_call(const PerfRegion& region, const PerfCounter& counter) const {
+        return calls_[region] > 0 ? static_cast<double>(counts_[region][counter]) / calls_[region] : 0.0;
+    }
+
+    std::string sprintf() const {
+        std::stringstream ss;
+        for (unsigned int region = 0; region < NUM_PERF_REGIONS; ++region) {
+            const auto perf_region = static_cast<PerfRegion>(region);
+            ss << perf_region_name(perf_region) << ": calls=" << calls_[region];
+            for (unsigned int counter = 0; counter < NUM_PERF_COUNTERS; ++counter) {
+                ss << ", " << perf_counter_name(static_cast<PerfCounter>(counter)) << "="
+                   << get_count_per_call(perf_region, static_cast<PerfCounter>(counter));
+            }
+            ss << std::endl;
+        }
+        return ss.str();
+    }
+
+    // Report of the calling thread
+    static PerfReport& thread_report() {
+        static thread_local PerfReport report;
+        return report;
+    }
+
+private:
+    std::array<std::uint64_t, NUM_PERF_REGIONS> calls_;
+    std::array<PerfCounterValues, NUM_PERF_REGIONS> counts_;
+};
+
+// Records the counts during its lifetime as one call of a region into the report of the thread
+class ScopedPerfCounters {
+public:
+    explicit ScopedPerfCounters(const PerfRegion& region) :
+            region_(region), start_(PerfCounterGroup::thread_group().read_values()) {}
+
+    ~ScopedPerfCounters() {
+        PerfCounterValues counts = PerfCounterGroup::thread_group().read_values();
+        for (unsigned int counter = 0; counter < NUM_PERF_COUNTERS; ++counter) {
+            counts[counter] -= start_[counter];
+        }
+        PerfReport::thread_report().record(region_, counts);
+    }
+
+private:
+    const PerfRegion region_;
+    const PerfCounterValues start_;
+};
+
+#ifdef MCTS_PERF_COUNTERS
+#define MCTS_PERF_REGION(region) mcts::ScopedPerfCounters mcts_perf_counters_##region(mcts::region)
+#else
+#define MCTS_PERF_REGION(region) do { } while (false)
+#endif
+
+} // namespace mcts
+
+#endif // MCTS_PERF_COUNTERS_H
@@ -1,5 +1,5 @@
 // Copyright (c) 2019 Julian Bernhard
-// 
+//
 // This work is licensed under the terms of the MIT license.
 // For a copy, see <https://opensource.org/licenses/MIT>.
 // ========================================================
@@ -7,22 +7,117 @@
 #ifndef MCTS_RANDOM_GENERATOR_H
 #define MCTS_RANDOM_GENERATOR_H
 
+#include <cstdint>
+#include <limits>
 #include <random>
 
 namespace mcts {
 
+    // Counter-based generator Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+    // Output block n of stream s is a bijection of the counter (n, s) under the key (seed), streams of
+    // the same seed are thus independent and any position is reached without generating the preceding numbers.
+    class Philox4x32 {
+    public:
+        typedef std::uint32_t result_type;
+
+        explicit Philox4x32(const std::uint32_t& seed = 0, const std::uint64_t& stream = 0) :
+               key_{seed, 0}, stream_(stream), block_(0), output_(), output_idx_(4) {}
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+        result_type operator()() {
+            if(output_idx_ == 4) {
+                generate_block();
+            }
+            return output_[output_idx_++];
+        }
+
+        // Restarts at the beginning of a stream
+        void set_stream(const std::uint64_t& stream) {
+            stream_ = stream;
+            block_ = 0;
+            output_idx_ = 4;
+        }
+
+        std::uint64_t get_stream() const { return stream_; }
+
+        std::uint32_t get_seed() const { return key_[0]; }
+
+        // Numbers consumed from the current stream, Philox4x32(seed, stream) followed by discard(position) restores the generator
+        unsigned long long get_position() const { return block_ * 4 - (4 - output_idx_); }
+
+        void discard(unsigned long long num) {
+            const unsigned long long position = block_ * 4 - (4 - output_idx_) + num;
+            block_ = position / 4;
+            output_idx_ = 4;
+            if(position % 4 != 0) {
+                generate_block();
+                output_idx_ = position % 4;
+            }
+        }
+
+        // Single block for counter (c0, c1, c2, c3) and key (k0, k1)
+        static void philox(std::uint32_t counter[4], std::uint32_t k0, std::uint32_t k1) {
+            for (int round = 0; round < 10; ++round) {
+                const std::uint64_t product0 = static_cast<std::uint64_t>(0xD2511F53u) * counter[0];
+                const std::uint64_t product1 = static_cast<std::uint64_t>(0xCD9E8D57u) * counter[2];
+                const std::uint32_t c0 = static_cast<std::uint32_t>(product1 >> 32) ^ counter[1] ^ k0;
+                const std::uint32_t c2 = static_cast<std::uint32_t>(product0 >> 32) ^ counter[3] ^ k1;
+                counter[1] = static_cast<std::uint32_t>(product1);
+                counter[3] = static_cast<std::uint32_t>(product0);
+                counter[0] = c0;
+                counter[2] = c2;
+                k0 += 0x9E3779B9u;
+                k1 += 0xBB67AE85u;
+            }
+        }
+
+    private:
+        void generate_block() {
+            output_[0] = static_cast<std::uint32_t>(block_);
+            output_[1] = static_cast<std::uint32_t>(block_ >> 32);
+            output_[2] = static_cast<std::uint32_t>(stream_);
+            output_[3] = static_cast<std::uint32_t>(stream_ >> 32);
+            philox(output_, key_[0], key_[1]);
+            block_ += 1;
+            output_idx_ = 0;
+        }
+
+        std::uint32_t key_[2];
+        std::uint64_t stream_;
+        std::uint64_t block_; // next block to generate
+        std::uint32_t output_[4];
+        unsigned int output_idx_;
+    };
+
+    // Stream of a thread of a parallel search and an iteration of this thread,
+    // iteration 0 is used by objects living across iterations, e.g. node statistics
+    inline std::uint64_t random_stream(const std::uint32_t& thread_idx, const std::uint32_t& iteration) {
+        return (static_cast<std::uint64_t>(thread_idx) << 32) | iteration;
+    }
+
     class RandomGenerator {
     public:
-        mutable std::mt19937 random_generator_;
+        mutable Philox4x32 random_generator_;
     public:
-        RandomGenerator(const unsigned int& random_seed) :
-               random_generator_(random_seed) {}
+        RandomGenerator(const unsigned int& random_seed, const std::uint64_t& random_stream = 0) :
+               random_generator_(random_seed, random_stream) {}
 
         ~RandomGenerator() {}
 
+        void set_random_stream(const std::uint64_t& random_stream) { random_generator_.set_stream(random_stream); }
+
+        // Stream for objects created on the fly, e.g. statistics of rollout steps, which would
+        // otherwise all repeat the first numbers of the stream given by their parameters
+        std::uint64_t draw_random_stream() const {
+            const std::uint64_t high = random_generator_();
+            return (high << 32) | random_generator_();
+        }
+
     };
 } // namespace mcts
 
 
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,141 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef MCTS_SEARCH_PROFILE_H
+#define MCTS_SEARCH_PROFILE_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+namespace mcts {
+
+// Phases of a search iteration. Expansion is the descent step creating the new stage node,
+// it is dominated by the execution of the joint action in the environment.
+enum SearchPhase {
+    SELECTION = 0,
+    EXPANSION = 1,
+    ROLLOUT = 2,
+    BACKPROPAGATION = 3,
+    HYPOTHESIS_SAMPLING = 4,
+    NUM_SEARCH_PHASES = 5
+};
+
+inline std::string search_phase_name(const SearchPhase& phase) {
+    static const char* names[NUM_SEARCH_PHASES] = {"selection", "expansion", "rollout", "backpropagation",
+                                                   "hypothesis_sampling"};
+    return names[phase];
+}
+
+/*
+ * Call counts, accumulated time and latency histograms per search phase. Latencies are binned
+ * logarithmically, bucket b counts calls taking [2^b, 2^(b+1)) nanoseconds, bucket 0 also calls below 1ns.
+ * Recording only happens in builds defining MCTS_PROFILING, otherwise the profile stays empty.
+ */
+class SearchProfile {
+public:
+    static constexpr unsigned int NUM_LATENCY_BUCKETS = 32;
+    typedef std::array<std::uint64_t, NUM_LATENCY_BUCKETS> LatencyHistogram;
+
+    SearchProfile() { reset(); }
+
+    static constexpr bool enabled() {
+#ifdef MCTS_PROFILING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void record(const SearchPhase& phase, const std::uint64_t& nanoseconds) {
+        calls_[phase] += 1;
+        total_time_[phase] += nanoseconds;
+        histograms_[phase][latency_bucket(nanoseconds)] += 1;
+    }
+
+    // Adds the profile of another search, e.g. of the next planning step
+    void merge(const SearchProfile& other) {
+        for (unsigned int phase = 0; phase < NUM_SEARCH_PHASES; ++phase) {
+            calls_[phase] += other.calls_[phase];
+            total_time_[phase] += other.total_time_[phase];
+            for (unsigned int bucket = 0; bucket < NUM_LATENCY_BUCKETS; ++bucket) {
+                histograms_[phase][bucket] += other.histograms_[phase][bucket];
+            }
+        }
+    }
+
+    void reset() {
+        calls_.fill(0);
+        total_time_.fill(0);
+        for (auto& histogram : histograms_) {
+            histogram.fill(0);
+        }
+    }
+
+    std::uint64_t get_calls(const SearchPhase& phase) const { return calls_[phase]; }
+
+    // Accumulated time in nanoseconds
+    std::uint64_t get_total_time(const SearchPhase& phase) const { return total_time_[phase]; }
+
+    double get_mean_latency(const SearchPhase& phase) const {
+        return calls_[phase] > 0 ? static_cast<double>(total_time_[phase]) / calls_[phase] : 0.0;
+    }
+
+    const LatencyHistogram& get_latency_histogram(const SearchPhase& phase) const { return histograms_[phase]; }
+
+    static unsigned int latency_bucket(std::uint64_t nanoseconds) {
+        unsigned int bucket = 0;
+        while (nanoseconds > 1 && bucket < NUM_LATENCY_BUCKETS - 1) {
+            nanoseconds >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    std::string sprintf() const {
+        std::stringstream ss;
+        for (unsigned int phase = 0; phase < NUM_SEARCH_PHASES; ++phase) {
+            const auto search_phase = static_cast<SearchPhase>(phase);
+            ss << search_phase_name(search_phase) << ": calls=" << calls_[phase]
+               << ", total_ms=" << total_time_[phase] / 1e6 << ", mean_ns=" << get_mean_latency(search_phase) << std::endl;
+        }
+        return ss.str();
+    }
+
+private:
+    std::array<std::uint64_t, NUM_SEARCH_PHASES> calls_;
+    std::array<std::uint64_t, NUM_SEARCH_PHASES> total_time_;
+    std::array<LatencyHistogram, NUM_SEARCH_PHASES> histograms_;
+};
+
+// Records the lifetime of the timer as one call of a phase
+class ScopedPhaseTimer {
+public:
+    ScopedPhaseTimer(SearchProfile& profile, const SearchPhase& phase) :
+            profile_(profile), phase_(phase), start_(std::chrono::high_resolution_clock::now()) {}
+
+    ~ScopedPhaseTimer() {
+        profile_.record(phase_, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                      std::chrono::high_resolution_clock::now() - start_).count());
+    }
+
+private:
+    SearchProfile& profile_;
+    const SearchPhase phase_;
+    const std::chrono::high_resolution_clock::time_point start_;
+};
+
+#ifdef MCTS_PROFILING
+#define MCTS_PROFILE_PHASE(profile, phase) mcts::ScopedPhaseTimer mcts_phase_timer_##phase(profile, mcts::phase)
+#else
+#define MCTS_PROFILE_PHASE(profile, phase) do { } while (false)
+#endif
+
+} // namespace mcts
+
+#endif // MCTS_SEARCH_PROFILE_H
@@ -0,0 +1,353 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef MCTS_SEARCH_RECORDER_H
+#define MCTS_SEARCH_RECORDER_H
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mcts/mcts_parameters.h"
+#include "mcts/random_generator.h"
+#include "mcts/state.h"
+
+namespace mcts {
+
+/*
+ * Compact binary encoding of search inputs. Arithmetic values are stored in their native representation,
+ * records are thus only replayed on machines of the same architecture as the recording one.
+ */
+class RecordWriter {
+public:
+    RecordWriter() : buffer_() {}
+
+    template<typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type
+    write(const T& value) {
+        buffer_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void write(const std::string& value) {
+        write<std::uint64_t>(value.size());
+        buffer_.append(value);
+    }
+
+    template<typename A, typename B>
+    void write(const std::pair<A, B>& value) {
+        write(value.first);
+        write(value.second);
+    }
+
+    template<typename T>
+    void write(const std::vector<T>& values) { write_range(values.size(), values.begin(), values.end()); }
+
+    template<typename T>
+    void write(const std::deque<T>& values) { write_range(values.size(), values.begin(), values.end()); }
+
+    template<typename K, typename V>
+    void write(const std::unordered_map<K, V>& values) { write_range(values.size(), values.begin(), values.end()); }
+
+    // Seed, stream and position, the generator continues where it was when read back
+    void write(const Philox4x32& random_generator) {
+        write(random_generator.get_seed());
+        write(random_generator.get_stream());
+        write(random_generator.get_position());
+    }
+
+    const std::string& data() const { return buffer_; }
+
+private:
+    template<typename It>
+    void write_range(const std::size_t& size, It begin, It end) {
+        write<std::uint64_t>(size);
+        for (auto it = begin; it != end; ++it) {
+            write(*it);
+        }
+    }
+
+    std::string buffer_;
+};
+
+class RecordReader {
+public:
+    explicit RecordReader(const std::string& data) : data_(data), position_(0) {}
+
+    template<typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type
+    read(T& value) {
+        require(sizeof(T));
+        std::memcpy(&value, data_.data() + position_, sizeof(T));
+        position_ += sizeof(T);
+    }
+
+    void read(std::string& value) {
+        const auto size = read_size();
+        require(size);
+        value.assign(data_, position_, size);
+        position_ += size;
+    }
+
+    template<typename A, typename B>
+    void read(std::pair<A, B>& value) {
+        read(value.first);
+        read(value.second);
+    }
+
+    template<typename T>
+    void read(std::vector<T>& values) {
+        values.resize(read_size());
+        for (auto& value : values) {
+            read(value);
+        }
+    }
+
+    template<typename T>
+    void read(std::deque<T>& values) {
+        values.resize(read_size());
+        for (auto& value : values) {
+            read(value);
+        }
+    }
+
+    template<typename K, typename V>
+    void read(std::unordered_map<K, V>& values) {
+        values.clear();
+        const auto size = read_size();
+        for (std::uint64_t i = 0; i < size; ++i) {
+            std::pair<K, V> value;
+            read(value);
+            values.insert(value);
+        }
+    }
+
+    void read(Philox4x32& random_generator) {
+        std::uint32_t seed;
+        std::uint64_t stream;
+        unsigned long long position;
+        read(seed);
+        read(stream);
+        read(position);
+        random_generator = Philox4x32(seed, stream);
+        random_generator.discard(position);
+    }
+
+    template<typename T>
+    T read() {
+        T value;
+        read(value);
+        return value;
+    }
+
+    bool at_end() const { return position_ == data_.size(); }
+
+private:
+    std::uint64_t read_size() {
+        std::uint64_t size;
+        read(size);
+        return size;
+    }
+
+    void require(const std::size_t& num_bytes) const {
+        if(position_ + num_bytes > data_.size()) {
+            throw std::runtime_error("Search record truncated");
+        }
+    }
+
+    const std::string& data_;
+    std::size_t position_;
+};
+
+inline void write_parameters(RecordWriter& writer, const MctsParameters& parameters) {
+    writer.write(parameters.DISCOUNT_FACTOR);
+    writer.write(parameters.RANDOM_SEED);
+    writer.write(parameters.THREAD_IDX);
+    writer.write(parameters.MAX_NUMBER_OF_ITERATIONS);
+    writer.write(parameters.MAX_SEARCH_TIME);
+    writer.write(parameters.MAX_SEARCH_DEPTH);
+    writer.write(parameters.random_heuristic.MAX_SEARCH_TIME);
+    writer.write(parameters.random_heuristic.MAX_NUMBER_OF_ITERATIONS);
+    writer.write(parameters.batch_rollout_heuristic.BATCH_SIZE);
+    writer.write(parameters.stage_node.PROGRESSIVE_WIDENING);
+    writer.write(parameters.stage_node.PROGRESSIVE_WIDENING_K);
+    writer.write(parameters.stage_node.PROGRESSIVE_WIDENING_ALPHA);
+    writer.write(parameters.root_action_selection.SEQUENTIAL_HALVING);
+    writer.write(parameters.root_action_selection.NUM_CANDIDATE_ACTIONS);
+    writer.write(parameters.root_action_selection.GUMBEL_SAMPLING);
+    writer.write(parameters.root_action_selection.GUMBEL_C_VISIT);
+    writer.write(parameters.root_action_selection.GUMBEL_C_SCALE);
+    writer.write(parameters.uct_statistic.LOWER_BOUND);
+    writer.write(parameters.uct_statistic.UPPER_BOUND);
+    writer.write(parameters.uct_statistic.EXPLORATION_CONSTANT);
+    writer.write(parameters.uct_statistic.PROGRESSIVE_WIDENING);
+    writer.write(parameters.uct_statistic.PRIOR_ORDERED_WIDENING);
+    writer.write(parameters.uct_statistic.PROGRESSIVE_WIDENING_K);
+    writer.write(parameters.uct_statistic.PROGRESSIVE_WIDENING_ALPHA);
+    writer.write(parameters.rave_statistic.BLEND_SCHEDULE);
+    writer.write(parameters.rave_statistic.EQUIVALENCE_PARAMETER);
+    writer.write(parameters.rave_statistic.AMAF_BIAS);
+    writer.write(parameters.hypothesis_statistic.COST_BASED_ACTION_SELECTION);
+    writer.write(parameters.hypothesis_statistic.PROGRESSIVE_WIDENING_HYPOTHESIS_BASED);
+    writer.write(parameters.hypothesis_statistic.UPPER_COST_BOUND);
+    writer.write(parameters.hypothesis_statistic.LOWER_COST_BOUND);
+    writer.write(parameters.hypothesis_statistic.PROGRESSIVE_WIDENING_K);
+    writer.write(parameters.hypothesis_statistic.PROGRESSIVE_WIDENING_ALPHA);
+    writer.write(parameters.hypothesis_statistic.EXPLORATION_CONSTANT);
+    writer.write(parameters.hypothesis_statistic.ACTION_CANDIDATE_BATCH_SIZE);
+    writer.write(parameters.hypothesis_ensemble.NUM_THREADS);
+    writer.write(parameters.hypothesis_belief_tracker.RANDOM_SEED_HYPOTHESIS_SAMPLING);
+    writer.write(parameters.hypothesis_belief_tracker.HISTORY_LENGTH);
+    writer.write(parameters.hypothesis_belief_tracker.PROBABILITY_DISCOUNT);
+    writer.write(parameters.hypothesis_belief_tracker.POSTERIOR_TYPE);
+    writer.write(parameters.hypothesis_belief_tracker.FIXED_HYPOTHESIS_SET);
+}
+
+inline MctsParameters read_parameters(RecordReader& reader) {
+    MctsParameters parameters;
+    reader.read(parameters.DISCOUNT_FACTOR);
+    reader.read(parameters.RANDOM_SEED);
+    reader.read(parameters.THREAD_IDX);
+    reader.read(parameters.MAX_NUMBER_OF_ITERATIONS);
+    reader.read(parameters.MAX_SEARCH_TIME);
+    reader.read(parameters.MAX_SEARCH_DEPTH);
+    reader.read(parameters.random_heuristic.MAX_SEARCH_TIME);
+    reader.read(parameters.random_heuristic.MAX_NUMBER_OF_ITERATIONS);
+    reader.read(parameters.batch_rollout_heuristic.BATCH_SIZE);
+    reader.read(parameters.stage_node.PROGRESSIVE_WIDENING);
+    reader.read(parameters.stage_node.PROGRESSIVE_WIDENING_K);
+    reader.read(parameters.stage_node.PROGRESSIVE_WIDENING_ALPHA);
+    reader.read(parameters.root_action_selection.SEQUENTIAL_HALVING);
+    reader.read(parameters.root_action_selection.NUM_CANDIDATE_ACTIONS);
+    reader.read(parameters.root_action_selection.GUMBEL_SAMPLING);
+    reader.read(parameters.root_action_selection.GUMBEL_C_VISIT);
+    reader.read(parameters.root_action_selection.GUMBEL_C_SCALE);
+    reader.read(parameters.uct_statistic.LOWER_BOUND);
+    reader.read(parameters.uct_statistic.UPPER_BOUND);
+    reader.read(parameters.uct_statistic.EXPLORATION_CONSTANT);
+    reader.read(parameters.uct_statistic.PROGRESSIVE_WIDENING);
+    reader.read(parameters.uct_statistic.PRIOR_ORDERED_WIDENING);
+    reader.read(parameters.uct_statistic.PROGRESSIVE_WIDENING_K);
+    reader.read(parameters.uct_statistic.PROGRESSIVE_WIDENING_ALPHA);
+    reader.read(parameters.rave_statistic.BLEND_SCHEDULE);
+    reader.read(parameters.rave_statistic.EQUIVALENCE_PARAMETER);
+    reader.read(parameters.rave_statistic.AMAF_BIAS);
+    reader.read(parameters.hypothesis_statistic.COST_BASED_ACTION_SELECTION);
+    reader.read(parameters.hypothesis_statistic.PROGRESSIVE_WIDENING_HYPOTHESIS_BASED);
+    reader.read(parameters.hypothesis_statistic.UPPER_COST_BOUND);
+    reader.read(parameters.hypothesis_statistic.LOWER_COST_BOUND);
+    reader.read(parameters.hypothesis_statistic.PROGRESSIVE_WIDENING_K);
+    reader.read(parameters.hypothesis_statistic.PROGRESSIVE_WIDENING_ALPHA);
+    reader.read(parameters.hypothesis_statistic.EXPLORATION_CONSTANT);
+    reader.read(parameters.hypothesis_statistic.ACTION_CANDIDATE_BATCH_SIZE);
+    reader.read(parameters.hypothesis_ensemble.NUM_THREADS);
+    reader.read(parameters.hypothesis_belief_tracker.RANDOM_SEED_HYPOTHESIS_SAMPLING);
+    reader.read(parameters.hypothesis_belief_tracker.HISTORY_LENGTH);
+    reader.read(parameters.hypothesis_belief_tracker.PROBABILITY_DISCOUNT);
+    reader.read(parameters.hypothesis_belief_tracker.POSTERIOR_TYPE);
+    reader.read(parameters.hypothesis_belief_tracker.FIXED_HYPOTHESIS_SET);
+    return parameters;
+}
+
+// States support recording by implementing void save(RecordWriter&) const
+template<class S>
+inline auto save_state(RecordWriter& writer, const S& state) -> decltype(state.save(writer), void()) {
+    state.save(writer);
+}
+
+template<class S, class... Ignored>
+inline void save_state(RecordWriter& writer, const S& state, const Ignored&...) {
+    throw std::logic_error("State does not support search recording");
+}
+
+// A search as recorded: the type of the search (typeid name of its Mcts instantiation), its outcome
+// and the serialized inputs, i.e. parameters, belief tracker and root state
+struct SearchRecord {
+    std::string search_type;
+    unsigned int num_iterations;
+    ActionIdx best_action;
+    unsigned int search_time; // milliseconds
+    std::string inputs;
+};
+
+/*
+ * Appends one record per search to a binary file. The inputs are captured before the search and written
+ * together with its outcome after it, a replay bounded by the recorded number of iterations thus rebuilds
+ * the recorded tree. Searches may record concurrently into the same recorder.
+ */
+class SearchRecorder {
+public:
+    static constexpr const char* MAGIC = "MCTSREC1";
+
+    explicit SearchRecorder(const std::string& filename) :
+                 file_(filename, std::ios::binary),
+                 mutex_(),
+                 num_records_(0) {
+        if(!file_) {
+            throw std::runtime_error("Could not open search record file " + filename);
+        }
+        file_.write(MAGIC, std::strlen(MAGIC));
+    }
+
+    SearchRecorder(const SearchRecorder&) = delete;
+    SearchRecorder& operator=(const SearchRecorder&) = delete;
+
+    void write(const SearchRecord& record) {
+        RecordWriter writer;
+        writer.write(record.search_type);
+        writer.write(record.num_iterations);
+        writer.write(record.best_action);
+        writer.write(record.search_time);
+        writer.write(record.inputs);
+        std::lock_guard<std::mutex> lock(mutex_);
+        file_.write(writer.data().data(), writer.data().size());
+        file_.flush();
+        ++num_records_;
+    }
+
+    unsigned int get_num_records() const { return num_records_; }
+
+private:
+    std::ofstream file_;
+    std::mutex mutex_;
+    unsigned int num_records_;
+};
+
+inline std::vector<SearchRecord> read_search_records(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if(!file) {
+        throw std::runtime_error("Could not open search record file " + filename);
+    }
+    const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if(data.compare(0, std::strlen(SearchRecorder::MAGIC), SearchRecorder::MAGIC) != 0) {
+        throw std::runtime_error(filename + " is not a search record file");
+    }
+    const std::string records = data.substr(std::strlen(SearchRecorder::MAGIC));
+    RecordReader reader(records);
+    std::vector<SearchRecord> search_records;
+    while(!reader.at_end()) {
+        SearchRecord record;
+        reader.read(record.search_type);
+        reader.read(record.num_iterations);
+        reader.read(record.best_action);
+        reader.read(record.search_time);
+        reader.read(record.inputs);
+        search_records.push_back(record);
+    }
+    return search_records;
+}
+
+} // namespace mcts
+
+#endif // MCTS_SEARCH_RECORDER_H
@@ -0,0 +1,241 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef MCTS_SEARCH_TRACER_H
+#define MCTS_SEARCH_TRACER_H
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace mcts {
+
+// A completed span, names must be string literals (they are neither copied nor escaped)
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    std::uint64_t start; // nanoseconds since construction of the tracer
+    std::uint64_t duration;
+    const char* arg_name; // optional integer argument, nullptr if none
+    std::int64_t arg_value;
+};
+
+/*
+ * Preallocated ring buffer of the events of one thread. When full, the oldest events are overwritten and
+ * counted as dropped, recording thus never allocates. Only the owning thread pushes, the buffer is consumed by
+ * SearchTracer::flush while no search writes to it.
+ */
+class TraceBuffer {
+public:
+    TraceBuffer(const unsigned int& thread_idx, const std::size_t& capacity,
+                const std::chrono::steady_clock::time_point& epoch) :
+                thread_idx_(thread_idx),
+                epoch_(epoch),
+                events_(capacity),
+                next_(0),
+                size_(0),
+                num_dropped_(0) {
+        if(capacity == 0) {
+            throw std::invalid_argument("Trace buffer capacity must be positive");
+        }
+    }
+
+    void push(const TraceEvent& event) {
+        events_[next_] = event;
+        next_ = (next_ + 1) % events_.size();
+        if(size_ < events_.size()) {
+            ++size_;
+        } else {
+            ++num_dropped_;
+        }
+    }
+
+    // Nanoseconds since construction of the tracer
+    std::uint64_t now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch_).count();
+    }
+
+    // Calls consumer for the buffered events from oldest to newest and empties the buffer
+    template<class Consumer>
+    void consume(const Consumer& consumer) {
+        const std::size_t oldest = (next_ + events_.size() - size_) % events_.size();
+        for (std::size_t i = 0; i < size_; ++i) {
+            consumer(events_[(oldest + i) % events_.size()]);
+        }
+        size_ = 0;
+        num_dropped_ = 0;
+    }
+
+    unsigned int get_thread_idx() const { return thread_idx_; }
+    std::size_t size() const { return size_; }
+    std::size_t capacity() const { return events_.size(); }
+    std::uint64_t get_num_dropped() const { return num_dropped_; }
+
+private:
+    const unsigned int thread_idx_;
+    const std::chrono::steady_clock::time_point epoch_;
+    std::vector<TraceEvent> events_;
+    std::size_t next_;
+    std::size_t size_;
+    std::uint64_t num_dropped_;
+};
+
+/*
+ * Writes search spans as Chrome trace events (JSON array format), viewable in chrome://tracing or Perfetto.
+ * Each search thread records into a buffer of its own, identified by MctsParameters::THREAD_IDX which becomes
+ * the thread id of its events. Searches running concurrently with the same tracer thus need distinct
+ * THREAD_IDX, as they need for distinct random streams. flush appends the buffered events to the file and must
+ * not run concurrently with searches, e.g. at the end of a planning step. Iteration phases are only recorded
+ * for every sampling_interval-th iteration of a search.
+ */
+class SearchTracer {
+public:
+    SearchTracer(const std::string& filename, const unsigned int& sampling_interval = 100,
+                 const std::size_t& buffer_capacity = 1 << 14) :
+                 file_(filename),
+                 sampling_interval_(sampling_interval > 0 ? sampling_interval : 1),
+                 buffer_capacity_(buffer_capacity),
+                 epoch_(std::chrono::steady_clock::now()),
+                 buffers_(),
+                 mutex_(),
+                 num_events_(0),
+                 num_dropped_(0),
+                 first_event_(true) {
+        if(!file_) {
+            throw std::runtime_error("Could not open trace file " + filename);
+        }
+        file_ << "[";
+    }
+
+    ~SearchTracer() { close(); }
+
+    SearchTracer(const SearchTracer&) = delete;
+    SearchTracer& operator=(const SearchTracer&) = delete;
+
+    // Buffer of a search thread, allocated on first use
+    TraceBuffer& thread_buffer(const unsigned int& thread_idx) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& buffer = buffers_[thread_idx];
+        if(!buffer) {
+            buffer.reset(new TraceBuffer(thread_idx, buffer_capacity_, epoch_));
+            write_thread_name(thread_idx);
+        }
+        return *buffer;
+    }
+
+    bool is_sampled(const unsigned int& iteration) const { return iteration % sampling_interval_ == 0; }
+
+    void flush() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(!file_.is_open()) {
+            return;
+        }
+        for (auto& buffer : buffers_) {
+            const auto thread_idx = buffer.first;
+            num_dropped_ += buffer.second->get_num_dropped();
+            buffer.second->consume([this, &thread_idx](const TraceEvent& event) { write_event(event, thread_idx); });
+        }
+        file_.flush();
+    }
+
+    // Flushes and terminates the JSON array, events recorded afterwards are discarded
+    void close() {
+        flush();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(file_.is_open()) {
+            file_ << "\n]\n";
+            file_.close();
+        }
+    }
+
+    unsigned int get_sampling_interval() const { return sampling_interval_; }
+    // Events written to the file and events overwritten in full buffers before a flush
+    std::uint64_t get_num_events() const { return num_events_; }
+    std::uint64_t get_num_dropped() const { return num_dropped_; }
+
+private:
+    void begin_event() {
+        file_ << (first_event_ ? "\n" : ",\n");
+        first_event_ = false;
+    }
+
+    void write_thread_name(const unsigned int& thread_idx) {
+        begin_event();
+        file_ << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << ::getpid() << ",\"tid\":" << thread_idx
+              << ",\"args\":{\"name\":\"search thread " << thread_idx << "\"}}";
+    }
+
+    void write_event(const TraceEvent& event, const unsigned int& thread_idx) {
+        begin_event();
+        // Timestamps are in microseconds
+        file_ << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category << "\",\"ph\":\"X\",\"ts\":"
+              << event.start / 1000 << "." << pad_nanoseconds(event.start % 1000)
+              << ",\"dur\":" << event.duration / 1000 << "." << pad_nanoseconds(event.duration % 1000)
+              << ",\"pid\":" << ::getpid() << ",\"tid\":" << thread_idx;
+        if(event.arg_name) {
+            file_ << ",\"args\":{\"" << event.arg_name << "\":" << event.arg_value << "}";
+        }
+        file_ << "}";
+        ++num_events_;
+    }
+
+    static std::string pad_nanoseconds(const std::uint64_t& nanoseconds) {
+        const std::string digits = std::to_string(nanoseconds);
+        return std::string(3 - digits.size(), '0') + digits;
+    }
+
+    std::ofstream file_;
+    const unsigned int sampling_interval_;
+    const std::size_t buffer_capacity_;
+    const std::chrono::steady_clock::time_point epoch_;
+    std::map<unsigned int, std::unique_ptr<TraceBuffer>> buffers_;
+    std::mutex mutex_;
+    std::uint64_t num_events_;
+    std::uint64_t num_dropped_;
+    bool first_event_;
+};
+
+// Records its lifetime as a span into a trace buffer, does nothing without buffer
+class ScopedTraceSpan {
+public:
+    ScopedTraceSpan(TraceBuffer* buffer, const char* name, const char* category,
+                    const char* arg_name = nullptr, const std::int64_t& arg_value = 0) :
+                    buffer_(buffer),
+                    name_(name),
+                    category_(category),
+                    arg_name_(arg_name),
+                    arg_value_(arg_value),
+                    start_(buffer ? buffer->now() : 0) {}
+
+    ~ScopedTraceSpan() {
+        if(buffer_) {
+            buffer_->push(TraceEvent{name_, category_, start_, buffer_->now() - start_, arg_name_, arg_value_});
+        }
+    }
+
+    ScopedTraceSpan(const ScopedTraceSpan&) = delete;
+    ScopedTraceSpan& operator=(const ScopedTraceSpan&) = delete;
+
+private:
+    TraceBuffer* const buffer_;
+    const char* const name_;
+    const char* const category_;
+    const char* const arg_name_;
+    const std::int64_t arg_value_;
+    const std::uint64_t start_;
+};
+
+} // namespace mcts
+
+#endif // MCTS_SEARCH_TRACER_H
@@ -0,0 +1,429 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef MCTS_SHARED_MEMORY_SEARCH_H
+#define MCTS_SHARED_MEMORY_SEARCH_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "mcts/mcts.h"
+#include "mcts/hypothesis/hypothesis_belief_tracker.h"
+
+namespace mcts {
+
+/*
+ * Root statistics of independent root-parallel searches in a POSIX shared memory segment.
+ * The coordinator creates the segment, worker processes open it by name and each publishes the
+ * ego action values and visit counts at the root of its tree into its own slot. The coordinator merges
+ * the published slots into visit-weighted action values. Only processes on the same host can attach.
+ *
+ * Layout: header, then one cache line aligned slot per worker holding the publish flag, the number of
+ * iterations, num_actions action values (double) and num_actions visit counts (uint32).
+ */
+class SharedRootStatistics {
+public:
+    // Creates the segment, fails if a segment of this name exists. The segment is unlinked on destruction.
+    SharedRootStatistics(const std::string& name, const unsigned int& num_workers, const ActionIdx& num_actions);
+
+    // Opens a segment created by a coordinator
+    explicit SharedRootStatistics(const std::string& name);
+
+    ~SharedRootStatistics();
+
+    SharedRootStatistics(const SharedRootStatistics&) = delete;
+    SharedRootStatistics& operator=(const SharedRootStatistics&) = delete;
+
+    void publish(const unsigned int& worker_idx, const std::vector<double>& action_values,
+                 const std::vector<unsigned int>& action_counts, const unsigned int& num_iterations);
+
+    bool is_published(const unsigned int& worker_idx) const;
+
+    unsigned int num_published() const;
+
+    // Polls until all workers have published, returns false if the timeout expires first
+    bool wait_for_workers(const unsigned int& timeout_ms) const;
+
+    // Clears all publish flags such that the segment can be reused for the next search
+    void reset();
+
+    // Visit-weighted mean of the published action values, zero for actions no worker visited
+    std::vector<double> merged_action_values() const;
+
+    std::vector<unsigned int> merged_action_counts() const;
+
+    unsigned int merged_num_iterations() const;
+
+    // Action with the highest merged value among the visited ones
+    ActionIdx best_action() const;
+
+    unsigned int num_workers() const { return header()->num_workers; }
+    ActionIdx num_actions() const { return header()->num_actions; }
+    const std::string& name() const { return name_; }
+
+private:
+    struct SegmentHeader {
+        std::uint32_t magic;
+        std::uint32_t num_workers;
+        std::uint32_t num_actions;
+        std::uint32_t slot_size;
+    };
+
+    struct SlotHeader {
+        std::atomic<std::uint32_t> published;
+        std::uint32_t num_iterations;
+    };
+
+    static_assert(ATOMIC_INT_LOCK_FREE == 2, "publish flags in shared memory require lock-free atomics");
+
+    static constexpr std::uint32_t k_magic = 0x4d43534d; // "MCSM"
+    static constexpr std::size_t k_cache_line = 64;
+
+    static std::size_t slot_size(const ActionIdx& num_actions) {
+        const std::size_t size = sizeof(SlotHeader) + num_actions * (sizeof(double) + sizeof(std::uint32_t));
+        return (size + k_cache_line - 1) / k_cache_line * k_cache_line;
+    }
+
+    void map(const std::size_t& size);
+
+    const SegmentHeader* header() const { return static_cast<const SegmentHeader*>(address_); }
+
+    SlotHeader* slot(const unsigned int& worker_idx) const {
+        return reinterpret_cast<SlotHeader*>(static_cast<char*>(address_) + k_cache_line + worker_idx * header()->slot_size);
+    }
+
+    double* slot_values(const unsigned int& worker_idx) const {
+        return reinterpret_cast<double*>(reinterpret_cast<char*>(slot(worker_idx)) + sizeof(SlotHeader));
+    }
+
+    std::uint32_t* slot_counts(const unsigned int& worker_idx) const {
+        return reinterpret_cast<std::uint32_t*>(slot_values(worker_idx) + header()->num_actions);
+    }
+
+    std::string name_;
+    bool owner_;
+    int fd_;
+    void* address_;
+    std::size_t size_;
+};
+
+inline SharedRootStatistics::SharedRootStatistics(const std::string& name, const unsigned int& num_workers,
+                                                  const ActionIdx& num_actions) :
+                                      name_(name), owner_(true), fd_(-1), address_(nullptr),
+                                      size_(k_cache_line + num_workers * slot_size(num_actions)) {
+    fd_ = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot create shared memory segment " + name_ + ": " + std::strerror(errno));
+    }
+    if (ftruncate(fd_, size_) != 0) {
+        const std::string error(std::strerror(errno));
+        close(fd_);
+        shm_unlink(name_.c_str());
+        throw std::runtime_error("Cannot size shared memory segment " + name_ + ": " + error);
+    }
+    map(size_);
+    // ftruncate zero-fills, all slots start unpublished
+    SegmentHeader* segment_header = static_cast<SegmentHeader*>(address_);
+    segment_header->num_workers = num_workers;
+    segment_header->num_actions = num_actions;
+    segment_header->slot_size = slot_size(num_actions);
+    std::atomic_thread_fence(std::memory_order_release);
+    segment_header->magic = k_magic;
+}
+
+inline SharedRootStatistics::SharedRootStatistics(const std::string& name) :
+                                      name_(name), owner_(false), fd_(-1), address_(nullptr), size_(0) {
+    fd_ = shm_open(name_.c_str(), O_RDWR, 0);
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot open shared memory segment " + name_ + ": " + std::strerror(errno));
+    }
+    struct stat segment_stat;
+    if (fstat(fd_, &segment_stat) != 0 || static_cast<std::size_t>(segment_stat.st_size) < k_cache_line) {
+        close(fd_);
+        throw std::runtime_error("Invalid shared memory segment " + name_);
+    }
+    size_ = segment_stat.st_size;
+    map(size_);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header()->magic != k_magic || size_ < k_cache_line + header()->num_workers * header()->slot_size) {
+        munmap(address_, size_);
+        close(fd_);
+        throw std::runtime_error("Invalid shared memory segment " + name_);
+    }
+}
+
+inline SharedRootStatistics::~SharedRootStatistics() {
+    munmap(address_, size_);
+    close(fd_);
+    if (owner_) {
+        shm_unlink(name_.c_str());
+    }
+}
+
+inline void SharedRootStatistics::map(const std::size_t& size) {
+    address_ = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (address_ == MAP_FAILED) {
+        const std::string error(std::strerror(errno));
+        close(fd_);
+        if (owner_) {
+            shm_unlink(name_.c_str());
+        }
+        throw std::runtime_error("Cannot map shared memory segment " + name_ + ": " + error);
+    }
+}
+
+inline void SharedRootStatistics::publish(const unsigned int& worker_idx, const std::vector<double>& action_values,
+                                          const std::vector<unsigned int>& action_counts, const unsigned int& num_iterations) {
+    if (worker_idx >= num_workers() || action_values.size() != num_actions() || action_counts.size() != num_actions()) {
+        throw std::invalid_argument("Root statistics do not match the shared memory segment " + name_);
+    }
+    std::copy(action_values.begin(), action_values.end(), slot_values(worker_idx));
+    std::copy(action_counts.begin(), action_counts.end(), slot_counts(worker_idx));
+    slot(worker_idx)->num_iterations = num_iterations;
+    slot(worker_idx)->published.store(1, std::memory_order_release);
+}
+
+inline bool SharedRootStatistics::is_published(const unsigned int& worker_idx) const {
+    return slot(worker_idx)->published.load(std::memory_order_acquire) != 0;
+}
+
+inline unsigned int SharedRootStatistics::num_published() const {
+    unsigned int num_published = 0;
+    for (unsigned int worker_idx = 0; worker_idx < num_workers(); ++worker_idx) {
+        num_published += is_published(worker_idx);
+    }
+    return num_published;
+}
+
+inline bool SharedRootStatistics::wait_for_workers(const unsigned int& timeout_ms) const {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (num_published() < num_workers()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    return true;
+}
+
+inline void SharedRootStatistics::reset() {
+    for (unsigned int worker_idx = 0; worker_idx < num_workers(); ++worker_idx) {
+        slot(worker_idx)->published.store(0, std::memory_order_release);
+    }
+}
+
+inline std::vector<double> SharedRootStatistics::merged_action_values() const {
+    std::vector<double> weighted_values(num_actions(), 0.0);
+    std::vector<double> counts(num_actions(), 0.0);
+    for (unsigned int worker_idx = 0; worker_idx < num_workers(); ++worker_idx) {
+        if (!is_published(worker_idx)) {
+            continue;
+        }
+        for (ActionIdx action = 0; action < num_actions(); ++action) {
+            weighted_values[action] += slot_counts(worker_idx)[action] * slot_values(worker_idx)[action];
+            counts[action] += slot_counts(worker_idx)[action];
+        }
+    }
+    for (ActionIdx action = 0; action < num_actions(); ++action) {
+        weighted_values[action] = counts[action] > 0 ? weighted_values[action] / counts[action] : 0.0;
+    }
+    return weighted_values;
+}
+
+inline std::vector<unsigned int> SharedRootStatistics::merged_action_counts() const {
+    std::vector<unsigned int> counts(num_actions(), 0);
+    for (unsigned int worker_idx = 0; worker_idx < num_workers(); ++worker_idx) {
+        if (!is_published(worker_idx)) {
+            continue;
+        }
+        for (ActionIdx action = 0; action < num_actions(); ++action) {
+            counts[action] += slot_counts(worker_idx)[action];
+        }
+    }
+    return counts;
+}
+
+inline unsigned int SharedRootStatistics::merged_num_iterations() const {
+    unsigned int num_iterations = 0;
+    for (unsigned int worker_idx = 0; worker_idx < num_workers(); ++worker_idx) {
+        if (is_published(worker_idx)) {
+            num_iterations += slot(worker_idx)->num_iterations;
+        }
+    }
+    return num_iterations;
+}
+
+inline ActionIdx SharedRootStatistics::best_action() const {
+    const auto values = merged_action_values();
+    const auto counts = merged_action_counts();
+    ActionIdx best = 0;
+    double largest_value = -std::numeric_limits<double>::infinity();
+    for (ActionIdx action = 0; action < num_actions(); ++action) {
+        if (counts[action] > 0 && values[action] > largest_value) {
+            largest_value = values[action];
+            best = action;
+        }
+    }
+    return best;
+}
+
+// Runs worker(worker_idx) in num_workers forked child processes and waits for all of them,
+// throws if a worker did not exit cleanly
+inline void run_forked_workers(const unsigned int& num_workers, const std::function<void(unsigned int)>& worker) {
+    std::vector<pid_t> pids;
+    for (unsigned int worker_idx = 0; worker_idx < num_workers; ++worker_idx) {
+        const pid_t pid = fork();
+        if (pid == 0) {
+            int exit_code = 0;
+            try {
+                worker(worker_idx);
+            } catch (...) {
+                exit_code = 1;
+            }
+            _exit(exit_code); // skip atexit handlers and destructors of the parent's objects
+        }
+        if (pid < 0) {
+            for (const auto& started : pids) {
+                waitpid(started, nullptr, 0);
+            }
+            throw std::runtime_error(std::string("Cannot fork search worker: ") + std::strerror(errno));
+        }
+        pids.push_back(pid);
+    }
+    unsigned int num_failed = 0;
+    for (const auto& pid : pids) {
+        int status = 0;
+        if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            num_failed += 1;
+        }
+    }
+    if (num_failed > 0) {
+        throw std::runtime_error(std::to_string(num_failed) + " search workers failed");
+    }
+}
+
+/*
+ * Root-parallel search over processes: each worker searches an independent tree with its own random streams
+ * and publishes its root statistics into a SharedRootStatistics segment, the coordinator merges them.
+ * search() forks the workers itself, search_worker() is the entry point for workers started elsewhere,
+ * e.g. by Python's multiprocessing, attaching to a segment the coordinator created.
+ */
+template<class S, class SE, class SO, class H>
+class SharedMemorySearch {
+public:
+    SharedMemorySearch(const MctsParameters& mcts_parameters, const unsigned int& num_workers,
+                       const std::string& segment_name) :
+                            mcts_parameters_(mcts_parameters),
+                            num_workers_(num_workers),
+                            segment_name_(segment_name),
+                            ego_action_values_(),
+                            best_action_(0),
+                            num_iterations_(0) {}
+
+    template< class Q = S>
+    typename std::enable_if<std::is_base_of<RequiresHypothesis, Q>::value>::type
+    search(const S& current_state, HypothesisBeliefTracker& belief_tracker) {
+        search_forked(current_state.get_num_actions(current_state.get_ego_agent_idx()), [&](unsigned int worker_idx) {
+            // The child owns a copy of the tracker the state refers to, no need to clone the state
+            belief_tracker.set_random_stream(random_stream(worker_idx, 0));
+            Mcts<S, SE, SO, H> mcts(worker_parameters(mcts_parameters_, worker_idx));
+            mcts.search(current_state, belief_tracker);
+            SharedRootStatistics shared_statistics(segment_name_);
+            publish(mcts, current_state, shared_statistics, worker_idx);
+        });
+    }
+
+    template< class Q = S>
+    typename std::enable_if<!std::is_base_of<RequiresHypothesis, Q>::value>::type
+    search(const S& current_state) {
+        search_forked(current_state.get_num_actions(current_state.get_ego_agent_idx()), [&](unsigned int worker_idx) {
+            Mcts<S, SE, SO, H> mcts(worker_parameters(mcts_parameters_, worker_idx));
+            mcts.search(current_state);
+            SharedRootStatistics shared_statistics(segment_name_);
+            publish(mcts, current_state, shared_statistics, worker_idx);
+        });
+    }
+
+    // Searches in the calling process and publishes into an existing segment. Starts from the beliefs and
+    // sampled hypothesis of the coordinator's tracker, as a forked worker does, such that both publish the same
+    // root statistics.
+    template< class Q = S>
+    static typename std::enable_if<std::is_base_of<RequiresHypothesis, Q>::value>::type
+    search_worker(const S& current_state, const HypothesisBeliefTracker& belief_tracker,
+                  const MctsParameters& mcts_parameters, const std::string& segment_name,
+                  const unsigned int& worker_idx) {
+        SharedRootStatistics shared_statistics(segment_name);
+        HypothesisBeliefTracker worker_belief_tracker(belief_tracker);
+        worker_belief_tracker.set_random_stream(random_stream(worker_idx, 0));
+        const auto worker_state = current_state.clone_with_hypothesis(worker_belief_tracker.get_current_hypothesis());
+        Mcts<S, SE, SO, H> mcts(worker_parameters(mcts_parameters, worker_idx));
+        mcts.search(*worker_state, worker_belief_tracker);
+        publish(mcts, *worker_state, shared_statistics, worker_idx);
+    }
+
+    ActionIdx returnBestAction() const { return best_action_; }
+
+    unsigned int numIterations() const { return num_iterations_; }
+
+    const std::vector<double>& get_ego_action_values() const { return ego_action_values_; }
+
+private:
+    static MctsParameters worker_parameters(const MctsParameters& mcts_parameters, const unsigned int& worker_idx) {
+        MctsParameters parameters(mcts_parameters);
+        parameters.THREAD_IDX = worker_idx;
+        return parameters;
+    }
+
+    static void publish(Mcts<S, SE, SO, H>& mcts, const S& state, SharedRootStatistics& shared_statistics,
+                        const unsigned int& worker_idx) {
+        const ActionIdx num_actions = state.get_num_actions(state.get_ego_agent_idx());
+        std::vector<double> action_values(num_actions);
+        std::vector<unsigned int> action_counts(num_actions);
+        for (ActionIdx action = 0; action < num_actions; ++action) {
+            action_values[action] = mcts.rootActionValue(action);
+            action_counts[action] = mcts.rootActionCount(action);
+        }
+        shared_statistics.publish(worker_idx, action_values, action_counts, mcts.numIterations());
+    }
+
+    void search_forked(const ActionIdx& num_actions, const std::function<void(unsigned int)>& worker) {
+        SharedRootStatistics shared_statistics(segment_name_, num_workers_, num_actions);
+        run_forked_workers(num_workers_, worker);
+        if (shared_statistics.num_published() < num_workers_) {
+            throw std::runtime_error("Not all search workers published their root statistics");
+        }
+        ego_action_values_ = shared_statistics.merged_action_values();
+        best_action_ = shared_statistics.best_action();
+        num_iterations_ = shared_statistics.merged_num_iterations();
+    }
+
+    const MctsParameters mcts_parameters_;
+    const unsigned int num_workers_;
+    const std::string segment_name_;
+    std::vector<double> ego_action_values_;
+    ActionIdx best_action_;
+    unsigned int num_iterations_;
+};
+
+} // namespace mcts
+
+#endif // MCTS_SHARED_MEMORY_SEARCH_H
@@ -11,6 +11,11 @@
 #include "state.h"
 #include "intermediate_node.h"
 #include "node_statistic.h"
+#include "memory_footprint.h"
+#include "tree_statistics.h"
+#include "perf_counters.h"
+#include <cmath>
+#include <limits>
 #include <memory>
 #include <unordered_map>
 #include <boost/functional/hash.hpp>
@@ -19,10 +24,13 @@
 #include <fstream> 
 #include "mcts_parameters.h"
 #include <string>
+#include <type_traits>
 
 
 namespace mcts {
 
+constexpr ActionIdx EGO_ACTION_NOT_SET = std::numeric_limits<ActionIdx>::max();
+
 // hash function to use JoinAction as std::unordered map key
 template <typename Container> 
 struct container_hash {
@@ -64,23 +72,37 @@ struct container_hash {
 
         const JointAction joint_action_; // action_idx leading to this node
         const unsigned int max_num_joint_actions_;
+        const std::shared_ptr<unsigned int> num_nodes_; // node counter of this tree, trees of different searches are independent
         const unsigned int id_;
         const unsigned int depth_;
-        
-        static unsigned int num_nodes_;
+        unsigned int num_selections_; // non-terminal passes through this node, drives stage-level widening
 
         const MctsParameters & mcts_parameters_;
 
+        // Statistics of a new node continue on a stream drawn from the statistic of the parent, the first
+        // samples of the nodes, e.g. of the hypothesis policies, thus differ while depending on THREAD_IDX only
+        template<class Stats>
+        static typename std::enable_if<std::is_convertible<Stats*, RandomGenerator*>::value>::type
+        inherit_random_stream(IntermediateNode<S, Stats>& node, const IntermediateNode<S, Stats>& parent_node) {
+            node.set_random_stream(parent_node.draw_random_stream());
+        }
+
+        template<class Stats>
+        static typename std::enable_if<!std::is_convertible<Stats*, RandomGenerator*>::value>::type
+        inherit_random_stream(IntermediateNode<S, Stats>&, const IntermediateNode<S, Stats>&) {}
+
     public:
         StageNode(const StageNodeSPtr& parent, std::shared_ptr<S> state,
                   const JointAction& joint_action, const unsigned int& depth,
                   const MctsParameters & mcts_parameters);
         ~StageNode();
-        std::pair<bool, bool> select_or_expand(StageNodeSPtr& next_node);
+        std::pair<bool, bool> select_or_expand(StageNodeSPtr& next_node, const ActionIdx& ego_action = EGO_ACTION_NOT_SET);
         void update_statistics(const SE& ego_heuristic_estimate, const std::unordered_map<AgentIdx, SO>& other_heuristic_estimates);
         void update_statistics(const StageNodeSPtr& changed_child_node);
         bool each_agents_actions_expanded();
         bool each_joint_action_expanded();
+        bool require_joint_action_redirection() const;
+        typename StageChildMap::iterator select_existing_child(const ActionIdx& ego_action);
         StageNodeSPtr get_shared();
         const S* get_state() const {return state_.get();}
         StageNodeWPtr get_parent() {return parent_;}
@@ -93,9 +115,13 @@ struct container_hash {
         double getEgoAgentValue();
         int getEgoNodeVisits();
         double getActionValue(int action);
+        unsigned int getActionCount(int action);
         unsigned int get_depth() const;
 
-        static void reset_counter();
+        unsigned int get_num_nodes() const { return *num_nodes_; }
+
+        // Adds shape and estimated memory of the subtree below this node, iterates to not be limited by the stack size
+        void collect_tree_statistics(TreeStatistics& statistics) const;
 
         MCTS_TEST
     };
@@ -133,10 +159,18 @@ struct container_hash {
             num_actions *=state_->get_num_actions(agent_idx);
         }
         return num_actions; }() ),
-    id_(++num_nodes_),
+    num_nodes_(parent ? parent->num_nodes_ : std::make_shared<unsigned int>(0)),
+    id_(++(*num_nodes_)),
     depth_(depth),
+    num_selections_(0),
     mcts_parameters_(mcts_parameters)
     {
+        if(parent) {
+            inherit_random_stream(ego_int_node_, parent->ego_int_node_);
+            for (std::size_t idx = 0; idx < other_int_nodes_.size() && idx < parent->other_int_nodes_.size(); ++idx) {
+                inherit_random_stream(other_int_nodes_[idx], parent->other_int_nodes_[idx]);
+            }
+        }
     }
 
     template<class S, class SE, class SO, class H>
@@ -149,7 +183,8 @@ struct container_hash {
     }
 
     template<class S, class SE, class SO, class H>
-    std::pair<bool, bool> StageNode<S,SE, SO, H>::select_or_expand(StageNodeSPtr& next_node) {
+    std::pair<bool, bool> StageNode<S,SE, SO, H>::select_or_expand(StageNodeSPtr& next_node, const ActionIdx& ego_action) {
+        MCTS_PERF_REGION(PERF_STAGE_NODE_SELECT_OR_EXPAND);
         // helper function to fill rewards and costs
         auto fill_rewards = [this](const std::vector<Reward>& reward_list, const Cost& ego_cost, const JointAction& ja) {
             ego_int_node_.collect(reward_list[S::ego_agent_idx], ego_cost, ja[S::ego_agent_idx]);
@@ -165,21 +200,32 @@ struct container_hash {
             return std::make_pair(false, false);
         }
 
-        // Let each agent select an action according to its statistic model -> yields joint_action
+        // Let each agent select an action according to its statistic model -> yields joint_action,
+        // the ego action may be given from outside, e.g. by root action selection
         JointAction joint_action(state_->get_num_agents());
-        joint_action[S::ego_agent_idx] = ego_int_node_.choose_next_action();
-        for (AgentIdx ai = 1; ai < other_int_nodes_.size()+1; ++ai)
-        {
-            joint_action[ai] = other_int_nodes_[ai-1].choose_next_action();
+        joint_action[S::ego_agent_idx] = (ego_action == EGO_ACTION_NOT_SET) ? ego_int_node_.choose_next_action() : ego_action;
+
+        // Branching cap reached: the other agents do not select, an existing child of the ego action is reached
+        // and its joint action credited, such that no agent is updated for an action it did not take
+        auto it = require_joint_action_redirection() ? select_existing_child(joint_action[S::ego_agent_idx]) : children_.end();
+        if(it != children_.end()) {
+            for (auto& other_int_node : other_int_nodes_) {
+                other_int_node.prepare_given_action();
+            }
+        } else {
+            for (AgentIdx ai = 1; ai < other_int_nodes_.size()+1; ++ai)
+            {
+                joint_action[ai] = other_int_nodes_[ai-1].choose_next_action();
+            }
+            // Check if joint action was already expanded
+            it = children_.find(joint_action);
         }
-
-        // Check if joint action was already expanded
-        auto it = children_.find(joint_action);
+        num_selections_ += 1;
         if( it != children_.end())
         {
             // SELECT EXISTING NODE
             next_node = it->second;
-            fill_rewards(joint_rewards_[joint_action], ego_costs_[joint_action], joint_action);
+            fill_rewards(joint_rewards_[it->first], ego_costs_[it->first], it->first);
             return std::make_pair(true, true);
         }
         else
@@ -208,17 +254,36 @@ struct container_hash {
     }
 
     template<class S, class SE, class SO, class H>
-    unsigned int StageNode<S,SE, SO, H>::num_nodes_ = 0;
+    bool StageNode<S,SE, SO, H>::each_joint_action_expanded() {
+        return children_.size() == max_num_joint_actions_;
+    
+    }
 
     template<class S, class SE, class SO, class H>
-    void StageNode<S,SE, SO, H>::reset_counter() {
-        StageNode<S,SE, SO, H>::num_nodes_ = 0;
+    bool StageNode<S,SE, SO, H>::require_joint_action_redirection() const {
+        if(!mcts_parameters_.stage_node.PROGRESSIVE_WIDENING || children_.empty()) {
+            return false;
+        }
+        const double widening_term = mcts_parameters_.stage_node.PROGRESSIVE_WIDENING_K *
+                                     std::pow(num_selections_, mcts_parameters_.stage_node.PROGRESSIVE_WIDENING_ALPHA);
+        return children_.size() > widening_term;
     }
 
     template<class S, class SE, class SO, class H>
-    bool StageNode<S,SE, SO, H>::each_joint_action_expanded() {
-        return children_.size() == max_num_joint_actions_;
-    
+    typename StageNode<S,SE, SO, H>::StageChildMap::iterator StageNode<S,SE, SO, H>::select_existing_child(
+                                                                        const ActionIdx& ego_action) {
+        // Cycles through the children of the ego action, each expanded joint action of the other agents is
+        // thus reached equally often. Returns end() if no child with this ego action exists, which then gets expanded.
+        std::vector<typename StageChildMap::iterator> candidates;
+        for (auto it = children_.begin(); it != children_.end(); ++it) {
+            if(it->first[S::ego_agent_idx] == ego_action) {
+                candidates.push_back(it);
+            }
+        }
+        if(candidates.empty()) {
+            return children_.end();
+        }
+        return candidates[num_selections_ % candidates.size()];
     }
 
     template<class S, class SE, class SO, class H>
@@ -246,6 +311,16 @@ struct container_hash {
         return best;
     }
 
+    template<class S, class SE, class SO, class H>
+    double StageNode<S,SE, SO, H>::getActionValue(int action){
+        return ego_int_node_.get_action_value(action);
+    }
+
+    template<class S, class SE, class SO, class H>
+    unsigned int StageNode<S,SE, SO, H>::getActionCount(int action){
+        return ego_int_node_.get_action_count(action);
+    }
+
     template<class S, class SE, class SO, class H>
     std::string StageNode<S,SE, SO, H>::sprintf() const
     {
@@ -275,6 +350,39 @@ struct container_hash {
         return ss.str();
     };
 
+    template<class S, class SE, class SO, class H>
+    void StageNode<S,SE, SO, H>::collect_tree_statistics(TreeStatistics& statistics) const
+    {
+        std::vector<const StageNode<S,SE, SO, H>*> open_nodes{this};
+        while(!open_nodes.empty()) {
+            const auto node = open_nodes.back();
+            open_nodes.pop_back();
+            statistics.add_node(node->depth_, node->children_.size());
+
+            statistics.node_bytes += sizeof(StageNode<S,SE, SO, H>) - sizeof(IntermediateNode<S, SE>)
+                                        + heap_bytes(node->joint_action_);
+            statistics.state_bytes += sizeof(S) + state_heap_bytes(*node->state_);
+            statistics.statistic_bytes += sizeof(IntermediateNode<S, SE>) + node->ego_int_node_.get_memory_footprint()
+                                        + heap_bytes(node->other_int_nodes_);
+            for (const auto& other_int_node : node->other_int_nodes_) {
+                statistics.statistic_bytes += other_int_node.get_memory_footprint();
+            }
+
+            statistics.edge_bytes += heap_bytes(node->children_) + heap_bytes(node->joint_rewards_)
+                                        + heap_bytes(node->ego_costs_);
+            for (const auto& child : node->children_) {
+                statistics.edge_bytes += heap_bytes(child.first);
+                open_nodes.push_back(child.second.get());
+            }
+            for (const auto& rewards : node->joint_rewards_) {
+                statistics.edge_bytes += heap_bytes(rewards.first) + heap_bytes(rewards.second);
+            }
+            for (const auto& cost : node->ego_costs_) {
+                statistics.edge_bytes += heap_bytes(cost.first);
+            }
+        }
+    }
+
     template<class S, class SE, class SO, class H>
     void StageNode<S,SE, SO, H>::printTree(std::string filename, const unsigned int& max_depth) 
     {      
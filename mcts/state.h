@@ -21,6 +21,7 @@ namespace mcts {
 typedef std::size_t ActionIdx;
 typedef unsigned int AgentIdx;
 typedef std::vector<ActionIdx> JointAction;
+typedef std::vector<AgentIdx> AgentIdxVector;
 
 typedef double Reward;
 typedef double Cost;
@@ -71,17 +72,27 @@ public:
 
     bool is_terminal() const;
 
-    const std::vector<AgentIdx> get_other_agent_idx() const;
+    // Implementations should return a const reference to indices computed once, e.g. const AgentIdxVector&.
+    // Returning a vector by value is still supported for existing environments, but allocates on each call.
+    decltype(auto) get_other_agent_idx() const;
 
     const AgentIdx get_ego_agent_idx() const;
 
     const AgentIdx get_num_agents() const;
 
+    // Optional prior over the actions of an agent used to order action introduction, e.g. during progressive
+    // widening. Implementations may hide this default, an empty vector means no prior is available.
+    std::vector<double> get_action_priors(const AgentIdx& agent_idx) const { return std::vector<double>(); }
+
     static const AgentIdx ego_agent_idx;
 
     std::string sprintf() const;
 
+#ifdef CRTP_DYNAMIC_INTERFACE
+    virtual ~StateInterface() {}; // dynamic_cast in impl() requires a polymorphic interface
+#else
     ~StateInterface() {};
+#endif
 
     static const Implementation& cast();
 
@@ -114,7 +125,7 @@ inline bool StateInterface<Implementation>::is_terminal() const {
 }
 
 template<typename Implementation>
-inline const std::vector<AgentIdx> StateInterface<Implementation>::get_other_agent_idx() const {
+inline decltype(auto) StateInterface<Implementation>::get_other_agent_idx() const {
     return impl().get_other_agent_idx();
 }
 
@@ -0,0 +1,262 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef RAVE_STATISTIC_H
+#define RAVE_STATISTIC_H
+
+#include "mcts/mcts.h"
+#include <iostream>
+#include <iomanip>
+#include <limits>
+
+namespace mcts {
+
+// Upper confidence bound selection on action values blended with all-moves-as-first (AMAF) values.
+// Each action this agent takes below the node within one iteration, in the tree or in the rollout,
+// updates the AMAF value of this action as if it had been taken first at the node (rapid action value estimation).
+// Bounds and exploration constant are shared with UctStatistic.
+class RaveStatistic : public mcts::NodeStatistic<RaveStatistic>,
+                             public mcts::RandomGenerator,
+                             mcts::RequiresRolloutActions
+{
+public:
+    MCTS_TEST
+
+    enum BlendSchedule {
+        EQUIVALENCE = 0, // beta = sqrt(k/(3N+k)) with node visits N
+        MINIMUM_MSE = 1 // beta = n_amaf/(n + n_amaf + 4b^2 n n_amaf) per action
+    };
+
+    RaveStatistic(ActionIdx num_actions, AgentIdx agent_idx, const MctsParameters & mcts_parameters) :
+             NodeStatistic<RaveStatistic>(num_actions, agent_idx, mcts_parameters),
+             RandomGenerator(mcts_parameters.RANDOM_SEED, random_stream(mcts_parameters.THREAD_IDX, 0)),
+             value_(0.0f),
+             latest_return_(0.0),
+             subsequent_actions_(),
+             ucb_statistics_([&]() -> std::map<ActionIdx, UcbPair>{
+             std::map<ActionIdx, UcbPair> map;
+             for (ActionIdx ai = 0; ai < num_actions; ++ai) { map[ai] = UcbPair();}
+             return map;
+             }()),
+             amaf_statistics_(ucb_statistics_),
+             total_node_visits_(0),
+             unexpanded_actions_(num_actions),
+             upper_bound(mcts_parameters.uct_statistic.UPPER_BOUND),
+             lower_bound(mcts_parameters.uct_statistic.LOWER_BOUND),
+             k_discount_factor(mcts_parameters.DISCOUNT_FACTOR),
+             k_exploration_constant(mcts_parameters.uct_statistic.EXPLORATION_CONSTANT),
+             k_blend_schedule(static_cast<BlendSchedule>(mcts_parameters.rave_statistic.BLEND_SCHEDULE)),
+             k_equivalence_parameter(mcts_parameters.rave_statistic.EQUIVALENCE_PARAMETER),
+             k_amaf_bias(mcts_parameters.rave_statistic.AMAF_BIAS) {
+                 // initialize action indexes from 0 to (number of actions -1)
+                 std::iota(unexpanded_actions_.begin(), unexpanded_actions_.end(), 0);
+             }
+
+    ~RaveStatistic() {};
+
+    template <class S>
+    ActionIdx choose_next_action(const S& state) {
+        if(unexpanded_actions_.empty())
+        {
+            // Select an action based on the UCB formula on blended values
+            ActionIdx selected_action = 0;
+            double largest_value = -std::numeric_limits<double>::infinity();
+            for (const auto& ucb_pair : ucb_statistics_) {
+                const double value = calculate_ucb_value(ucb_pair.first);
+                if(value > largest_value) {
+                    largest_value = value;
+                    selected_action = ucb_pair.first;
+                }
+            }
+            return selected_action;
+        }
+
+        // Expand the unexpanded action with the highest AMAF value, randomly if none has been seen yet
+        std::size_t array_idx = unexpanded_actions_.size();
+        double largest_amaf_value = -std::numeric_limits<double>::infinity();
+        for (std::size_t idx = 0; idx < unexpanded_actions_.size(); ++idx) {
+            const UcbPair& amaf_pair = amaf_statistics_.at(unexpanded_actions_[idx]);
+            if(amaf_pair.action_count_ > 0 && amaf_pair.action_value_ > largest_amaf_value) {
+                largest_amaf_value = amaf_pair.action_value_;
+                array_idx = idx;
+            }
+        }
+        if(array_idx == unexpanded_actions_.size()) {
+            std::uniform_int_distribution<std::size_t> random_action_selection(0,unexpanded_actions_.size()-1);
+            array_idx = random_action_selection(random_generator_);
+        }
+        ActionIdx selected_action = unexpanded_actions_[array_idx];
+        unexpanded_actions_.erase(unexpanded_actions_.begin()+array_idx);
+        return selected_action;
+    }
+
+    ActionIdx get_best_action() {
+        // Only actions taken at least once are candidates, AMAF values alone are not trusted for the final decision
+        ActionIdx best = 0;
+        double largest_value = -std::numeric_limits<double>::infinity();
+        for (const auto& ucb_pair : ucb_statistics_) {
+            if(ucb_pair.second.action_count_ == 0) {
+                continue;
+            }
+            const double value = calculate_blended_value(ucb_pair.first);
+            if(value > largest_value) {
+                largest_value = value;
+                best = ucb_pair.first;
+            }
+        }
+        return best;
+    }
+
+    double get_action_value(const ActionIdx& action) const {
+        return ucb_statistics_.at(action).action_value_;
+    }
+
+    unsigned int get_action_count(const ActionIdx& action) const {
+        return ucb_statistics_.at(action).action_count_;
+    }
+
+    std::size_t get_memory_footprint() const {
+        return heap_bytes(subsequent_actions_) + heap_bytes(ucb_statistics_) + heap_bytes(amaf_statistics_)
+                  + heap_bytes(unexpanded_actions_);
+    }
+
+    void update_from_heuristic(const NodeStatistic<RaveStatistic>& heuristic_statistic)
+    {
+        const RaveStatistic& heuristic_statistic_impl = heuristic_statistic.impl();
+        value_ = heuristic_statistic_impl.value_;
+        latest_return_ = value_;
+        subsequent_actions_ = heuristic_statistic_impl.subsequent_actions_;
+        total_node_visits_ += 1;
+    }
+
+    void update_statistic(const NodeStatistic<RaveStatistic>& changed_child_statistic) {
+        const RaveStatistic& changed_rave_statistic = changed_child_statistic.impl();
+
+        //Action Value update step
+        UcbPair& ucb_pair = ucb_statistics_[collected_reward_.first];
+        latest_return_ = collected_reward_.second + k_discount_factor * changed_rave_statistic.latest_return_;
+        ucb_pair.action_count_ += 1;
+        ucb_pair.action_value_ = ucb_pair.action_value_ + (latest_return_ - ucb_pair.action_value_) / ucb_pair.action_count_;
+        total_node_visits_ += 1;
+        value_ = value_ + (latest_return_ - value_) / total_node_visits_;
+
+        // AMAF update step: the collected action and all actions taken afterwards in this iteration
+        subsequent_actions_ = changed_rave_statistic.subsequent_actions_;
+        add_subsequent_action(collected_reward_.first);
+        for (const auto& action : subsequent_actions_) {
+            auto amaf_it = amaf_statistics_.find(action);
+            if(amaf_it == amaf_statistics_.end()) {
+                continue; // action not available in this node
+            }
+            UcbPair& amaf_pair = amaf_it->second;
+            amaf_pair.action_count_ += 1;
+            amaf_pair.action_value_ = amaf_pair.action_value_ + (latest_return_ - amaf_pair.action_value_) / amaf_pair.action_count_;
+        }
+        VLOG_EVERY_N(6, 10) << "Agent "<< agent_idx_ <<", Action reward, action " << collected_reward_.first << ", Q(s,a) = "
+                             << ucb_pair.action_value_ << ", Q_amaf(s,a) = " << amaf_statistics_[collected_reward_.first].action_value_;
+    }
+
+    void set_heuristic_estimate(const Reward& accum_rewards, const Cost& accum_ego_cost)
+    {
+       value_ = accum_rewards;
+    }
+
+    // Actions the agent took during the rollout of the heuristic, set on the heuristic statistic only
+    void set_rollout_actions(const std::vector<ActionIdx>& rollout_actions)
+    {
+        subsequent_actions_.clear();
+        for (const auto& action : rollout_actions) {
+            add_subsequent_action(action);
+        }
+    }
+
+    std::string print_node_information() const
+    {
+        std::stringstream ss;
+        ss << std::setprecision(2) << "V=" << value_ << ", N=" << total_node_visits_;
+        return ss.str();
+    }
+
+    std::string print_edge_information(const ActionIdx& action ) const
+    {
+        std::stringstream ss;
+        auto action_it = ucb_statistics_.find(action);
+        if(action_it != ucb_statistics_.end()) {
+            const UcbPair& amaf_pair = amaf_statistics_.at(action);
+            ss << std::setprecision(2) <<  "a=" << int(action) << ", N=" << action_it->second.action_count_ << ", V=" << action_it->second.action_value_
+               << ", N_amaf=" << amaf_pair.action_count_ << ", V_amaf=" << amaf_pair.action_value_;
+        }
+        return ss.str();
+    }
+
+    typedef struct UcbPair
+    {
+        UcbPair() : action_count_(0), action_value_(0.0f) {};
+        unsigned action_count_;
+        double action_value_;
+    } UcbPair;
+
+    // Weight of the AMAF value in the blended action value
+    double calculate_amaf_weight(const UcbPair& ucb_pair, const UcbPair& amaf_pair) const
+    {
+        if(amaf_pair.action_count_ == 0 || (k_blend_schedule == EQUIVALENCE && k_equivalence_parameter <= 0)) {
+            return 0.0;
+        }
+        if(k_blend_schedule == MINIMUM_MSE) {
+            const double n = ucb_pair.action_count_;
+            const double n_amaf = amaf_pair.action_count_;
+            return n_amaf / (n + n_amaf + 4 * k_amaf_bias * k_amaf_bias * n * n_amaf);
+        }
+        return sqrt(k_equivalence_parameter / (3 * total_node_visits_ + k_equivalence_parameter));
+    }
+
+    double calculate_blended_value(const ActionIdx& action) const
+    {
+        const UcbPair& ucb_pair = ucb_statistics_.at(action);
+        const UcbPair& amaf_pair = amaf_statistics_.at(action);
+        const double beta = calculate_amaf_weight(ucb_pair, amaf_pair);
+        const double blended_value = (1.0 - beta) * ucb_pair.action_value_ + beta * amaf_pair.action_value_;
+        double value_normalized = (blended_value-lower_bound)/(upper_bound-lower_bound);
+        MCTS_EXPECT_TRUE(value_normalized>=0);
+        MCTS_EXPECT_TRUE(value_normalized<=1);
+        return value_normalized;
+    }
+
+    double calculate_ucb_value(const ActionIdx& action) const
+    {
+        return calculate_blended_value(action) + 2 * k_exploration_constant *
+                    sqrt( (2* log(total_node_visits_)) / ( ucb_statistics_.at(action).action_count_)  );
+    }
+
+private:
+    void add_subsequent_action(const ActionIdx& action) {
+        // Only the first occurrence counts, sequences are short such that a linear search suffices
+        if(std::find(subsequent_actions_.begin(), subsequent_actions_.end(), action) == subsequent_actions_.end()) {
+            subsequent_actions_.push_back(action);
+        }
+    }
+
+    double value_;
+    double latest_return_;   // tracks the return during backpropagation
+    std::vector<ActionIdx> subsequent_actions_; // actions of this agent from this node on in the latest iteration
+    std::map<ActionIdx, UcbPair> ucb_statistics_; // first: action selection count, action-value
+    std::map<ActionIdx, UcbPair> amaf_statistics_; // first: AMAF count, AMAF action-value
+    unsigned int total_node_visits_;
+    std::vector<int> unexpanded_actions_; // contains all action indexes which have not been expanded yet
+
+    // PARAMS
+    const double upper_bound;
+    const double lower_bound;
+    const double k_discount_factor;
+    const double k_exploration_constant;
+    const BlendSchedule k_blend_schedule;
+    const double k_equivalence_parameter;
+    const double k_amaf_bias;
+};
+
+} // namespace mcts
+
+#endif
@@ -10,18 +10,19 @@
 #include "mcts/mcts.h"
 #include <iostream>
 #include <iomanip>
+#include <limits>
 
 namespace mcts {
 
 // A upper confidence bound implementation
-class UctStatistic : public mcts::NodeStatistic<UctStatistic>, mcts::RandomGenerator
+class UctStatistic : public mcts::NodeStatistic<UctStatistic>, public mcts::RandomGenerator
 {
 public:
     MCTS_TEST
 
     UctStatistic(ActionIdx num_actions, AgentIdx agent_idx, const MctsParameters & mcts_parameters) :
              NodeStatistic<UctStatistic>(num_actions, agent_idx, mcts_parameters),
-             RandomGenerator(mcts_parameters.RANDOM_SEED),
+             RandomGenerator(mcts_parameters.RANDOM_SEED, random_stream(mcts_parameters.THREAD_IDX, 0)),
              value_(0.0f),
              latest_return_(0.0),
              ucb_statistics_([&]() -> std::map<ActionIdx, UcbPair>{
@@ -31,10 +32,16 @@ public:
              }()),
              total_node_visits_(0),
              unexpanded_actions_(num_actions),
+             expanded_actions_(),
+             unexpanded_actions_ordered_(false),
              upper_bound(mcts_parameters.uct_statistic.UPPER_BOUND),
              lower_bound(mcts_parameters.uct_statistic.LOWER_BOUND),
              k_discount_factor(mcts_parameters.DISCOUNT_FACTOR), 
-             k_exploration_constant(mcts_parameters.uct_statistic.EXPLORATION_CONSTANT) {
+             k_exploration_constant(mcts_parameters.uct_statistic.EXPLORATION_CONSTANT),
+             progressive_widening_(mcts_parameters.uct_statistic.PROGRESSIVE_WIDENING),
+             prior_ordered_widening_(mcts_parameters.uct_statistic.PRIOR_ORDERED_WIDENING),
+             progressive_widening_k(mcts_parameters.uct_statistic.PROGRESSIVE_WIDENING_K),
+             progressive_widening_alpha(mcts_parameters.uct_statistic.PROGRESSIVE_WIDENING_ALPHA) {
                  // initialize action indexes from 0 to (number of actions -1)
                  std::iota(unexpanded_actions_.begin(), unexpanded_actions_.end(), 0);
              }
@@ -43,6 +50,10 @@ public:
 
     template <class S>
     ActionIdx choose_next_action(const S& state) {
+        MCTS_PERF_REGION(PERF_UCT_CHOOSE_NEXT_ACTION);
+        if(progressive_widening_) {
+            return choose_next_action_progressive_widening(state);
+        }
         if(unexpanded_actions_.empty())
         {
             // Select an action based on the UCB formula
@@ -64,6 +75,16 @@ public:
     }
 
     ActionIdx get_best_action() {
+        if(progressive_widening_ && !expanded_actions_.empty()) {
+            // Actions never introduced have no value estimate
+            ActionIdx best = expanded_actions_.front();
+            for (const auto& action : expanded_actions_) {
+                if(ucb_statistics_.at(action).action_value_ > ucb_statistics_.at(best).action_value_) {
+                    best = action;
+                }
+            }
+            return best;
+        }
         double temp = ucb_statistics_.begin()->second.action_value_;
         ActionIdx best = 0;
         for (auto it = ucb_statistics_.begin(); it != ucb_statistics_.end(); ++it)
@@ -76,6 +97,18 @@ public:
         return best;
     }
 
+    double get_action_value(const ActionIdx& action) const {
+        return ucb_statistics_.at(action).action_value_;
+    }
+
+    unsigned int get_action_count(const ActionIdx& action) const {
+        return ucb_statistics_.at(action).action_count_;
+    }
+
+    std::size_t get_memory_footprint() const {
+        return heap_bytes(ucb_statistics_) + heap_bytes(unexpanded_actions_) + heap_bytes(expanded_actions_);
+    }
+
     void update_from_heuristic(const NodeStatistic<UctStatistic>& heuristic_statistic)
     {
         const UctStatistic& heuristic_statistic_impl = heuristic_statistic.impl();
@@ -134,19 +167,82 @@ public:
 
         for (size_t idx = 0; idx < ucb_statistics.size(); ++idx)
         {
-            double action_value_normalized = (ucb_statistics.at(idx).action_value_-lower_bound)/(upper_bound-lower_bound); 
-            MCTS_EXPECT_TRUE(action_value_normalized>=0);
-            MCTS_EXPECT_TRUE(action_value_normalized<=1);
-            values[idx] = action_value_normalized + 2 * k_exploration_constant * sqrt( (2* log(total_node_visits_)) / ( ucb_statistics.at(idx).action_count_)  );
+            values[idx] = calculate_ucb_value(ucb_statistics.at(idx));
         }
     }
+
+    double calculate_ucb_value(const UcbPair& ucb_pair) const
+    {
+        double action_value_normalized = (ucb_pair.action_value_-lower_bound)/(upper_bound-lower_bound); 
+        MCTS_EXPECT_TRUE(action_value_normalized>=0);
+        MCTS_EXPECT_TRUE(action_value_normalized<=1);
+        return action_value_normalized + 2 * k_exploration_constant * sqrt( (2* log(total_node_visits_)) / ( ucb_pair.action_count_)  );
+    }
+
+    const std::map<ActionIdx, UcbPair>& get_ucb_statistics() const {
+        return ucb_statistics_;
+    }
+
 private:
+    template <class S>
+    ActionIdx choose_next_action_progressive_widening(const S& state) {
+        if(prior_ordered_widening_ && !unexpanded_actions_ordered_) {
+            order_unexpanded_actions(state.impl().get_action_priors(agent_idx_));
+        }
+
+        const double widening_term = progressive_widening_k * std::pow(total_node_visits_, progressive_widening_alpha);
+        if(!unexpanded_actions_.empty() &&
+            (expanded_actions_.empty() || expanded_actions_.size() <= widening_term)) {
+            // Introduce a new action, the one with highest prior or a random one
+            ActionIdx selected_action;
+            if(unexpanded_actions_ordered_) {
+                selected_action = unexpanded_actions_.back();
+                unexpanded_actions_.pop_back();
+            } else {
+                std::uniform_int_distribution<ActionIdx> random_action_selection(0,unexpanded_actions_.size()-1);
+                ActionIdx array_idx = random_action_selection(random_generator_);
+                selected_action = unexpanded_actions_[array_idx];
+                unexpanded_actions_.erase(unexpanded_actions_.begin()+array_idx);
+            }
+            expanded_actions_.push_back(selected_action);
+            return selected_action;
+        }
+
+        // Select among the introduced actions based on the UCB formula
+        ActionIdx selected_action = expanded_actions_.front();
+        double largest_value = -std::numeric_limits<double>::infinity();
+        for (const auto& action : expanded_actions_) {
+            const double value = calculate_ucb_value(ucb_statistics_.at(action));
+            if(value > largest_value) {
+                largest_value = value;
+                selected_action = action;
+            }
+        }
+        return selected_action;
+    }
+
+    void order_unexpanded_actions(const std::vector<double>& priors) {
+        unexpanded_actions_ordered_ = true;
+        if(priors.size() != num_actions_) {
+            // No prior available, keep random introduction
+            unexpanded_actions_ordered_ = false;
+            prior_ordered_widening_ = false;
+            return;
+        }
+        // Ascending priors such that the most likely action is introduced first, random order among equal priors
+        std::shuffle(unexpanded_actions_.begin(), unexpanded_actions_.end(), random_generator_);
+        std::stable_sort(unexpanded_actions_.begin(), unexpanded_actions_.end(),
+                         [&priors](const int& lhs, const int& rhs) { return priors[lhs] < priors[rhs]; });
+    }
+
 
     double value_;
     double latest_return_;   // tracks the return during backpropagation
     std::map<ActionIdx, UcbPair> ucb_statistics_; // first: action selection count, action-value
     unsigned int total_node_visits_;
     std::vector<int> unexpanded_actions_; // contains all action indexes which have not been expanded yet
+    std::vector<ActionIdx> expanded_actions_; // actions introduced by progressive widening
+    bool unexpanded_actions_ordered_; // unexpanded actions are sorted by ascending prior
 
     // PARAMS
     const double upper_bound;
@@ -154,6 +250,11 @@ private:
     const double k_discount_factor;
     const double k_exploration_constant;
 
+    const bool progressive_widening_;
+    bool prior_ordered_widening_;
+    const double progressive_widening_k;
+    const double progressive_widening_alpha;
+
 };
 
 } // namespace mcts
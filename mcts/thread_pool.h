@@ -0,0 +1,89 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef MCTS_THREAD_POOL_H
+#define MCTS_THREAD_POOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace mcts {
+
+// Fixed number of worker threads executing submitted tasks in submission order.
+// Exceptions of a task are passed on through its future.
+class ThreadPool {
+public:
+    // num_threads = 0 uses the hardware concurrency
+    explicit ThreadPool(const unsigned int& num_threads = 0) : tasks_(), mutex_(), condition_(), stop_(false), workers_() {
+        const unsigned int num_workers = num_threads > 0 ? num_threads : std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int worker = 0; worker < num_workers; ++worker) {
+            workers_.emplace_back([this]() { run(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        condition_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template<class F>
+    std::future<typename std::result_of<F()>::type> submit(F task) {
+        using Result = typename std::result_of<F()>::type;
+        auto packaged_task = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+        auto future = packaged_task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push([packaged_task]() { (*packaged_task)(); });
+        }
+        condition_.notify_one();
+        return future;
+    }
+
+    unsigned int num_threads() const { return workers_.size(); }
+
+private:
+    void run() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                condition_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+                if (stop_ && tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+            task();
+        }
+    }
+
+    std::queue<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool stop_;
+    std::vector<std::thread> workers_;
+};
+
+} // namespace mcts
+
+#endif // MCTS_THREAD_POOL_H
@@ -0,0 +1,86 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef MCTS_TREE_STATISTICS_H
+#define MCTS_TREE_STATISTICS_H
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace mcts {
+
+/*
+ * Shape and estimated memory footprint of a search tree. Depths are counted from the root (depth 0).
+ * Bytes are estimates: nodes are the stage nodes without their statistics, states their shallow size
+ * (heap memory held by states is not included), statistics the intermediate nodes with the heap memory
+ * of their statistics and edges the maps from joint actions to children, rewards and costs.
+ */
+struct TreeStatistics {
+    TreeStatistics() : num_nodes(0), num_leaf_nodes(0), num_interior_nodes(0), nodes_per_depth(),
+                       interior_nodes_per_depth(), children_per_depth(), node_bytes(0), state_bytes(0),
+                       statistic_bytes(0), edge_bytes(0) {}
+
+    unsigned int num_nodes;
+    unsigned int num_leaf_nodes;
+    unsigned int num_interior_nodes;
+    std::vector<unsigned int> nodes_per_depth; // depth histogram
+    std::vector<unsigned int> interior_nodes_per_depth;
+    std::vector<unsigned int> children_per_depth;
+
+    std::size_t node_bytes;
+    std::size_t state_bytes; // including the heap memory of states implementing get_memory_footprint()
+    std::size_t statistic_bytes;
+    std::size_t edge_bytes;
+
+    // Depth of the deepest node
+    unsigned int max_depth() const { return nodes_per_depth.empty() ? 0 : nodes_per_depth.size() - 1; }
+
+    // Mean number of children of the interior nodes at a depth
+    double branching_factor(const unsigned int& depth) const {
+        if (depth >= interior_nodes_per_depth.size() || interior_nodes_per_depth[depth] == 0) {
+            return 0.0;
+        }
+        return static_cast<double>(children_per_depth[depth]) / interior_nodes_per_depth[depth];
+    }
+
+    std::size_t total_bytes() const { return node_bytes + state_bytes + statistic_bytes + edge_bytes; }
+
+    void add_node(const unsigned int& depth, const std::size_t& num_children) {
+        if (depth >= nodes_per_depth.size()) {
+            nodes_per_depth.resize(depth + 1, 0);
+            interior_nodes_per_depth.resize(depth + 1, 0);
+            children_per_depth.resize(depth + 1, 0);
+        }
+        num_nodes += 1;
+        nodes_per_depth[depth] += 1;
+        if (num_children == 0) {
+            num_leaf_nodes += 1;
+        } else {
+            num_interior_nodes += 1;
+            interior_nodes_per_depth[depth] += 1;
+            children_per_depth[depth] += num_children;
+        }
+    }
+
+    std::string sprintf() const {
+        std::stringstream ss;
+        ss << "nodes: " << num_nodes << " (leaf: " << num_leaf_nodes << ", interior: " << num_interior_nodes
+           << "), max depth: " << max_depth() << std::endl;
+        for (unsigned int depth = 0; depth < nodes_per_depth.size(); ++depth) {
+            ss << "depth " << depth << ": nodes=" << nodes_per_depth[depth]
+               << ", branching factor=" << branching_factor(depth) << std::endl;
+        }
+        ss << "bytes: " << total_bytes() << " (nodes: " << node_bytes << ", states: " << state_bytes
+           << ", statistics: " << statistic_bytes << ", edges: " << edge_bytes << ")";
+        return ss.str();
+    }
+};
+
+} // namespace mcts
+
+#endif // MCTS_TREE_STATISTICS_H
@@ -10,6 +10,7 @@
 #include "python/bindings/common.hpp"
 #include "environments/crossing_state.h"
 #include "environments/crossing_state_episode_runner.h"
+#include "mcts/shared_memory_search.h"
 
 namespace py = pybind11;
 using namespace mcts;
@@ -24,6 +25,7 @@ void define_crossing_state(py::module m, std::string suffix) {
       .def_readwrite("NUM_OTHER_AGENTS", &CrossingStateParameters<Domain>::NUM_OTHER_AGENTS)
       .def_readwrite("OTHER_AGENTS_POLICY_RANDOM_SEED", &CrossingStateParameters<Domain>::OTHER_AGENTS_POLICY_RANDOM_SEED)
       .def_readwrite("COST_ONLY_COLLISION", &CrossingStateParameters<Domain>::COST_ONLY_COLLISION)
+      .def_readwrite("TABULATE_OTHER_AGENTS_POLICY", &CrossingStateParameters<Domain>::TABULATE_OTHER_AGENTS_POLICY)
       .def_readwrite("MAX_VELOCITY_EGO", &CrossingStateParameters<Domain>::MAX_VELOCITY_EGO)
       .def_readwrite("MIN_VELOCITY_EGO",&CrossingStateParameters<Domain>::MIN_VELOCITY_EGO)
       .def_readwrite("MIN_VELOCITY_OTHER",&CrossingStateParameters<Domain>::MIN_VELOCITY_OTHER)
@@ -33,6 +35,8 @@ void define_crossing_state(py::module m, std::string suffix) {
       .def_property_readonly("CROSSING_POINT",&CrossingStateParameters<Domain>::CROSSING_POINT)
       .def_property_readonly("NUM_EGO_ACTIONS",&CrossingStateParameters<Domain>::NUM_EGO_ACTIONS)
       .def_readwrite("NUM_OTHER_ACTIONS",&CrossingStateParameters<Domain>::NUM_OTHER_ACTIONS)
+      .def_readwrite("INTERN_OTHER_ACTIONS",&CrossingStateParameters<Domain>::INTERN_OTHER_ACTIONS)
+      .def_readwrite("OTHER_ACTIONS_RESOLUTION",&CrossingStateParameters<Domain>::OTHER_ACTIONS_RESOLUTION)
       .def_readwrite("REWARD_COLLISION",&CrossingStateParameters<Domain>::REWARD_COLLISION)
       .def_readwrite("REWARD_GOAL_REACHED",&CrossingStateParameters<Domain>::REWARD_GOAL_REACHED)
       .def_readwrite("REWARD_STEP",&CrossingStateParameters<Domain>::REWARD_STEP)
@@ -46,6 +50,7 @@ void define_crossing_state(py::module m, std::string suffix) {
             d["NUM_OTHER_AGENTS"] = p.NUM_OTHER_AGENTS;
             d["OTHER_AGENTS_POLICY_RANDOM_SEED"] = p.OTHER_AGENTS_POLICY_RANDOM_SEED;
             d["COST_ONLY_COLLISION"] = p.COST_ONLY_COLLISION;
+            d["TABULATE_OTHER_AGENTS_POLICY"] = p.TABULATE_OTHER_AGENTS_POLICY;
             d["MAX_VELOCITY_EGO"] = p.MAX_VELOCITY_EGO;
             d["MIN_VELOCITY_EGO"] = p.MIN_VELOCITY_EGO;
             d["MIN_VELOCITY_OTHER"] = p.MIN_VELOCITY_OTHER;
@@ -53,13 +58,15 @@ void define_crossing_state(py::module m, std::string suffix) {
             d["EGO_GOAL_POS"] = p.EGO_GOAL_POS;
             d["CHAIN_LENGTH"] = p.CHAIN_LENGTH;
             d["NUM_OTHER_ACTIONS"] = p.NUM_OTHER_ACTIONS;
+            d["INTERN_OTHER_ACTIONS"] = p.INTERN_OTHER_ACTIONS;
+            d["OTHER_ACTIONS_RESOLUTION"] = p.OTHER_ACTIONS_RESOLUTION;
             d["REWARD_COLLISION"] = p.REWARD_COLLISION;
             d["REWARD_GOAL_REACHED"] = p.REWARD_GOAL_REACHED;
             d["REWARD_STEP"] = p.REWARD_STEP;
             return d;
         },
         [](py::dict d) { // __setstate__
-            if (d.size() != 13)
+            if (d.size() != 16)
                 throw std::runtime_error("Invalid CrossingStateParameters state!");
 
             /* Create a new C++ instance */
@@ -67,6 +74,7 @@ void define_crossing_state(py::module m, std::string suffix) {
             p.NUM_OTHER_AGENTS = d["NUM_OTHER_AGENTS"].cast<unsigned int>();
             p.OTHER_AGENTS_POLICY_RANDOM_SEED = d["OTHER_AGENTS_POLICY_RANDOM_SEED"].cast<unsigned int>();
             p.COST_ONLY_COLLISION = d["COST_ONLY_COLLISION"].cast<bool>();
+            p.TABULATE_OTHER_AGENTS_POLICY = d["TABULATE_OTHER_AGENTS_POLICY"].cast<bool>();
             p.MAX_VELOCITY_EGO = d["MAX_VELOCITY_EGO"].cast<Domain>();
             p.MIN_VELOCITY_EGO = d["MIN_VELOCITY_EGO"].cast<Domain>();
             p.MIN_VELOCITY_OTHER = d["MIN_VELOCITY_OTHER"].cast<Domain>();
@@ -74,6 +82,8 @@ void define_crossing_state(py::module m, std::string suffix) {
             p.EGO_GOAL_POS = d["EGO_GOAL_POS"].cast<Domain>();
             p.CHAIN_LENGTH = d["CHAIN_LENGTH"].cast<Domain>();
             p.NUM_OTHER_ACTIONS = d["NUM_OTHER_ACTIONS"].cast<unsigned int>();
+            p.INTERN_OTHER_ACTIONS = d["INTERN_OTHER_ACTIONS"].cast<bool>();
+            p.OTHER_ACTIONS_RESOLUTION = d["OTHER_ACTIONS_RESOLUTION"].cast<Domain>();
             p.REWARD_COLLISION = d["REWARD_COLLISION"].cast<Reward>();
             p.REWARD_GOAL_REACHED = d["REWARD_GOAL_REACHED"].cast<Reward>();
             p.REWARD_STEP = d["REWARD_STEP"].cast<Reward>();
@@ -127,10 +137,21 @@ void define_crossing_state(py::module m, std::string suffix) {
         return typeid(m).name();
       })
       .def("step", &CrossingStateEpisodeRunner<Domain>::step)
-      .def("run", &CrossingStateEpisodeRunner<Domain>::run);
+      .def("run", &CrossingStateEpisodeRunner<Domain>::run)
+      .def_property_readonly("profile", &CrossingStateEpisodeRunner<Domain>::get_profile)
+      .def_property_readonly("tree_statistics", &CrossingStateEpisodeRunner<Domain>::get_tree_statistics)
+      .def("set_tracer", &CrossingStateEpisodeRunner<Domain>::set_tracer, py::keep_alive<1, 2>())
+      .def("set_recorder", &CrossingStateEpisodeRunner<Domain>::set_recorder, py::keep_alive<1, 2>());
 
     std::string name6 = "CrossingStateDefaultParameters" + suffix;
     m.def(name6.c_str(), &default_crossing_state_parameters<Domain>);
+
+    // Searches without holding the GIL from the beliefs of the coordinator's tracker and publishes
+    // the root statistics into a SharedRootStatistics segment
+    std::string name7 = "SharedMemorySearchWorker" + suffix;
+    m.def(name7.c_str(), &SharedMemorySearch<CrossingState<Domain>, UctStatistic, HypothesisStatistic,
+                                             RandomHeuristic>::template search_worker<CrossingState<Domain>>,
+          py::call_guard<py::gil_scoped_release>());
 }
 
 #endif // PYTHON_DEFINE_CROSSING_STATE_HPP_
\ No newline at end of file
@@ -12,6 +12,7 @@
 #include "mcts/statistics/uct_statistic.h"
 #include "mcts/hypothesis/hypothesis_statistic.h"
 #include "mcts/heuristics/random_heuristic.h"
+#include "mcts/shared_memory_search.h"
 
 namespace py = pybind11;
 using namespace mcts;
@@ -24,48 +25,68 @@ void define_mamcts(py::module m)
         return "mamcts.MctsParameters";
       })
       .def_readwrite("RANDOM_SEED", &MctsParameters::RANDOM_SEED)
+      .def_readwrite("THREAD_IDX", &MctsParameters::THREAD_IDX)
       .def_readwrite("DISCOUNT_FACTOR", &MctsParameters::DISCOUNT_FACTOR)
       .def_readwrite("MAX_SEARCH_TIME", &MctsParameters::MAX_SEARCH_TIME)
       .def_readwrite("MAX_SEARCH_DEPTH", &MctsParameters::MAX_SEARCH_DEPTH)
       .def_readwrite("MAX_NUMBER_OF_ITERATIONS", &MctsParameters::MAX_NUMBER_OF_ITERATIONS)
       .def_readwrite("hypothesis_statistic", &MctsParameters::hypothesis_statistic)
       .def_readwrite("uct_statistic", &MctsParameters::uct_statistic)
+      .def_readwrite("rave_statistic", &MctsParameters::rave_statistic)
       .def_readwrite("random_heuristic", &MctsParameters::random_heuristic)
+      .def_readwrite("batch_rollout_heuristic", &MctsParameters::batch_rollout_heuristic)
+      .def_readwrite("stage_node", &MctsParameters::stage_node)
+      .def_readwrite("root_action_selection", &MctsParameters::root_action_selection)
       .def_readwrite("hypothesis_belief_tracker", &MctsParameters::hypothesis_belief_tracker)
+      .def_readwrite("hypothesis_ensemble", &MctsParameters::hypothesis_ensemble)
       .def(py::pickle(
         [](const MctsParameters &p) { // __getstate__
             /* Return a tuple that fully encodes the state of the object */
             py::dict d;
             d["RANDOM_SEED"] = p.RANDOM_SEED;
+            d["THREAD_IDX"] = p.THREAD_IDX;
             d["DISCOUNT_FACTOR"] = p.DISCOUNT_FACTOR;
             d["MAX_SEARCH_TIME"] = p.MAX_SEARCH_TIME;
             d["MAX_SEARCH_DEPTH"] = p.MAX_SEARCH_DEPTH;
             d["MAX_NUMBER_OF_ITERATIONS"] = p.MAX_NUMBER_OF_ITERATIONS;
             d["hypothesis_statistic"] = p.hypothesis_statistic;
             d["uct_statistic"] = p.uct_statistic;
+            d["rave_statistic"] = p.rave_statistic;
             d["random_heuristic"] = p.random_heuristic;
+            d["batch_rollout_heuristic"] = p.batch_rollout_heuristic;
+            d["stage_node"] = p.stage_node;
+            d["root_action_selection"] = p.root_action_selection;
             d["hypothesis_belief_tracker"] = p.hypothesis_belief_tracker;
+            d["hypothesis_ensemble"] = p.hypothesis_ensemble;
             return d;
         },
         [](py::dict d) { // __setstate__
-            if (d.size() != 9)
+            if (d.size() != 15)
                 throw std::runtime_error("Invalid MctsParameters state!");
 
             /* Create a new C++ instance */
             MctsParameters p;
             p.RANDOM_SEED = d["RANDOM_SEED"].cast<unsigned int>();
+            p.THREAD_IDX = d["THREAD_IDX"].cast<unsigned int>();
             p.DISCOUNT_FACTOR = d["DISCOUNT_FACTOR"].cast<double>();
             p.MAX_SEARCH_TIME = d["MAX_SEARCH_TIME"].cast<unsigned int>();
             p.MAX_SEARCH_DEPTH = d["MAX_SEARCH_DEPTH"].cast<unsigned int>();
             p.MAX_NUMBER_OF_ITERATIONS = d["MAX_NUMBER_OF_ITERATIONS"].cast<double>();
             p.hypothesis_statistic = d["hypothesis_statistic"].cast<MctsParameters::HypothesisStatisticParameters>();
             p.uct_statistic = d["uct_statistic"].cast<MctsParameters::UctStatisticParameters>();
+            p.rave_statistic = d["rave_statistic"].cast<MctsParameters::RaveStatisticParameters>();
             p.random_heuristic = d["random_heuristic"].cast<MctsParameters::RandomHeuristicParameters>();
+            p.batch_rollout_heuristic = d["batch_rollout_heuristic"].cast<MctsParameters::BatchRolloutHeuristicParameters>();
+            p.stage_node = d["stage_node"].cast<MctsParameters::StageNodeParameters>();
+            p.root_action_selection = d["root_action_selection"].cast<MctsParameters::RootActionSelectionParameters>();
             p.hypothesis_belief_tracker = d["hypothesis_belief_tracker"].cast<MctsParameters::HypothesisBeliefTrackerParameters>();
+            p.hypothesis_ensemble = d["hypothesis_ensemble"].cast<MctsParameters::HypothesisEnsembleParameters>();
             return p;
         }
     ));
 
+    m.def("MctsDefaultParameters", &mcts_default_parameters);
+
     py::class_<MctsParameters::RandomHeuristicParameters>(m, "MctsParametersRandomHeuristicParameters")
       .def(py::init<>())
       .def("__repr__", [](const MctsParameters::RandomHeuristicParameters &m) {
@@ -94,6 +115,95 @@ void define_mamcts(py::module m)
         }
     ));
 
+    py::class_<MctsParameters::BatchRolloutHeuristicParameters>(m, "MctsParametersBatchRolloutHeuristicParameters")
+      .def(py::init<>())
+      .def("__repr__", [](const MctsParameters::BatchRolloutHeuristicParameters &m) {
+        return "mamcts.MctsParametersBatchRolloutHeuristicParameters";
+      })
+      .def_readwrite("BATCH_SIZE", &MctsParameters::BatchRolloutHeuristicParameters::BATCH_SIZE)
+      .def(py::pickle(
+        [](const MctsParameters::BatchRolloutHeuristicParameters &p) { // __getstate__
+            /* Return a tuple that fully encodes the state of the object */
+            py::dict d;
+            d["BATCH_SIZE"] = p.BATCH_SIZE;
+            return d;
+        },
+        [](py::dict d) { // __setstate__
+            if (d.size() != 1)
+                throw std::runtime_error("Invalid BatchRolloutHeuristicParameters state!");
+
+            /* Create a new C++ instance */
+            MctsParameters::BatchRolloutHeuristicParameters p;
+            p.BATCH_SIZE = d["BATCH_SIZE"].cast<unsigned int>();
+            return p;
+        }
+    ));
+
+    py::class_<MctsParameters::StageNodeParameters>(m, "MctsParametersStageNodeParameters")
+      .def(py::init<>())
+      .def("__repr__", [](const MctsParameters::StageNodeParameters &m) {
+        return "mamcts.MctsParametersStageNodeParameters";
+      })
+      .def_readwrite("PROGRESSIVE_WIDENING", &MctsParameters::StageNodeParameters::PROGRESSIVE_WIDENING)
+      .def_readwrite("PROGRESSIVE_WIDENING_K", &MctsParameters::StageNodeParameters::PROGRESSIVE_WIDENING_K)
+      .def_readwrite("PROGRESSIVE_WIDENING_ALPHA", &MctsParameters::StageNodeParameters::PROGRESSIVE_WIDENING_ALPHA)
+      .def(py::pickle(
+        [](const MctsParameters::StageNodeParameters &p) { // __getstate__
+            /* Return a tuple that fully encodes the state of the object */
+            py::dict d;
+            d["PROGRESSIVE_WIDENING"] = p.PROGRESSIVE_WIDENING;
+            d["PROGRESSIVE_WIDENING_K"] = p.PROGRESSIVE_WIDENING_K;
+            d["PROGRESSIVE_WIDENING_ALPHA"] = p.PROGRESSIVE_WIDENING_ALPHA;
+            return d;
+        },
+        [](py::dict d) { // __setstate__
+            if (d.size() != 3)
+                throw std::runtime_error("Invalid StageNodeParameters state!");
+
+            /* Create a new C++ instance */
+            MctsParameters::StageNodeParameters p;
+            p.PROGRESSIVE_WIDENING = d["PROGRESSIVE_WIDENING"].cast<bool>();
+            p.PROGRESSIVE_WIDENING_K = d["PROGRESSIVE_WIDENING_K"].cast<double>();
+            p.PROGRESSIVE_WIDENING_ALPHA = d["PROGRESSIVE_WIDENING_ALPHA"].cast<double>();
+            return p;
+        }
+    ));
+
+    py::class_<MctsParameters::RootActionSelectionParameters>(m, "MctsParametersRootActionSelectionParameters")
+      .def(py::init<>())
+      .def("__repr__", [](const MctsParameters::RootActionSelectionParameters &m) {
+        return "mamcts.MctsParametersRootActionSelectionParameters";
+      })
+      .def_readwrite("SEQUENTIAL_HALVING", &MctsParameters::RootActionSelectionParameters::SEQUENTIAL_HALVING)
+      .def_readwrite("NUM_CANDIDATE_ACTIONS", &MctsParameters::RootActionSelectionParameters::NUM_CANDIDATE_ACTIONS)
+      .def_readwrite("GUMBEL_SAMPLING", &MctsParameters::RootActionSelectionParameters::GUMBEL_SAMPLING)
+      .def_readwrite("GUMBEL_C_VISIT", &MctsParameters::RootActionSelectionParameters::GUMBEL_C_VISIT)
+      .def_readwrite("GUMBEL_C_SCALE", &MctsParameters::RootActionSelectionParameters::GUMBEL_C_SCALE)
+      .def(py::pickle(
+        [](const MctsParameters::RootActionSelectionParameters &p) { // __getstate__
+            /* Return a tuple that fully encodes the state of the object */
+            py::dict d;
+            d["SEQUENTIAL_HALVING"] = p.SEQUENTIAL_HALVING;
+            d["NUM_CANDIDATE_ACTIONS"] = p.NUM_CANDIDATE_ACTIONS;
+            d["GUMBEL_SAMPLING"] = p.GUMBEL_SAMPLING;
+            d["GUMBEL_C_VISIT"] = p.GUMBEL_C_VISIT;
+            d["GUMBEL_C_SCALE"] = p.GUMBEL_C_SCALE;
+            return d;
+        },
+        [](py::dict d) { // __setstate__
+            if (d.size() != 5)
+                throw std::runtime_error("Invalid RootActionSelectionParameters state!");
+
+            /* Create a new C++ instance */
+            MctsParameters::RootActionSelectionParameters p;
+            p.SEQUENTIAL_HALVING = d["SEQUENTIAL_HALVING"].cast<bool>();
+            p.NUM_CANDIDATE_ACTIONS = d["NUM_CANDIDATE_ACTIONS"].cast<unsigned int>();
+            p.GUMBEL_SAMPLING = d["GUMBEL_SAMPLING"].cast<bool>();
+            p.GUMBEL_C_VISIT = d["GUMBEL_C_VISIT"].cast<double>();
+            p.GUMBEL_C_SCALE = d["GUMBEL_C_SCALE"].cast<double>();
+            return p;
+        }
+    ));
 
     py::class_<MctsParameters::UctStatisticParameters>(m ,"MctsParametersUctStatisticParametersParameters")
       .def(py::init<>())
@@ -103,6 +213,10 @@ void define_mamcts(py::module m)
       .def_readwrite("LOWER_BOUND", &MctsParameters::UctStatisticParameters::LOWER_BOUND)
       .def_readwrite("UPPER_BOUND", &MctsParameters::UctStatisticParameters::UPPER_BOUND)
       .def_readwrite("EXPLORATION_CONSTANT", &MctsParameters::UctStatisticParameters::EXPLORATION_CONSTANT)
+      .def_readwrite("PROGRESSIVE_WIDENING", &MctsParameters::UctStatisticParameters::PROGRESSIVE_WIDENING)
+      .def_readwrite("PRIOR_ORDERED_WIDENING", &MctsParameters::UctStatisticParameters::PRIOR_ORDERED_WIDENING)
+      .def_readwrite("PROGRESSIVE_WIDENING_K", &MctsParameters::UctStatisticParameters::PROGRESSIVE_WIDENING_K)
+      .def_readwrite("PROGRESSIVE_WIDENING_ALPHA", &MctsParameters::UctStatisticParameters::PROGRESSIVE_WIDENING_ALPHA)
       .def(py::pickle(
         [](const MctsParameters::UctStatisticParameters &p) { // __getstate__
             /* Return a tuple that fully encodes the state of the object */
@@ -110,10 +224,14 @@ void define_mamcts(py::module m)
             d["LOWER_BOUND"] = p.LOWER_BOUND;
             d["UPPER_BOUND"] = p.UPPER_BOUND;
             d["EXPLORATION_CONSTANT"] = p.EXPLORATION_CONSTANT;
+            d["PROGRESSIVE_WIDENING"] = p.PROGRESSIVE_WIDENING;
+            d["PRIOR_ORDERED_WIDENING"] = p.PRIOR_ORDERED_WIDENING;
+            d["PROGRESSIVE_WIDENING_K"] = p.PROGRESSIVE_WIDENING_K;
+            d["PROGRESSIVE_WIDENING_ALPHA"] = p.PROGRESSIVE_WIDENING_ALPHA;
             return d;
         },
         [](py::dict d) { // __setstate__
-            if (d.size() != 3)
+            if (d.size() != 7)
                 throw std::runtime_error("Invalid UctStatisticParameters state!");
 
             /* Create a new C++ instance */
@@ -121,6 +239,40 @@ void define_mamcts(py::module m)
             p.LOWER_BOUND = d["LOWER_BOUND"].cast<double>();
             p.UPPER_BOUND = d["UPPER_BOUND"].cast<double>();
             p.EXPLORATION_CONSTANT = d["EXPLORATION_CONSTANT"].cast<double>();
+            p.PROGRESSIVE_WIDENING = d["PROGRESSIVE_WIDENING"].cast<bool>();
+            p.PRIOR_ORDERED_WIDENING = d["PRIOR_ORDERED_WIDENING"].cast<bool>();
+            p.PROGRESSIVE_WIDENING_K = d["PROGRESSIVE_WIDENING_K"].cast<double>();
+            p.PROGRESSIVE_WIDENING_ALPHA = d["PROGRESSIVE_WIDENING_ALPHA"].cast<double>();
+            return p;
+        }
+    ));
+
+    py::class_<MctsParameters::RaveStatisticParameters>(m ,"MctsParametersRaveStatisticParameters")
+      .def(py::init<>())
+      .def("__repr__", [](const MctsParameters::RaveStatisticParameters &m) {
+        return "mamcts.MctsParametersRaveStatisticParameters";
+      })
+      .def_readwrite("BLEND_SCHEDULE", &MctsParameters::RaveStatisticParameters::BLEND_SCHEDULE)
+      .def_readwrite("EQUIVALENCE_PARAMETER", &MctsParameters::RaveStatisticParameters::EQUIVALENCE_PARAMETER)
+      .def_readwrite("AMAF_BIAS", &MctsParameters::RaveStatisticParameters::AMAF_BIAS)
+      .def(py::pickle(
+        [](const MctsParameters::RaveStatisticParameters &p) { // __getstate__
+            /* Return a tuple that fully encodes the state of the object */
+            py::dict d;
+            d["BLEND_SCHEDULE"] = p.BLEND_SCHEDULE;
+            d["EQUIVALENCE_PARAMETER"] = p.EQUIVALENCE_PARAMETER;
+            d["AMAF_BIAS"] = p.AMAF_BIAS;
+            return d;
+        },
+        [](py::dict d) { // __setstate__
+            if (d.size() != 3)
+                throw std::runtime_error("Invalid RaveStatisticParameters state!");
+
+            /* Create a new C++ instance */
+            MctsParameters::RaveStatisticParameters p;
+            p.BLEND_SCHEDULE = d["BLEND_SCHEDULE"].cast<int>();
+            p.EQUIVALENCE_PARAMETER = d["EQUIVALENCE_PARAMETER"].cast<double>();
+            p.AMAF_BIAS = d["AMAF_BIAS"].cast<double>();
             return p;
         }
     ));
@@ -144,6 +296,8 @@ void define_mamcts(py::module m)
                 &MctsParameters::HypothesisStatisticParameters::PROGRESSIVE_WIDENING_ALPHA)
       .def_readwrite("EXPLORATION_CONSTANT",
                 &MctsParameters::HypothesisStatisticParameters::EXPLORATION_CONSTANT)
+      .def_readwrite("ACTION_CANDIDATE_BATCH_SIZE",
+                &MctsParameters::HypothesisStatisticParameters::ACTION_CANDIDATE_BATCH_SIZE)
       .def(py::pickle(
         [](const MctsParameters::HypothesisStatisticParameters &p) { // __getstate__
             /* Return a tuple that fully encodes the state of the object */
@@ -155,10 +309,11 @@ void define_mamcts(py::module m)
             d["PROGRESSIVE_WIDENING_K"] = p.PROGRESSIVE_WIDENING_K;
             d["PROGRESSIVE_WIDENING_ALPHA"] = p.PROGRESSIVE_WIDENING_ALPHA;
             d["EXPLORATION_CONSTANT"] = p.EXPLORATION_CONSTANT;
+            d["ACTION_CANDIDATE_BATCH_SIZE"] = p.ACTION_CANDIDATE_BATCH_SIZE;
             return d;
         },
         [](py::dict d) { // __setstate__
-            if (d.size() != 7)
+            if (d.size() != 8)
                 throw std::runtime_error("Invalid HypothesisStatisticParameters state!");
 
             /* Create a new C++ instance */
@@ -170,6 +325,31 @@ void define_mamcts(py::module m)
             p.PROGRESSIVE_WIDENING_K = d["PROGRESSIVE_WIDENING_K"].cast<double>();
             p.PROGRESSIVE_WIDENING_ALPHA = d["PROGRESSIVE_WIDENING_ALPHA"].cast<double>();
             p.EXPLORATION_CONSTANT = d["EXPLORATION_CONSTANT"].cast<double>();
+            p.ACTION_CANDIDATE_BATCH_SIZE = d["ACTION_CANDIDATE_BATCH_SIZE"].cast<unsigned int>();
+            return p;
+        }
+    ));
+
+    py::class_<MctsParameters::HypothesisEnsembleParameters>(m, "MctsParametersHypothesisEnsembleParameters")
+      .def(py::init<>())
+      .def("__repr__", [](const MctsParameters::HypothesisEnsembleParameters &m) {
+        return "mamcts.MctsParametersHypothesisEnsembleParameters";
+      })
+      .def_readwrite("NUM_THREADS", &MctsParameters::HypothesisEnsembleParameters::NUM_THREADS)
+      .def(py::pickle(
+        [](const MctsParameters::HypothesisEnsembleParameters &p) { // __getstate__
+            /* Return a tuple that fully encodes the state of the object */
+            py::dict d;
+            d["NUM_THREADS"] = p.NUM_THREADS;
+            return d;
+        },
+        [](py::dict d) { // __setstate__
+            if (d.size() != 1)
+                throw std::runtime_error("Invalid HypothesisEnsembleParameters state!");
+
+            /* Create a new C++ instance */
+            MctsParameters::HypothesisEnsembleParameters p;
+            p.NUM_THREADS = d["NUM_THREADS"].cast<unsigned int>();
             return p;
         }
     ));
@@ -217,9 +397,122 @@ void define_mamcts(py::module m)
       .def(py::init<const MctsParameters&>())
       .def("__repr__", [](const mcts1 &m) {
         return "mamcts.MctsCrossingStateIntUctUct";
+      })
+      .def("profile", &mcts1::profile)
+      .def("tree_statistics", &mcts1::treeStatistics);
+
+    py::enum_<SearchPhase>(m, "SearchPhase")
+      .value("SELECTION", SearchPhase::SELECTION)
+      .value("EXPANSION", SearchPhase::EXPANSION)
+      .value("ROLLOUT", SearchPhase::ROLLOUT)
+      .value("BACKPROPAGATION", SearchPhase::BACKPROPAGATION)
+      .value("HYPOTHESIS_SAMPLING", SearchPhase::HYPOTHESIS_SAMPLING)
+      .export_values();
+
+    py::class_<SearchProfile>(m, "SearchProfile")
+      .def(py::init<>())
+      .def("__repr__", [](const SearchProfile &p) {
+        return "mamcts.SearchProfile";
+      })
+      .def("__str__", &SearchProfile::sprintf)
+      .def_property_readonly_static("enabled", [](py::object) { return SearchProfile::enabled(); })
+      .def("calls", &SearchProfile::get_calls)
+      .def("total_time", &SearchProfile::get_total_time)
+      .def("mean_latency", &SearchProfile::get_mean_latency)
+      .def("latency_histogram", &SearchProfile::get_latency_histogram)
+      .def("merge", &SearchProfile::merge)
+      .def("reset", &SearchProfile::reset)
+      .def("as_dict", [](const SearchProfile &p) {
+        py::dict d;
+        for (unsigned int phase = 0; phase < NUM_SEARCH_PHASES; ++phase) {
+          const auto search_phase = static_cast<SearchPhase>(phase);
+          py::dict phase_dict;
+          phase_dict["calls"] = p.get_calls(search_phase);
+          phase_dict["total_time_ns"] = p.get_total_time(search_phase);
+          phase_dict["latency_histogram"] = p.get_latency_histogram(search_phase);
+          d[py::str(search_phase_name(search_phase))] = phase_dict;
+        }
+        return d;
       });
 
+    py::class_<SearchTracer,
+             std::shared_ptr<SearchTracer>>(m, "SearchTracer")
+      .def(py::init<const std::string&, const unsigned int&, const std::size_t&>(),
+           py::arg("filename"), py::arg("sampling_interval") = 100, py::arg("buffer_capacity") = 1 << 14)
+      .def("__repr__", [](const SearchTracer &t) {
+        return "mamcts.SearchTracer";
+      })
+      .def("flush", &SearchTracer::flush)
+      .def("close", &SearchTracer::close)
+      .def_property_readonly("sampling_interval", &SearchTracer::get_sampling_interval)
+      .def_property_readonly("num_events", &SearchTracer::get_num_events)
+      .def_property_readonly("num_dropped", &SearchTracer::get_num_dropped);
+
+    py::class_<SearchRecorder,
+             std::shared_ptr<SearchRecorder>>(m, "SearchRecorder")
+      .def(py::init<const std::string&>(), py::arg("filename"))
+      .def("__repr__", [](const SearchRecorder &r) {
+        return "mamcts.SearchRecorder";
+      })
+      .def_property_readonly("num_records", &SearchRecorder::get_num_records);
+
+    py::class_<TreeStatistics>(m, "TreeStatistics")
+      .def(py::init<>())
+      .def("__repr__", [](const TreeStatistics &s) {
+        return "mamcts.TreeStatistics";
+      })
+      .def("__str__", &TreeStatistics::sprintf)
+      .def_readonly("num_nodes", &TreeStatistics::num_nodes)
+      .def_readonly("num_leaf_nodes", &TreeStatistics::num_leaf_nodes)
+      .def_readonly("num_interior_nodes", &TreeStatistics::num_interior_nodes)
+      .def_readonly("nodes_per_depth", &TreeStatistics::nodes_per_depth)
+      .def_readonly("node_bytes", &TreeStatistics::node_bytes)
+      .def_readonly("state_bytes", &TreeStatistics::state_bytes)
+      .def_readonly("statistic_bytes", &TreeStatistics::statistic_bytes)
+      .def_readonly("edge_bytes", &TreeStatistics::edge_bytes)
+      .def_property_readonly("max_depth", &TreeStatistics::max_depth)
+      .def_property_readonly("total_bytes", &TreeStatistics::total_bytes)
+      .def("branching_factor", &TreeStatistics::branching_factor);
+
+    py::class_<SharedRootStatistics,
+             std::shared_ptr<SharedRootStatistics>>(m, "SharedRootStatistics")
+      .def(py::init<const std::string&, const unsigned int&, const ActionIdx&>())
+      .def(py::init<const std::string&>())
+      .def("__repr__", [](const SharedRootStatistics &m) {
+        return "mamcts.SharedRootStatistics";
+      })
+      .def("publish", &SharedRootStatistics::publish)
+      .def("is_published", &SharedRootStatistics::is_published)
+      .def("reset", &SharedRootStatistics::reset)
+      .def("wait_for_workers", &SharedRootStatistics::wait_for_workers,
+              py::call_guard<py::gil_scoped_release>())
+      .def_property_readonly("num_published", &SharedRootStatistics::num_published)
+      .def_property_readonly("merged_action_values", &SharedRootStatistics::merged_action_values)
+      .def_property_readonly("merged_action_counts", &SharedRootStatistics::merged_action_counts)
+      .def_property_readonly("merged_num_iterations", &SharedRootStatistics::merged_num_iterations)
+      .def_property_readonly("best_action", &SharedRootStatistics::best_action)
+      .def_property_readonly("num_workers", &SharedRootStatistics::num_workers)
+      .def_property_readonly("num_actions", &SharedRootStatistics::num_actions)
+      .def_property_readonly("name", &SharedRootStatistics::name);
+
     py::class_<HypothesisBeliefTracker> belief_tracker(m, "HypothesisBeliefTracker");
+    belief_tracker
+      .def(py::init<const MctsParameters&>())
+      .def("__repr__", [](const HypothesisBeliefTracker &t) {
+        return "mamcts.HypothesisBeliefTracker";
+      })
+      .def("__str__", &HypothesisBeliefTracker::sprintf)
+      .def("belief_update", [](HypothesisBeliefTracker &t, const CrossingState<int>& state,
+                                const CrossingState<int>& next_state) {
+        t.belief_update(state, next_state);
+      })
+      .def("belief_update", [](HypothesisBeliefTracker &t, const CrossingState<float>& state,
+                                const CrossingState<float>& next_state) {
+        t.belief_update(state, next_state);
+      })
+      .def("sample_current_hypothesis", &HypothesisBeliefTracker::sample_current_hypothesis)
+      .def_property_readonly("beliefs", &HypothesisBeliefTracker::get_beliefs)
+      .def_property_readonly("current_hypothesis", &HypothesisBeliefTracker::get_current_hypothesis);
 
     py::enum_<HypothesisBeliefTracker::PosteriorType>(belief_tracker , "PosteriorType")
       .value("PRODUCT", HypothesisBeliefTracker::PosteriorType::PRODUCT)
@@ -18,14 +18,30 @@ def pu(object):
 def is_equal_mcts_params(mctsp1, mctsp2):
     return mctsp1.DISCOUNT_FACTOR == mctsp2.DISCOUNT_FACTOR and \
         mctsp1.RANDOM_SEED == mctsp2.RANDOM_SEED and \
+        mctsp1.THREAD_IDX == mctsp2.THREAD_IDX and \
         mctsp1.MAX_SEARCH_TIME == mctsp2.MAX_SEARCH_TIME and \
         mctsp1.MAX_NUMBER_OF_ITERATIONS == mctsp2.MAX_NUMBER_OF_ITERATIONS and \
         mctsp1.MAX_SEARCH_DEPTH == mctsp2.MAX_SEARCH_DEPTH and \
         mctsp1.random_heuristic.MAX_SEARCH_TIME == mctsp2.random_heuristic.MAX_SEARCH_TIME and \
         mctsp1.random_heuristic.MAX_NUMBER_OF_ITERATIONS == mctsp2.random_heuristic.MAX_NUMBER_OF_ITERATIONS and \
+        mctsp1.stage_node.PROGRESSIVE_WIDENING == mctsp2.stage_node.PROGRESSIVE_WIDENING and \
+        mctsp1.stage_node.PROGRESSIVE_WIDENING_K == mctsp2.stage_node.PROGRESSIVE_WIDENING_K and \
+        mctsp1.stage_node.PROGRESSIVE_WIDENING_ALPHA == mctsp2.stage_node.PROGRESSIVE_WIDENING_ALPHA and \
+        mctsp1.root_action_selection.SEQUENTIAL_HALVING == mctsp2.root_action_selection.SEQUENTIAL_HALVING and \
+        mctsp1.root_action_selection.NUM_CANDIDATE_ACTIONS == mctsp2.root_action_selection.NUM_CANDIDATE_ACTIONS and \
+        mctsp1.root_action_selection.GUMBEL_SAMPLING == mctsp2.root_action_selection.GUMBEL_SAMPLING and \
+        mctsp1.root_action_selection.GUMBEL_C_VISIT == mctsp2.root_action_selection.GUMBEL_C_VISIT and \
+        mctsp1.root_action_selection.GUMBEL_C_SCALE == mctsp2.root_action_selection.GUMBEL_C_SCALE and \
         mctsp1.uct_statistic.LOWER_BOUND == mctsp2.uct_statistic.LOWER_BOUND and \
         mctsp1.uct_statistic.UPPER_BOUND == mctsp2.uct_statistic.UPPER_BOUND and \
         mctsp1.uct_statistic.EXPLORATION_CONSTANT == mctsp2.uct_statistic.EXPLORATION_CONSTANT and \
+        mctsp1.uct_statistic.PROGRESSIVE_WIDENING == mctsp2.uct_statistic.PROGRESSIVE_WIDENING and \
+        mctsp1.uct_statistic.PRIOR_ORDERED_WIDENING == mctsp2.uct_statistic.PRIOR_ORDERED_WIDENING and \
+        mctsp1.uct_statistic.PROGRESSIVE_WIDENING_K == mctsp2.uct_statistic.PROGRESSIVE_WIDENING_K and \
+        mctsp1.uct_statistic.PROGRESSIVE_WIDENING_ALPHA == mctsp2.uct_statistic.PROGRESSIVE_WIDENING_ALPHA and \
+        mctsp1.rave_statistic.BLEND_SCHEDULE == mctsp2.rave_statistic.BLEND_SCHEDULE and \
+        mctsp1.rave_statistic.EQUIVALENCE_PARAMETER == mctsp2.rave_statistic.EQUIVALENCE_PARAMETER and \
+        mctsp1.rave_statistic.AMAF_BIAS == mctsp2.rave_statistic.AMAF_BIAS and \
         mctsp1.hypothesis_statistic.COST_BASED_ACTION_SELECTION == mctsp2.hypothesis_statistic.COST_BASED_ACTION_SELECTION and \
         mctsp1.hypothesis_statistic.PROGRESSIVE_WIDENING_HYPOTHESIS_BASED == mctsp2.hypothesis_statistic.PROGRESSIVE_WIDENING_HYPOTHESIS_BASED and \
         mctsp1.hypothesis_statistic.LOWER_COST_BOUND == mctsp2.hypothesis_statistic.LOWER_COST_BOUND and \
@@ -33,12 +49,14 @@ def is_equal_mcts_params(mctsp1, mctsp2):
         mctsp1.hypothesis_statistic.PROGRESSIVE_WIDENING_ALPHA == mctsp2.hypothesis_statistic.PROGRESSIVE_WIDENING_ALPHA and \
         mctsp1.hypothesis_statistic.PROGRESSIVE_WIDENING_K == mctsp2.hypothesis_statistic.PROGRESSIVE_WIDENING_K and \
         mctsp1.hypothesis_statistic.EXPLORATION_CONSTANT == mctsp2.hypothesis_statistic.EXPLORATION_CONSTANT and \
+        mctsp1.hypothesis_statistic.ACTION_CANDIDATE_BATCH_SIZE == mctsp2.hypothesis_statistic.ACTION_CANDIDATE_BATCH_SIZE and \
         mctsp1.hypothesis_belief_tracker.RANDOM_SEED_HYPOTHESIS_SAMPLING == \
                  mctsp2.hypothesis_belief_tracker.RANDOM_SEED_HYPOTHESIS_SAMPLING and \
         mctsp1.hypothesis_belief_tracker.HISTORY_LENGTH == mctsp2.hypothesis_belief_tracker.HISTORY_LENGTH and \
         mctsp1.hypothesis_belief_tracker.PROBABILITY_DISCOUNT == mctsp2.hypothesis_belief_tracker.PROBABILITY_DISCOUNT and \
         mctsp1.hypothesis_belief_tracker.POSTERIOR_TYPE == mctsp2.hypothesis_belief_tracker.POSTERIOR_TYPE and \
-        mctsp1.hypothesis_belief_tracker.FIXED_HYPOTHESIS_SET == mctsp2.hypothesis_belief_tracker.FIXED_HYPOTHESIS_SET
+        mctsp1.hypothesis_belief_tracker.FIXED_HYPOTHESIS_SET == mctsp2.hypothesis_belief_tracker.FIXED_HYPOTHESIS_SET and \
+        mctsp1.hypothesis_ensemble.NUM_THREADS == mctsp2.hypothesis_ensemble.NUM_THREADS
 
 def is_equal_crossing_state_params(cp1, cp2):
     return cp1.NUM_OTHER_AGENTS == cp2.NUM_OTHER_AGENTS and \
@@ -51,6 +69,8 @@ def is_equal_crossing_state_params(cp1, cp2):
         cp1.EGO_GOAL_POS == cp2.EGO_GOAL_POS and \
         cp1.CHAIN_LENGTH == cp2.CHAIN_LENGTH   and \
         cp1.NUM_OTHER_ACTIONS ==  cp2.NUM_OTHER_ACTIONS and \
+        cp1.INTERN_OTHER_ACTIONS ==  cp2.INTERN_OTHER_ACTIONS and \
+        cp1.OTHER_ACTIONS_RESOLUTION ==  cp2.OTHER_ACTIONS_RESOLUTION and \
         cp1.REWARD_COLLISION ==  cp2.REWARD_COLLISION and \
         cp1.REWARD_GOAL_REACHED ==  cp2.REWARD_GOAL_REACHED and \
         cp1.REWARD_STEP ==  cp2.REWARD_STEP
@@ -66,14 +86,33 @@ class WrapperTests(unittest.TestCase):
         params_mcts = MctsParameters()
         params_mcts.DISCOUNT_FACTOR = 0.9
         params_mcts.RANDOM_SEED = 1000
+        params_mcts.THREAD_IDX = 2
         params_mcts.MAX_SEARCH_TIME = 1232423
         params_mcts.MAX_NUMBER_OF_ITERATIONS = 2315677
         params_mcts.random_heuristic.MAX_SEARCH_TIME = 10
         params_mcts.random_heuristic.MAX_NUMBER_OF_ITERATIONS = 1000
 
+        params_mcts.stage_node.PROGRESSIVE_WIDENING = True
+        params_mcts.stage_node.PROGRESSIVE_WIDENING_K = 3
+        params_mcts.stage_node.PROGRESSIVE_WIDENING_ALPHA = 0.25
+
+        params_mcts.root_action_selection.SEQUENTIAL_HALVING = True
+        params_mcts.root_action_selection.NUM_CANDIDATE_ACTIONS = 4
+        params_mcts.root_action_selection.GUMBEL_SAMPLING = True
+        params_mcts.root_action_selection.GUMBEL_C_VISIT = 30
+        params_mcts.root_action_selection.GUMBEL_C_SCALE = 0.5
+
         params_mcts.uct_statistic.LOWER_BOUND = -1000
         params_mcts.uct_statistic.UPPER_BOUND = 100
         params_mcts.uct_statistic.EXPLORATION_CONSTANT = 0.7
+        params_mcts.uct_statistic.PROGRESSIVE_WIDENING = True
+        params_mcts.uct_statistic.PRIOR_ORDERED_WIDENING = False
+        params_mcts.uct_statistic.PROGRESSIVE_WIDENING_K = 2
+        params_mcts.uct_statistic.PROGRESSIVE_WIDENING_ALPHA = 0.3
+
+        params_mcts.rave_statistic.BLEND_SCHEDULE = 1
+        params_mcts.rave_statistic.EQUIVALENCE_PARAMETER = 20
+        params_mcts.rave_statistic.AMAF_BIAS = 0.1
 
         params_mcts.hypothesis_statistic.COST_BASED_ACTION_SELECTION = True
         params_mcts.hypothesis_statistic.PROGRESSIVE_WIDENING_HYPOTHESIS_BASED = True
@@ -82,12 +121,15 @@ class WrapperTests(unittest.TestCase):
         params_mcts.hypothesis_statistic.PROGRESSIVE_WIDENING_ALPHA = 0.5
         params_mcts.hypothesis_statistic.PROGRESSIVE_WIDENING_K = 1
         params_mcts.hypothesis_statistic.EXPLORATION_CONSTANT = 0.7
+        params_mcts.hypothesis_statistic.ACTION_CANDIDATE_BATCH_SIZE = 8
 
         params_mcts.hypothesis_belief_tracker.RANDOM_SEED_HYPOTHESIS_SAMPLING = 1000
         params_mcts.hypothesis_belief_tracker.HISTORY_LENGTH = 4
         params_mcts.hypothesis_belief_tracker.PROBABILITY_DISCOUNT = 1.0
         params_mcts.hypothesis_belief_tracker.POSTERIOR_TYPE = HypothesisBeliefTracker.PosteriorType.PRODUCT
         params_mcts.hypothesis_belief_tracker.FIXED_HYPOTHESIS_SET = {1: 5, 10: 4, 3 : 100}
+
+        params_mcts.hypothesis_ensemble.NUM_THREADS = 4
         params_mcts_unpickle = pu(params_mcts)
         self.assertTrue(is_equal_mcts_params(params_mcts, params_mcts_unpickle))
 
@@ -99,5 +141,38 @@ class WrapperTests(unittest.TestCase):
         params_crossing_state_unpickle = pu(params_crossing_state)
         self.assertTrue(is_equal_crossing_state_params(params_crossing_state, params_crossing_state_unpickle))
 
+    def test_shared_memory_search(self):
+        import multiprocessing
+        import os
+        from mamcts import MctsDefaultParameters, SharedRootStatistics, SharedMemorySearchWorkerInt
+        from mamcts import CrossingStateInt, AgentPolicyCrossingStateInt, CrossingStateDefaultParametersInt
+        from mamcts import HypothesisBeliefTracker
+
+        params_crossing_state = CrossingStateDefaultParametersInt()
+        state = CrossingStateInt({}, params_crossing_state)
+        state.add_hypothesis(AgentPolicyCrossingStateInt((4,5), params_crossing_state))
+        state.add_hypothesis(AgentPolicyCrossingStateInt((5,6), params_crossing_state))
+
+        params_mcts = MctsDefaultParameters()
+        params_mcts.MAX_NUMBER_OF_ITERATIONS = 50
+
+        belief_tracker = HypothesisBeliefTracker(params_mcts)
+        belief_tracker.belief_update(state, state)
+        belief_tracker.sample_current_hypothesis()
+
+        name = "/mamcts_wrapper_test_{}".format(os.getpid())
+        coordinator = SharedRootStatistics(name, 2, params_crossing_state.NUM_EGO_ACTIONS)
+        context = multiprocessing.get_context("fork")
+        workers = [context.Process(target=SharedMemorySearchWorkerInt,
+                                   args=(state, belief_tracker, params_mcts, name, idx)) \
+                        for idx in range(0, 2)]
+        for worker in workers:
+            worker.start()
+        for worker in workers:
+            worker.join()
+        self.assertTrue(coordinator.wait_for_workers(1000))
+        self.assertEqual(coordinator.num_published, 2)
+        self.assertGreater(coordinator.merged_action_counts[coordinator.best_action], 0)
+
 if __name__ == '__main__':
     unittest.main()
\ No newline at end of file
@@ -47,7 +47,7 @@ TEST(belief_tracker, simple_tracking_state)
     beliefs = tracker.get_beliefs();
     std::unordered_map<AgentIdx, std::unordered_map<HypothesisId,uint>> counts;
 
-    const uint num_samples = 10000;
+    const uint num_samples = 100000;
     for(uint i = 0; i < num_samples; ++i) {
       const auto& sampled = tracker.sample_current_hypothesis();
       for (auto agent_it : sampled) {
@@ -66,8 +66,9 @@ public:
 
     HypothesisId get_num_hypothesis(const AgentIdx& agent_idx) const {return 2;}
 
-    const std::vector<AgentIdx> get_other_agent_idx() const {
-        return std::vector<AgentIdx>{0, 1};
+    const AgentIdxVector& get_other_agent_idx() const {
+        static const AgentIdxVector other_agent_idx{0, 1};
+        return other_agent_idx;
     }
 
     const AgentIdx get_ego_agent_idx() const {
@@ -174,6 +174,46 @@ TEST(hypothesis_statistic, worst_case_action_selection) {
 
 }
 
+TEST(hypothesis_statistic, action_candidate_batches) {
+  std::unordered_map<AgentIdx, HypothesisId> current_agents_hypothesis = {
+      {1,0}, {2,1}
+  };
+
+  auto mcts_params = mcts_default_parameters();
+  mcts_params.hypothesis_statistic.ACTION_CANDIDATE_BATCH_SIZE = 3;
+  mcts_params.hypothesis_statistic.PROGRESSIVE_WIDENING_K = 100; // widen on every call
+  mcts_params.hypothesis_statistic.PROGRESSIVE_WIDENING_ALPHA = 0.0;
+
+  HypothesisStatisticTestState state(current_agents_hypothesis);
+  HypothesisStatistic stat_parent(5, 1, mcts_params);
+
+  // First expansion draws a whole batch for hypothesis 0
+  auto action_idx = stat_parent.choose_next_action(state);
+  EXPECT_EQ(action_idx, 5);
+  EXPECT_EQ(state.get_num_planned_actions(), 3);
+
+  // Further expansions under hypothesis 0 are served from the batch, even if the policy changed meanwhile
+  state.change_actions();
+  for (unsigned int i = 0; i < 2; ++i) {
+    EXPECT_EQ(stat_parent.choose_next_action(state), 5);
+    EXPECT_EQ(state.get_num_planned_actions(), 3);
+  }
+  EXPECT_EQ(stat_parent.choose_next_action(state), 3);
+  EXPECT_EQ(state.get_num_planned_actions(), 6);
+
+  // Other hypotheses keep their own candidates
+  current_agents_hypothesis[1] = 1;
+  action_idx = stat_parent.choose_next_action(state);
+  EXPECT_EQ(action_idx, 4);
+  EXPECT_EQ(state.get_num_planned_actions(), 9);
+
+  // Copies draw from their own candidates
+  HypothesisStatistic stat_copy(stat_parent);
+  const auto copy_action_idx = stat_copy.choose_next_action(state);
+  EXPECT_EQ(stat_parent.choose_next_action(state), copy_action_idx);
+  EXPECT_EQ(state.get_num_planned_actions(), 9);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
 
@@ -18,10 +18,12 @@ class HypothesisStatisticTestState : public mcts::HypothesisStateInterface<Hypot
 public:
     HypothesisStatisticTestState(const std::unordered_map<AgentIdx, HypothesisId>& current_agents_hypothesis) :
                      HypothesisStateInterface<HypothesisStatisticTestState>(current_agents_hypothesis),
-                     use_first_action_(true) {}
+                     use_first_action_(true),
+                     num_planned_actions_(0) {}
     ~HypothesisStatisticTestState() {};
 
-    ActionIdx plan_action_current_hypothesis(const AgentIdx& agent_idx) const {
+    ActionIdx plan_action_current_hypothesis(const AgentIdx& agent_idx, Philox4x32& random_generator) const {
+        num_planned_actions_++;
         switch(current_agents_hypothesis_.at(agent_idx)) {
             case 0: 
                 if(use_first_action_) {
@@ -43,8 +45,11 @@ public:
 
     void change_actions() {use_first_action_ = !use_first_action_;}
 
-    const std::vector<AgentIdx> get_other_agent_idx() const {
-        return std::vector<AgentIdx>{1};
+    unsigned int get_num_planned_actions() const { return num_planned_actions_; }
+
+    const AgentIdxVector& get_other_agent_idx() const {
+        static const AgentIdxVector other_agent_idx{1};
+        return other_agent_idx;
     }
 
     const AgentIdx get_ego_agent_idx() const {
@@ -55,6 +60,7 @@ public:
 
 private:
     bool use_first_action_;
+    mutable unsigned int num_planned_actions_;
 
 };
 
@@ -0,0 +1,19 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+#ifndef TEST_PERFORMANCE_ALLOCATION_COUNTER_H
+#define TEST_PERFORMANCE_ALLOCATION_COUNTER_H
+
+namespace mcts {
+
+// Heap allocations through operator new of the whole binary so far, counted by the replacement
+// allocation functions in allocation_counter.cc. Kept out of the callers' translation units such that
+// the compiler does not pair the replaced operator new with the std::free in the replaced operator delete.
+unsigned long num_heap_allocations();
+
+} // namespace mcts
+
+#endif // TEST_PERFORMANCE_ALLOCATION_COUNTER_H
@@ -0,0 +1,164 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+// Performance regression gate: fixed seed crossing state searches are compared against
+// search_performance_baseline.txt. Heap allocations per iteration may not rise by more than the
+// tolerance below. Throughput depends on the machine and is only reported, unless the test runs with
+// MCTS_PERFORMANCE_GATE_THROUGHPUT=1 on the machine that recorded the baseline, in which case iterations
+// per second may not drop by more than the tolerance either. The baseline is regenerated by running the
+// test with MCTS_PERFORMANCE_BASELINE_OUT=<absolute path>.
+
+#include "gtest/gtest.h"
+
+#include "mcts/heuristics/random_heuristic.h"
+#include "mcts/statistics/uct_statistic.h"
+#include "mcts/hypothesis/hypothesis_statistic.h"
+#include "mcts/hypothesis/hypothesis_belief_tracker.h"
+#include "environments/crossing_state.h"
+#include "test/performance/allocation_counter.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <sstream>
+
+using namespace mcts;
+
+namespace {
+
+const char* const BASELINE_FILE = "test/performance/search_performance_baseline.txt";
+const double ITERATIONS_PER_SECOND_TOLERANCE = 0.25; // relative drop
+const double ALLOCATIONS_PER_ITERATION_TOLERANCE = 0.05; // relative rise
+const unsigned int NUM_ITERATIONS = 2000;
+const unsigned int NUM_SEARCHES = 10;
+
+struct SearchPerformance {
+  double iterations_per_second;
+  double allocations_per_iteration;
+};
+
+MctsParameters performance_parameters() {
+  auto parameters = mcts_default_parameters();
+  parameters.MAX_NUMBER_OF_ITERATIONS = NUM_ITERATIONS;
+  parameters.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+  parameters.random_heuristic.MAX_SEARCH_TIME = std::numeric_limits<double>::max();
+  parameters.random_heuristic.MAX_NUMBER_OF_ITERATIONS = 20;
+  return parameters;
+}
+
+// Best throughput and allocations of the searches after one warm up search
+template<typename Domain, class SO>
+SearchPerformance measure_crossing_state() {
+  const auto mcts_parameters = performance_parameters();
+  const auto parameters = default_crossing_state_parameters<Domain>();
+  HypothesisBeliefTracker belief_tracker(mcts_parameters);
+  CrossingState<Domain> state(belief_tracker.sample_current_hypothesis(), parameters,
+                  make_hypothesis_set<Domain>({AgentPolicyCrossingState<Domain>({4,5}, parameters),
+                                               AgentPolicyCrossingState<Domain>({5,6}, parameters)}));
+  belief_tracker.belief_update(state, state);
+
+  SearchPerformance performance{0.0, std::numeric_limits<double>::max()};
+  for (unsigned int search = 0; search <= NUM_SEARCHES; ++search) {
+    Mcts<CrossingState<Domain>, UctStatistic, SO, RandomHeuristic> mcts(mcts_parameters);
+    const auto allocations_before = num_heap_allocations();
+    const auto start = std::chrono::steady_clock::now();
+    mcts.search(state, belief_tracker);
+    const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+    const auto allocations = num_heap_allocations() - allocations_before;
+    if(search == 0) {
+      continue;
+    }
+    performance.iterations_per_second = std::max(performance.iterations_per_second,
+                                                  mcts.numIterations() / duration.count());
+    performance.allocations_per_iteration = std::min(performance.allocations_per_iteration,
+                                                     static_cast<double>(allocations) / mcts.numIterations());
+  }
+  return performance;
+}
+
+std::map<std::string, SearchPerformance> read_baseline(const std::string& filename) {
+  std::map<std::string, SearchPerformance> baseline;
+  std::ifstream file(filename);
+  std::string line;
+  while(std::getline(file, line)) {
+    if(line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::stringstream ss(line);
+    std::string name;
+    SearchPerformance performance;
+    if(ss >> name >> performance.iterations_per_second >> performance.allocations_per_iteration) {
+      baseline[name] = performance;
+    }
+  }
+  return baseline;
+}
+
+void write_baseline(const std::string& filename, const std::map<std::string, SearchPerformance>& measured) {
+  std::ofstream file(filename);
+  file << "# Fixed seed crossing state searches of //test/performance:search_performance_test, "
+       << NUM_ITERATIONS << " iterations each" << std::endl;
+  file << "# name iterations_per_second allocations_per_iteration" << std::endl;
+  for (const auto& performance : measured) {
+    file << performance.first << " " << std::fixed << std::setprecision(0) << performance.second.iterations_per_second
+         << " " << std::setprecision(2) << performance.second.allocations_per_iteration << std::endl;
+  }
+}
+
+double relative_change(const double& measured, const double& baseline) {
+  return baseline != 0.0 ? (measured - baseline) / baseline : 0.0;
+}
+
+} // namespace
+
+TEST(search_performance, regression_against_baseline) {
+  std::map<std::string, SearchPerformance> measured;
+  measured["crossing_state_int_uct"] = measure_crossing_state<int, UctStatistic>();
+  measured["crossing_state_int_hypothesis"] = measure_crossing_state<int, HypothesisStatistic>();
+  measured["crossing_state_float_hypothesis"] = measure_crossing_state<float, HypothesisStatistic>();
+
+  if(const char* baseline_out = std::getenv("MCTS_PERFORMANCE_BASELINE_OUT")) {
+    write_baseline(baseline_out, measured);
+  }
+
+  const char* gate_throughput_env = std::getenv("MCTS_PERFORMANCE_GATE_THROUGHPUT");
+  const bool gate_throughput = gate_throughput_env && std::string(gate_throughput_env) == "1";
+
+  const auto baseline = read_baseline(BASELINE_FILE);
+  ASSERT_FALSE(baseline.empty()) << "No baseline in " << BASELINE_FILE;
+
+  std::stringstream diff;
+  diff << std::fixed << std::setprecision(2)
+       << "name: iterations/s baseline -> measured (change), allocations/iteration baseline -> measured (change)" << std::endl;
+  bool regression = false;
+  for (const auto& performance : measured) {
+    const auto baseline_it = baseline.find(performance.first);
+    if(baseline_it == baseline.end()) {
+      ADD_FAILURE() << "No baseline for " << performance.first;
+      continue;
+    }
+    const auto& expected = baseline_it->second;
+    const double iterations_change = relative_change(performance.second.iterations_per_second, expected.iterations_per_second);
+    const double allocations_change = relative_change(performance.second.allocations_per_iteration, expected.allocations_per_iteration);
+    const bool iterations_regressed = gate_throughput && iterations_change < -ITERATIONS_PER_SECOND_TOLERANCE;
+    const bool allocations_regressed = allocations_change > ALLOCATIONS_PER_ITERATION_TOLERANCE;
+    regression |= iterations_regressed || allocations_regressed;
+    diff << performance.first << ": "
+         << expected.iterations_per_second << " -> " << performance.second.iterations_per_second
+         << " (" << 100.0 * iterations_change << "%" << (iterations_regressed ? ", REGRESSION" : "") << "), "
+         << expected.allocations_per_iteration << " -> " << performance.second.allocations_per_iteration
+         << " (" << 100.0 * allocations_change << "%" << (allocations_regressed ? ", REGRESSION" : "") << ")"
+         << std::endl;
+  }
+  if(!gate_throughput) {
+    diff << "iterations/s not gated, set MCTS_PERFORMANCE_GATE_THROUGHPUT=1 to gate them" << std::endl;
+  }
+  std::cout << diff.str();
+  EXPECT_FALSE(regression) << "Search performance regressed against " << BASELINE_FILE << ":" << std::endl << diff.str();
+}
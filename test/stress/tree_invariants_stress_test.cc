@@ -0,0 +1,299 @@
+// Copyright (c) 2019 Julian Bernhard
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+// ========================================================
+
+// Stress harness for the parallel search modes: rounds of searches with randomized environments, parameters,
+// seeds and thread counts, after which every search tree is checked by UctTest::tree_invariant_violations.
+// All budgets are iterations only, a failing round is reproduced from the seed printed with its violations.
+// MCTS_STRESS_ROUNDS and MCTS_STRESS_SEED override the number of rounds and the first seed. Run under
+// ThreadSanitizer with bazel test --config=tsan //test/stress:tree_invariants_stress_test
+
+#include "gtest/gtest.h"
+
+#ifndef UNIT_TESTING
+#define UNIT_TESTING
+#endif
+#include "test/uct/uct_test_class.h"
+#include "mcts/heuristics/random_heuristic.h"
+#include "mcts/statistics/uct_statistic.h"
+#include "mcts/hypothesis/hypothesis_statistic.h"
+#include "mcts/hypothesis/hypothesis_belief_tracker.h"
+#include "mcts/hypothesis/hypothesis_ensemble_search.h"
+#include "mcts/batch_planner.h"
+#include "mcts/random_generator.h"
+#include "environments/crossing_state.h"
+#include "environments/synthetic_state.h"
+
+#include <cstdlib>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace mcts;
+
+namespace {
+
+using SyntheticMcts = Mcts<SyntheticState, UctStatistic, UctStatistic, RandomHeuristic>;
+using CrossingStateMcts = Mcts<CrossingState<int>, UctStatistic, HypothesisStatistic, RandomHeuristic>;
+
+unsigned int environment_or(const char* name, const unsigned int& default_value) {
+  const char* value = std::getenv(name);
+  return value ? static_cast<unsigned int>(std::atoi(value)) : default_value;
+}
+
+const unsigned int NUM_ROUNDS = environment_or("MCTS_STRESS_ROUNDS", 8);
+const unsigned int FIRST_SEED = environment_or("MCTS_STRESS_SEED", 1000);
+
+// Draws the configuration of a round
+class RoundRandom {
+public:
+  explicit RoundRandom(const unsigned int& seed) : random_generator_(seed) {}
+
+  int uniform(const int& min, const int& max) {
+    return std::uniform_int_distribution<int>(min, max)(random_generator_);
+  }
+
+  bool coin() { return uniform(0, 1) == 1; }
+
+private:
+  Philox4x32 random_generator_;
+};
+
+MctsParameters random_mcts_parameters(RoundRandom& random) {
+  auto parameters = mcts_default_parameters();
+  parameters.RANDOM_SEED = random.uniform(0, std::numeric_limits<int>::max());
+  parameters.MAX_NUMBER_OF_ITERATIONS = random.uniform(20, 300);
+  parameters.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+  parameters.MAX_SEARCH_DEPTH = random.uniform(2, 12);
+  parameters.random_heuristic.MAX_SEARCH_TIME = std::numeric_limits<double>::max();
+  parameters.random_heuristic.MAX_NUMBER_OF_ITERATIONS = random.uniform(1, 20);
+  parameters.stage_node.PROGRESSIVE_WIDENING = random.coin();
+  parameters.uct_statistic.PROGRESSIVE_WIDENING = random.coin();
+  parameters.root_action_selection.SEQUENTIAL_HALVING = random.coin();
+  parameters.hypothesis_statistic.PROGRESSIVE_WIDENING_HYPOTHESIS_BASED = random.coin();
+  parameters.hypothesis_statistic.ACTION_CANDIDATE_BATCH_SIZE = random.uniform(0, 3);
+  return parameters;
+}
+
+SyntheticStateParameters random_synthetic_state_parameters(RoundRandom& random) {
+  auto parameters = default_synthetic_state_parameters();
+  parameters.NUM_OTHER_AGENTS = random.uniform(0, 3);
+  parameters.NUM_ACTIONS = random.uniform(1, 5);
+  parameters.BRANCHING = random.uniform(1, 32);
+  parameters.TERMINAL_DEPTH = random.uniform(1, 12);
+  parameters.RANDOM_SEED = random.uniform(0, std::numeric_limits<int>::max());
+  return parameters;
+}
+
+CrossingStateParameters<int> random_crossing_state_parameters(RoundRandom& random) {
+  auto parameters = default_crossing_state_parameters<int>();
+  parameters.NUM_OTHER_AGENTS = random.uniform(1, 3);
+  parameters.OTHER_AGENTS_POLICY_RANDOM_SEED = random.uniform(0, std::numeric_limits<int>::max());
+  parameters.TABULATE_OTHER_AGENTS_POLICY = random.coin();
+  parameters.INTERN_OTHER_ACTIONS = random.coin();
+  return parameters;
+}
+
+HypothesisSetSPtr<int> random_hypothesis_set(RoundRandom& random, const CrossingStateParameters<int>& parameters) {
+  HypothesisSet<int> hypothesis_set;
+  const int num_hypothesis = random.uniform(1, 4);
+  for (int hypothesis = 0; hypothesis < num_hypothesis; ++hypothesis) {
+    const int lower = random.uniform(-2, 5);
+    hypothesis_set.push_back(AgentPolicyCrossingState<int>({lower, lower + random.uniform(0, 2)}, parameters));
+  }
+  return make_hypothesis_set<int>(hypothesis_set);
+}
+
+// Random positions of all agents away from the goal
+std::shared_ptr<CrossingState<int>> random_crossing_state(RoundRandom& random,
+                                                          const std::unordered_map<AgentIdx, HypothesisId>& hypothesis,
+                                                          const CrossingStateParameters<int>& parameters,
+                                                          const HypothesisSetSPtr<int>& hypothesis_set) {
+  std::vector<AgentState<int>> other_agent_states;
+  for (unsigned int agent = 0; agent < parameters.NUM_OTHER_AGENTS; ++agent) {
+    other_agent_states.push_back(AgentState<int>(random.uniform(0, 8),
+                     random.uniform(parameters.MIN_VELOCITY_OTHER, parameters.MAX_VELOCITY_OTHER)));
+  }
+  const AgentState<int> ego_state(random.uniform(0, 8), random.uniform(parameters.MIN_VELOCITY_EGO, parameters.MAX_VELOCITY_EGO));
+  return std::make_shared<CrossingState<int>>(hypothesis, parameters, other_agent_states, ego_state,
+                                              false, false, false, hypothesis_set);
+}
+
+// Collects the violations of trees validated concurrently
+class ViolationCollector {
+public:
+  template<class M>
+  void validate(const M& mcts) {
+    UctTest test;
+    const auto violations = test.tree_invariant_violations(mcts);
+    std::lock_guard<std::mutex> lock(mutex_);
+    num_trees_ += 1;
+    violations_.insert(violations_.end(), violations.begin(), violations.end());
+  }
+
+  unsigned int num_trees() const { return num_trees_; }
+
+  std::string sprintf() const {
+    std::stringstream ss;
+    for (const auto& violation : violations_) {
+      ss << violation << std::endl;
+    }
+    return ss.str();
+  }
+
+  bool empty() const { return violations_.empty(); }
+
+private:
+  std::mutex mutex_;
+  unsigned int num_trees_ = 0;
+  std::vector<std::string> violations_;
+};
+
+std::string round_description(const unsigned int& seed, const unsigned int& num_threads) {
+  std::stringstream ss;
+  ss << "seed " << seed << ", " << num_threads << " threads";
+  return ss.str();
+}
+
+} // namespace
+
+TEST(tree_invariants_stress, concurrent_searches_synthetic_state)
+{
+  // Threads search the same root state object with their own trees and random streams
+  for (unsigned int seed = FIRST_SEED; seed < FIRST_SEED + NUM_ROUNDS; ++seed) {
+    RoundRandom random(seed);
+    const auto state_parameters = random_synthetic_state_parameters(random);
+    const auto mcts_parameters = random_mcts_parameters(random);
+    const unsigned int num_threads = random.uniform(1, 8);
+    SCOPED_TRACE(round_description(seed, num_threads));
+    const SyntheticState state(state_parameters);
+
+    ViolationCollector collector;
+    std::vector<std::thread> threads;
+    for (unsigned int thread_idx = 0; thread_idx < num_threads; ++thread_idx) {
+      threads.emplace_back([&, thread_idx]() {
+        auto parameters = mcts_parameters;
+        parameters.THREAD_IDX = thread_idx;
+        SyntheticMcts mcts(parameters);
+        mcts.search(state);
+        collector.validate(mcts);
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(collector.num_trees(), num_threads);
+    EXPECT_TRUE(collector.empty()) << collector.sprintf();
+  }
+}
+
+TEST(tree_invariants_stress, batch_planner_synthetic_state)
+{
+  // Problems repeat the same state pointer, such that tasks share it
+  for (unsigned int seed = FIRST_SEED; seed < FIRST_SEED + NUM_ROUNDS; ++seed) {
+    RoundRandom random(seed);
+    const auto state_parameters = random_synthetic_state_parameters(random);
+    const auto mcts_parameters = random_mcts_parameters(random);
+    const unsigned int num_threads = random.uniform(1, 8);
+    SCOPED_TRACE(round_description(seed, num_threads));
+    const auto state = std::make_shared<SyntheticState>(state_parameters);
+    const std::vector<std::shared_ptr<SyntheticState>> states(random.uniform(1, 12), state);
+
+    ViolationCollector collector;
+    BatchPlanner<SyntheticState, UctStatistic, UctStatistic, RandomHeuristic> planner(mcts_parameters, num_threads);
+    planner.set_search_observer([&collector](const SyntheticMcts& mcts) { collector.validate(mcts); });
+    const auto best_actions = planner.plan_batch(states);
+    EXPECT_EQ(collector.num_trees(), states.size());
+    // Equal problems with equal parameters plan equally
+    EXPECT_EQ(std::count(best_actions.begin(), best_actions.end(), best_actions.front()), best_actions.size());
+    EXPECT_TRUE(collector.empty()) << collector.sprintf();
+  }
+}
+
+TEST(tree_invariants_stress, concurrent_searches_crossing_state)
+{
+  // Threads search their own state and belief tracker, all sharing one hypothesis set and its policies
+  for (unsigned int seed = FIRST_SEED; seed < FIRST_SEED + NUM_ROUNDS; ++seed) {
+    RoundRandom random(seed);
+    const auto parameters = random_crossing_state_parameters(random);
+    const auto mcts_parameters = random_mcts_parameters(random);
+    const unsigned int num_threads = random.uniform(1, 8);
+    SCOPED_TRACE(round_description(seed, num_threads));
+    HypothesisBeliefTracker belief_tracker(mcts_parameters);
+    const auto state = random_crossing_state(random, belief_tracker.sample_current_hypothesis(), parameters,
+                                             random_hypothesis_set(random, parameters));
+    belief_tracker.belief_update(*state, *state);
+
+    ViolationCollector collector;
+    std::vector<std::thread> threads;
+    for (unsigned int thread_idx = 0; thread_idx < num_threads; ++thread_idx) {
+      threads.emplace_back([&, thread_idx]() {
+        auto parameters = mcts_parameters;
+        parameters.THREAD_IDX = thread_idx;
+        HypothesisBeliefTracker thread_belief_tracker(belief_tracker);
+        thread_belief_tracker.set_random_stream(random_stream(thread_idx, 0));
+        const auto thread_state = state->clone_with_hypothesis(thread_belief_tracker.sample_current_hypothesis());
+        CrossingStateMcts mcts(parameters);
+        mcts.search(*thread_state, thread_belief_tracker);
+        collector.validate(mcts);
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(collector.num_trees(), num_threads);
+    EXPECT_TRUE(collector.empty()) << collector.sprintf();
+  }
+}
+
+TEST(tree_invariants_stress, hypothesis_ensemble_crossing_state)
+{
+  for (unsigned int seed = FIRST_SEED; seed < FIRST_SEED + NUM_ROUNDS; ++seed) {
+    RoundRandom random(seed);
+    const auto parameters = random_crossing_state_parameters(random);
+    auto mcts_parameters = random_mcts_parameters(random);
+    mcts_parameters.hypothesis_ensemble.NUM_THREADS = random.uniform(1, 8);
+    SCOPED_TRACE(round_description(seed, mcts_parameters.hypothesis_ensemble.NUM_THREADS));
+    HypothesisBeliefTracker belief_tracker(mcts_parameters);
+    const auto state = random_crossing_state(random, belief_tracker.sample_current_hypothesis(), parameters,
+                                             random_hypothesis_set(random, parameters));
+    belief_tracker.belief_update(*state, *state);
+
+    ViolationCollector collector;
+    HypothesisEnsembleSearch<CrossingState<int>, UctStatistic, HypothesisStatistic, RandomHeuristic> ensemble(mcts_parameters);
+    ensemble.set_search_observer([&collector](const CrossingStateMcts& mcts) { collector.validate(mcts); });
+    ensemble.search(*state, belief_tracker);
+    EXPECT_EQ(collector.num_trees(), mcts_parameters.hypothesis_ensemble.NUM_THREADS);
+    EXPECT_TRUE(collector.empty()) << collector.sprintf();
+  }
+}
+
+TEST(tree_invariants_stress, batch_planner_crossing_state)
+{
+  // Problems share the hypothesis set and parameters, searches copy the belief trackers
+  for (unsigned int seed = FIRST_SEED; seed < FIRST_SEED + NUM_ROUNDS; ++seed) {
+    RoundRandom random(seed);
+    const auto parameters = random_crossing_state_parameters(random);
+    const auto mcts_parameters = random_mcts_parameters(random);
+    const unsigned int num_threads = random.uniform(1, 8);
+    SCOPED_TRACE(round_description(seed, num_threads));
+    const auto hypothesis_set = random_hypothesis_set(random, parameters);
+    const unsigned int num_problems = random.uniform(1, 8);
+    std::vector<HypothesisBeliefTracker> belief_trackers(num_problems, HypothesisBeliefTracker(mcts_parameters));
+    std::vector<std::shared_ptr<CrossingState<int>>> states;
+    for (auto& belief_tracker : belief_trackers) {
+      states.push_back(random_crossing_state(random, belief_tracker.sample_current_hypothesis(), parameters, hypothesis_set));
+      belief_tracker.belief_update(*states.back(), *states.back());
+    }
+
+    ViolationCollector collector;
+    BatchPlanner<CrossingState<int>, UctStatistic, HypothesisStatistic, RandomHeuristic> planner(mcts_parameters, num_threads);
+    planner.set_search_observer([&collector](const CrossingStateMcts& mcts) { collector.validate(mcts); });
+    planner.plan_batch(states, belief_trackers);
+    EXPECT_EQ(collector.num_trees(), num_problems);
+    EXPECT_TRUE(collector.empty()) << collector.sprintf();
+  }
+}
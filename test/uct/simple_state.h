@@ -61,8 +61,9 @@ public:
         return state_length_ >= winning_state_length_ || state_length_ <= loosing_state_length_;
     }
 
-    const std::vector<AgentIdx> get_other_agent_idx() const {
-        return std::vector<AgentIdx>{5};
+    const AgentIdxVector& get_other_agent_idx() const {
+        static const AgentIdxVector other_agent_idx{5};
+        return other_agent_idx;
     }
 
     const AgentIdx get_ego_agent_idx() const {
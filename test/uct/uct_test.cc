@@ -9,11 +9,20 @@
 #define UNIT_TESTING
 #define DEBUG
 #define PLAN_DEBUG_INFO
+#define MCTS_PROFILING
+#define MCTS_PERF_COUNTERS
 #include "test/uct/uct_test_class.h"
 #include "mcts/heuristics/random_heuristic.h"
 #include "mcts/statistics/uct_statistic.h"
+#include "mcts/statistics/rave_statistic.h"
+#include "mcts/shared_memory_search.h"
+#include "mcts/batch_planner.h"
 #include "test/uct/simple_state.h"
+#include "environments/synthetic_state.h"
 #include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
 
 using namespace std;
 using namespace mcts;
@@ -23,6 +32,7 @@ MctsParameters default_uct_params() {
   MctsParameters parameters;
   parameters.DISCOUNT_FACTOR = 0.9;
   parameters.RANDOM_SEED = 1000;
+  parameters.THREAD_IDX = 0;
   parameters.MAX_NUMBER_OF_ITERATIONS = 10000;
   parameters.MAX_SEARCH_TIME = 1000;
   parameters.MAX_SEARCH_DEPTH = 1000;
@@ -30,13 +40,114 @@ MctsParameters default_uct_params() {
   parameters.random_heuristic.MAX_SEARCH_TIME = 10;
   parameters.random_heuristic.MAX_NUMBER_OF_ITERATIONS = 1000;
 
+  parameters.stage_node.PROGRESSIVE_WIDENING = false;
+  parameters.stage_node.PROGRESSIVE_WIDENING_K = 1;
+  parameters.stage_node.PROGRESSIVE_WIDENING_ALPHA = 0.5;
+
+  parameters.root_action_selection.SEQUENTIAL_HALVING = false;
+  parameters.root_action_selection.NUM_CANDIDATE_ACTIONS = 0;
+  parameters.root_action_selection.GUMBEL_SAMPLING = false;
+  parameters.root_action_selection.GUMBEL_C_VISIT = 50;
+  parameters.root_action_selection.GUMBEL_C_SCALE = 1.0;
+
   parameters.uct_statistic.LOWER_BOUND = -1000;
   parameters.uct_statistic.UPPER_BOUND = 100;
   parameters.uct_statistic.EXPLORATION_CONSTANT = 0.7;
+  parameters.uct_statistic.PROGRESSIVE_WIDENING = false;
+  parameters.uct_statistic.PRIOR_ORDERED_WIDENING = false;
+  parameters.uct_statistic.PROGRESSIVE_WIDENING_K = 1;
+  parameters.uct_statistic.PROGRESSIVE_WIDENING_ALPHA = 0.5;
+
+  parameters.rave_statistic.BLEND_SCHEDULE = RaveStatistic::EQUIVALENCE;
+  parameters.rave_statistic.EQUIVALENCE_PARAMETER = 50;
+  parameters.rave_statistic.AMAF_BIAS = 0.05;
 
   return parameters;
 }
 
+// Two other agents with five actions each, the ego agent is rewarded for matching their action sum
+class WideTestState : public mcts::StateInterface<WideTestState>
+{
+public:
+    WideTestState(int step) : step_(step) {}
+
+    std::shared_ptr<WideTestState> clone() const {
+        return std::make_shared<WideTestState>(*this);
+    }
+
+    std::shared_ptr<WideTestState> execute(const JointAction& joint_action, std::vector<Reward>& rewards, Cost& ego_cost) const {
+        rewards = std::vector<Reward>(3, 0.0);
+        rewards[0] = (joint_action[0] == (joint_action[1] + joint_action[2]) % 2) ? 1.0 : 0.0;
+        ego_cost = 0.0;
+        return std::make_shared<WideTestState>(step_ + 1);
+    }
+
+    ActionIdx get_num_actions(AgentIdx agent_idx) const {
+        return agent_idx == 0 ? 2 : 5;
+    }
+
+    bool is_terminal() const { return step_ >= 10; }
+
+    const AgentIdxVector& get_other_agent_idx() const {
+        static const AgentIdxVector other_agent_idx{1, 2};
+        return other_agent_idx;
+    }
+
+    const AgentIdx get_ego_agent_idx() const { return 0; }
+
+    std::string sprintf() const { return "WideTestState"; }
+
+private:
+    int step_;
+};
+
+// Single decision of the ego agent among ten actions, the reward increases with the action index
+class BanditTestState : public mcts::StateInterface<BanditTestState>
+{
+public:
+    BanditTestState(bool terminal) : terminal_(terminal) {}
+
+    std::shared_ptr<BanditTestState> clone() const {
+        return std::make_shared<BanditTestState>(*this);
+    }
+
+    std::shared_ptr<BanditTestState> execute(const JointAction& joint_action, std::vector<Reward>& rewards, Cost& ego_cost) const {
+        rewards = std::vector<Reward>(2, 0.0);
+        rewards[0] = joint_action[0];
+        ego_cost = 0.0;
+        return std::make_shared<BanditTestState>(true);
+    }
+
+    ActionIdx get_num_actions(AgentIdx agent_idx) const {
+        return agent_idx == 0 ? 10 : 1;
+    }
+
+    bool is_terminal() const { return terminal_; }
+
+    const AgentIdxVector& get_other_agent_idx() const {
+        static const AgentIdxVector other_agent_idx{1};
+        return other_agent_idx;
+    }
+
+    const AgentIdx get_ego_agent_idx() const { return 0; }
+
+    std::string sprintf() const { return "BanditTestState"; }
+
+private:
+    bool terminal_;
+};
+
+// Provides an action prior increasing with the action index
+class PriorTestState : public mcts::StateInterface<PriorTestState>
+{
+public:
+    std::vector<double> get_action_priors(const AgentIdx& agent_idx) const {
+        std::vector<double> priors(20);
+        std::iota(priors.begin(), priors.end(), 1.0);
+        return priors;
+    }
+};
+
 TEST(test_mcts, verify_uct )
 {
     Mcts<SimpleState, UctStatistic, UctStatistic, RandomHeuristic> mcts(default_uct_params());
@@ -49,6 +160,33 @@ TEST(test_mcts, verify_uct )
 
 }
 
+TEST(test_mcts, verify_uct_synthetic_state )
+{
+    auto parameters = default_synthetic_state_parameters();
+    parameters.NUM_OTHER_AGENTS = 2;
+    parameters.NUM_ACTIONS = 3;
+    parameters.TERMINAL_DEPTH = 6;
+    SyntheticState state(parameters);
+
+    // Transitions and rewards are functions of the state and joint action
+    std::vector<Reward> rewards, rewards_repeated;
+    Cost cost, cost_repeated;
+    const auto next_state = state.execute(JointAction{0, 1, 2}, rewards, cost);
+    const auto next_state_repeated = state.execute(JointAction{0, 1, 2}, rewards_repeated, cost_repeated);
+    EXPECT_EQ(next_state->get_id(), next_state_repeated->get_id());
+    EXPECT_EQ(next_state->get_depth(), 1u);
+    EXPECT_EQ(rewards, rewards_repeated);
+
+    auto params = default_uct_params();
+    params.MAX_NUMBER_OF_ITERATIONS = 500;
+    Mcts<SyntheticState, UctStatistic, UctStatistic, RandomHeuristic> mcts(params);
+    mcts.search(state);
+
+    UctTest test;
+    test.verify_uct(mcts, 1000);
+    EXPECT_LE(mcts.treeStatistics().max_depth(), parameters.TERMINAL_DEPTH);
+}
+
 TEST(test_mcts, small_search_depth )
 {
     auto params = default_uct_params();
@@ -61,6 +199,488 @@ TEST(test_mcts, small_search_depth )
     UctTest test;
 }
 
+TEST(test_mcts, verify_uct_progressive_widening )
+{
+    auto params = default_uct_params();
+    params.uct_statistic.PROGRESSIVE_WIDENING = true;
+    Mcts<SimpleState, UctStatistic, UctStatistic, RandomHeuristic> mcts(params);
+    SimpleState state(4);
+
+    mcts.search(state);
+
+    UctTest test;
+    test.verify_uct(mcts, 1000);
+}
+
+TEST(test_mcts, stage_node_progressive_widening )
+{
+    auto params = default_uct_params();
+    params.MAX_NUMBER_OF_ITERATIONS = 500;
+    Mcts<WideTestState, UctStatistic, UctStatistic, RandomHeuristic> mcts(params);
+    WideTestState state(0);
+    mcts.search(state);
+
+    // Constant cap of one child, further passes reach the child with the same ego action
+    params.stage_node.PROGRESSIVE_WIDENING = true;
+    params.stage_node.PROGRESSIVE_WIDENING_K = 1;
+    params.stage_node.PROGRESSIVE_WIDENING_ALPHA = 0.0;
+    Mcts<WideTestState, UctStatistic, UctStatistic, RandomHeuristic> mcts_widening(params);
+    mcts_widening.search(state);
+
+    UctTest test;
+    EXPECT_GT(test.max_children_per_ego_action(mcts), 1);
+    EXPECT_EQ(test.max_children_per_ego_action(mcts_widening), 1);
+    // Other agents are credited with the actions of the reached children only
+    const auto violations = test.tree_invariant_violations(mcts_widening);
+    EXPECT_TRUE(violations.empty()) << (violations.empty() ? std::string() : violations.front());
+}
+
+TEST(test_mcts, root_sequential_halving )
+{
+    auto params = default_uct_params();
+    params.MAX_NUMBER_OF_ITERATIONS = 200;
+    params.root_action_selection.SEQUENTIAL_HALVING = true;
+    BanditTestState state(false);
+
+    Mcts<BanditTestState, UctStatistic, UctStatistic, RandomHeuristic> mcts(params);
+    mcts.search(state);
+    EXPECT_LE(mcts.numIterations(), 200);
+    EXPECT_EQ(mcts.returnBestAction(), 9);
+
+    // Losers of the first round keep their share of 200/(4*10) visits
+    UctTest test;
+    const auto counts = test.root_ego_action_counts(mcts);
+    EXPECT_EQ(counts.at(0), 5);
+    EXPECT_GT(counts.at(9), 5);
+
+    params.root_action_selection.GUMBEL_SAMPLING = true;
+    params.root_action_selection.NUM_CANDIDATE_ACTIONS = 8;
+    Mcts<BanditTestState, UctStatistic, UctStatistic, RandomHeuristic> mcts_gumbel(params);
+    mcts_gumbel.search(state);
+    const auto counts_gumbel = test.root_ego_action_counts(mcts_gumbel);
+    EXPECT_EQ(std::count_if(counts_gumbel.begin(), counts_gumbel.end(),
+                            [](const std::pair<ActionIdx, unsigned>& count) { return count.second > 0; }), 8);
+    EXPECT_GT(counts_gumbel.at(mcts_gumbel.returnBestAction()), 0);
+
+    // A single candidate receives the full budget
+    params.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+    params.root_action_selection.NUM_CANDIDATE_ACTIONS = 1;
+    Mcts<BanditTestState, UctStatistic, UctStatistic, RandomHeuristic> mcts_single(params);
+    mcts_single.search(state);
+    EXPECT_EQ(mcts_single.numIterations(), 200);
+    const auto counts_single = test.root_ego_action_counts(mcts_single);
+    EXPECT_EQ(counts_single.at(mcts_single.returnBestAction()), 200);
+}
+
+TEST(test_mcts, root_sequential_halving_time_bounded )
+{
+    // Bounded by MAX_SEARCH_TIME only, rounds split the time such that the first round does not take it all
+    auto params = default_uct_params();
+    params.MAX_NUMBER_OF_ITERATIONS = std::numeric_limits<unsigned int>::max();
+    params.MAX_SEARCH_TIME = 100;
+    params.root_action_selection.SEQUENTIAL_HALVING = true;
+    BanditTestState state(false);
+
+    Mcts<BanditTestState, UctStatistic, UctStatistic, RandomHeuristic> mcts(params);
+    mcts.search(state);
+    EXPECT_EQ(mcts.returnBestAction(), 9);
+
+    // Losers of the first round stay at a fraction of the visits of the best action
+    UctTest test;
+    const auto counts = test.root_ego_action_counts(mcts);
+    EXPECT_GT(counts.at(9), 0u);
+    EXPECT_LT(counts.at(0), counts.at(9) / 2);
+}
+
+TEST(test_mcts, search_counters )
+{
+    auto params = default_uct_params();
+    params.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+    params.MAX_NUMBER_OF_ITERATIONS = 200;
+    Mcts<SimpleState, UctStatistic, UctStatistic, RandomHeuristic> mcts(params);
+    EXPECT_EQ(mcts.numNodes(), 0u);
+    mcts.search(SimpleState(4));
+
+    UctTest test;
+    EXPECT_EQ(mcts.numNodes(), test.num_nodes(mcts).second);
+    EXPECT_GT(mcts.get_heuristic_function().get_num_rollout_steps(), 0u);
+}
+
+TEST(test_mcts, tree_statistics )
+{
+    auto params = default_uct_params();
+    params.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+    params.MAX_NUMBER_OF_ITERATIONS = 200;
+    Mcts<SimpleState, UctStatistic, UctStatistic, RandomHeuristic> mcts(params);
+    EXPECT_EQ(mcts.treeStatistics().num_nodes, 0u);
+    mcts.search(SimpleState(4));
+
+    const auto statistics = mcts.treeStatistics();
+    EXPECT_EQ(statistics.num_nodes, mcts.numNodes());
+    EXPECT_EQ(statistics.num_leaf_nodes + statistics.num_interior_nodes, statistics.num_nodes);
+    EXPECT_EQ(std::accumulate(statistics.nodes_per_depth.begin(), statistics.nodes_per_depth.end(), 0u),
+              statistics.num_nodes);
+    EXPECT_EQ(statistics.nodes_per_depth[0], 1u);
+    EXPECT_GT(statistics.max_depth(), 0u);
+    // Each child is counted once by its parent
+    EXPECT_EQ(std::accumulate(statistics.children_per_depth.begin(), statistics.children_per_depth.end(), 0u),
+              statistics.num_nodes - 1);
+    EXPECT_EQ(statistics.children_per_depth[statistics.max_depth()], 0u);
+    EXPECT_GT(statistics.branching_factor(0), 0.0);
+    EXPECT_EQ(statistics.branching_factor(statistics.max_depth() + 1), 0.0);
+
+    EXPECT_GT(statistics.node_bytes, 0u);
+    EXPECT_EQ(statistics.state_bytes, statistics.num_nodes * sizeof(SimpleState));
+    EXPECT_GT(statistics.statistic_bytes, 0u);
+    EXPECT_GT(statistics.edge_bytes, 0u);
+    EXPECT_EQ(statistics.total_bytes(), statistics.node_bytes + statistics.state_bytes
+                                          + statistics.statistic_bytes + statistics.edge_bytes);
+    EXPECT_EQ(mcts.nodeInfo(), statistics.sprintf());
+}
+
+TEST(test_mcts, perf_report )
+{
+    auto params = default_uct_params();
+    params.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+    params.MAX_NUMBER_OF_ITERATIONS = 200;
+    Mcts<SimpleState, UctStatistic, UctStatistic, RandomHeuristic> mcts(params);
+    mcts.search(SimpleState(4));
+    mcts.search(SimpleState(4));
+
+    // Only the last search is reported
+    const auto& report = mcts.perf_report();
+    EXPECT_TRUE(PerfReport::enabled());
+    EXPECT_EQ(report.get_calls(PERF_DESCENT), 200u);
+    EXPECT_EQ(report.get_calls(PERF_BACKPROPAGATION), 200u);
+    EXPECT_EQ(report.get_calls(PERF_HYPOTHESIS_SAMPLING), 0u);
+    EXPECT_GE(report.get_calls(PERF_STAGE_NODE_SELECT_OR_EXPAND), report.get_calls(PERF_DESCENT));
+    EXPECT_GE(report.get_calls(PERF_UCT_CHOOSE_NEXT_ACTION), report.get_calls(PERF_STAGE_NODE_SELECT_OR_EXPAND));
+    EXPECT_LE(report.get_calls(PERF_ROLLOUT_LOOP), report.get_calls(PERF_ROLLOUT));
+    EXPECT_GT(report.get_calls(PERF_ROLLOUT_LOOP), 0u);
+
+    // Counters are zero where the system does not provide them
+    const auto& counters = PerfCounterGroup::thread_group();
+    for (unsigned int counter = 0; counter < NUM_PERF_COUNTERS; ++counter) {
+      const auto perf_counter = static_cast<PerfCounter>(counter);
+      if(counters.is_available(perf_counter)) {
+        EXPECT_GE(report.get_count(PERF_DESCENT, perf_counter), report.get_count(PERF_UCT_CHOOSE_NEXT_ACTION, perf_counter));
+      } else {
+        EXPECT_EQ(report.get_count(PERF_DESCENT, perf_counter), 0u);
+      }
+    }
+    if(counters.is_available(CYCLES)) {
+      EXPECT_GT(report.get_count(PERF_DESCENT, CYCLES), 0u);
+    }
+}
+
+TEST(search_tracer, ring_buffer )
+{
+    TraceBuffer buffer(0, 4, std::chrono::steady_clock::now());
+    for (std::int64_t i = 0; i < 10; ++i) {
+        buffer.push(TraceEvent{"event", "test", 0, 0, "i", i});
+    }
+    EXPECT_EQ(buffer.size(), 4u);
+    EXPECT_EQ(buffer.get_num_dropped(), 6u);
+    std::vector<std::int64_t> consumed;
+    buffer.consume([&consumed](const TraceEvent& event) { consumed.push_back(event.arg_value); });
+    EXPECT_EQ(consumed, std::vector<std::int64_t>({6, 7, 8, 9}));
+    EXPECT_EQ(buffer.size(), 0u);
+    EXPECT_EQ(buffer.get_num_dropped(), 0u);
+}
+
+TEST(search_tracer, search_spans )
+{
+    const char* tmp_dir = std::getenv("TEST_TMPDIR");
+    const std::string filename = std::string(tmp_dir ? tmp_dir : "/tmp") + "/search_tracer_test.json";
+    auto params = default_uct_params();
+    params.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+    params.MAX_NUMBER_OF_ITERATIONS = 200;
+    {
+        SearchTracer tracer(filename, 10);
+        Mcts<SimpleState, UctStatistic, UctStatistic, RandomHeuristic> mcts(params);
+        mcts.set_tracer(&tracer);
+        mcts.search(SimpleState(4));
+        mcts.search(SimpleState(4));
+        tracer.close();
+        EXPECT_EQ(tracer.get_num_dropped(), 0u);
+        EXPECT_GT(tracer.get_num_events(), 2u * 20u);
+    }
+
+    std::ifstream file(filename);
+    const std::string trace((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    auto count = [&trace](const std::string& pattern) {
+        unsigned int occurrences = 0;
+        for (auto pos = trace.find(pattern); pos != std::string::npos; pos = trace.find(pattern, pos + 1)) {
+            ++occurrences;
+        }
+        return occurrences;
+    };
+    EXPECT_EQ(trace.front(), '[');
+    EXPECT_EQ(trace[trace.find_last_not_of('\n')], ']');
+    EXPECT_EQ(count("\"name\":\"thread_name\""), 1u);
+    EXPECT_EQ(count("\"name\":\"search\""), 2u);
+    // Every 10th of 200 iterations per search
+    EXPECT_EQ(count("\"name\":\"iteration\""), 2u * 20u);
+    EXPECT_EQ(count("\"name\":\"selection\""), 2u * 20u);
+    EXPECT_EQ(count("\"name\":\"backpropagation\""), 2u * 20u);
+    EXPECT_LE(count("\"name\":\"rollout\""), 2u * 20u);
+    EXPECT_EQ(count("\"iteration\":190}"), 2u);
+    std::remove(filename.c_str());
+}
+
+TEST(test_mcts, search_profile )
+{
+    auto params = default_uct_params();
+    params.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+    params.MAX_NUMBER_OF_ITERATIONS = 200;
+    Mcts<SimpleState, UctStatistic, UctStatistic, RandomHeuristic> mcts(params);
+    mcts.search(SimpleState(4));
+
+    const auto& profile = mcts.profile();
+    EXPECT_TRUE(SearchProfile::enabled());
+    EXPECT_EQ(profile.get_calls(BACKPROPAGATION), 200u);
+    EXPECT_EQ(profile.get_calls(EXPANSION), mcts.numNodes() - 1);
+    EXPECT_EQ(profile.get_calls(ROLLOUT), profile.get_calls(EXPANSION));
+    EXPECT_GE(profile.get_calls(SELECTION), 200u - profile.get_calls(EXPANSION));
+    EXPECT_EQ(profile.get_calls(HYPOTHESIS_SAMPLING), 0u);
+    for (unsigned int phase = 0; phase < NUM_SEARCH_PHASES; ++phase) {
+      const auto& histogram = profile.get_latency_histogram(static_cast<SearchPhase>(phase));
+      EXPECT_EQ(std::accumulate(histogram.begin(), histogram.end(), std::uint64_t(0)),
+                profile.get_calls(static_cast<SearchPhase>(phase)));
+    }
+
+    // The next search starts a new profile
+    mcts.search(SimpleState(4));
+    EXPECT_EQ(mcts.profile().get_calls(BACKPROPAGATION), 200u);
+
+    EXPECT_EQ(SearchProfile::latency_bucket(0), 0u);
+    EXPECT_EQ(SearchProfile::latency_bucket(1), 0u);
+    EXPECT_EQ(SearchProfile::latency_bucket(2), 1u);
+    EXPECT_EQ(SearchProfile::latency_bucket(1023), 9u);
+    EXPECT_EQ(SearchProfile::latency_bucket(1024), 10u);
+    EXPECT_EQ(SearchProfile::latency_bucket(std::numeric_limits<std::uint64_t>::max()), SearchProfile::NUM_LATENCY_BUCKETS - 1);
+}
+
+TEST(test_mcts, concurrent_searches )
+{
+    // Searches in parallel threads keep their own node counters
+    auto params = default_uct_params();
+    params.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+    params.MAX_NUMBER_OF_ITERATIONS = 500;
+    params.random_heuristic.MAX_NUMBER_OF_ITERATIONS = 20;
+    std::vector<std::shared_ptr<Mcts<SimpleState, UctStatistic, UctStatistic, RandomHeuristic>>> searches;
+    std::vector<std::thread> threads;
+    for (int idx = 0; idx < 4; ++idx) {
+      searches.push_back(std::make_shared<Mcts<SimpleState, UctStatistic, UctStatistic, RandomHeuristic>>(params));
+    }
+    for (int idx = 0; idx < 4; ++idx) {
+      threads.emplace_back([&searches, idx]() { searches[idx]->search(SimpleState(idx)); });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    UctTest test;
+    for (const auto& search : searches) {
+      const auto num_nodes = test.num_nodes(*search);
+      EXPECT_EQ(num_nodes.first, num_nodes.second);
+    }
+}
+
+TEST(test_mcts, plan_batch )
+{
+    auto params = default_uct_params();
+    params.MAX_SEARCH_TIME = std::numeric_limits<unsigned int>::max();
+    params.random_heuristic.MAX_SEARCH_TIME = std::numeric_limits<double>::max();
+    params.random_heuristic.MAX_NUMBER_OF_ITERATIONS = 20;
+    params.MAX_NUMBER_OF_ITERATIONS = 200;
+    std::vector<std::shared_ptr<SimpleState>> states;
+    for (int length = 0; length < 8; ++length) {
+      states.push_back(std::make_shared<SimpleState>(length));
+    }
+
+    BatchPlanner<SimpleState, UctStatistic, UctStatistic, RandomHeuristic> planner(params, 3);
+    EXPECT_EQ(planner.num_threads(), 3u);
+    const auto best_actions = planner.plan_batch(states);
+    ASSERT_EQ(best_actions.size(), states.size());
+    for (std::size_t idx = 0; idx < states.size(); ++idx) {
+      Mcts<SimpleState, UctStatistic, UctStatistic, RandomHeuristic> mcts(params);
+      mcts.search(*states[idx]);
+      EXPECT_EQ(best_actions[idx], mcts.returnBestAction());
+    }
+    // The pool is reused
+    EXPECT_EQ(planner.plan_batch(states), best_actions);
+}
+
+TEST(random_generator, philox_known_answers )
+{
+    // Known answer tests of Philox4x32-10 by Salmon et al.
+    std::uint32_t counter[4] = {0, 0, 0, 0};
+    Philox4x32::philox(counter, 0, 0);
+    EXPECT_EQ(std::vector<std::uint32_t>(counter, counter + 4),
+              std::vector<std::uint32_t>({0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+    std::uint32_t counter_ones[4] = {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff};
+    Philox4x32::philox(counter_ones, 0xffffffff, 0xffffffff);
+    EXPECT_EQ(std::vector<std::uint32_t>(counter_ones, counter_ones + 4),
+              std::vector<std::uint32_t>({0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+    std::uint32_t counter_pi[4] = {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344};
+    Philox4x32::philox(counter_pi, 0xa4093822, 0x299f31d0);
+    EXPECT_EQ(std::vector<std::uint32_t>(counter_pi, counter_pi + 4),
+              std::vector<std::uint32_t>({0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}));
+
+    Philox4x32 generator(0, 0);
+    EXPECT_EQ(generator(), 0x6627e8d5u);
+    EXPECT_EQ(generator(), 0xe169c58du);
+}
+
+TEST(random_generator, philox_streams )
+{
+    Philox4x32 generator(1000, random_stream(0, 1));
+    std::vector<std::uint32_t> numbers;
+    for (int idx = 0; idx < 10; ++idx) {
+      numbers.push_back(generator());
+    }
+
+    // Skipping ahead equals generating
+    Philox4x32 skipping(1000, random_stream(0, 1));
+    skipping.discard(7);
+    EXPECT_EQ(skipping(), numbers[7]);
+    skipping.discard(1);
+    EXPECT_EQ(skipping(), numbers[9]);
+
+    // Restarting a stream repeats it, other streams of the same seed differ
+    generator.set_stream(random_stream(0, 1));
+    EXPECT_EQ(generator(), numbers[0]);
+    Philox4x32 other_iteration(1000, random_stream(0, 2));
+    Philox4x32 other_thread(1000, random_stream(1, 1));
+    EXPECT_NE(other_iteration(), numbers[0]);
+    EXPECT_NE(other_thread(), numbers[0]);
+    EXPECT_EQ(random_stream(1, 1), (1ull << 32) + 1);
+}
+
+TEST(shared_root_statistics, publish_and_merge )
+{
+    const std::string name = "/mamcts_test_" + std::to_string(getpid());
+    SharedRootStatistics coordinator(name, 2, 3);
+    EXPECT_THROW(SharedRootStatistics(name, 2, 3), std::runtime_error);
+    {
+      SharedRootStatistics worker(name);
+      EXPECT_EQ(worker.num_workers(), 2u);
+      EXPECT_EQ(worker.num_actions(), 3);
+      worker.publish(0, {1.0, 2.0, 0.0}, {1, 3, 0}, 4);
+      EXPECT_THROW(worker.publish(1, {1.0, 2.0}, {1, 3}, 2), std::invalid_argument);
+    }
+    EXPECT_EQ(coordinator.num_published(), 1u);
+    EXPECT_FALSE(coordinator.wait_for_workers(1));
+
+    SharedRootStatistics(name).publish(1, {4.0, 0.0, 0.0}, {3, 1, 0}, 4);
+    EXPECT_TRUE(coordinator.wait_for_workers(1));
+    const auto values = coordinator.merged_action_values();
+    EXPECT_DOUBLE_EQ(values[0], (1.0*1 + 4.0*3)/4);
+    EXPECT_DOUBLE_EQ(values[1], (2.0*3 + 0.0*1)/4);
+    EXPECT_DOUBLE_EQ(values[2], 0.0);
+    EXPECT_EQ(coordinator.merged_action_counts(), std::vector<unsigned int>({4, 4, 0}));
+    EXPECT_EQ(coordinator.merged_num_iterations(), 8u);
+    EXPECT_EQ(coordinator.best_action(), 0);
+
+    coordinator.reset();
+    EXPECT_EQ(coordinator.num_published(), 0u);
+}
+
+TEST(test_mcts, shared_memory_search )
+{
+    auto params = default_uct_params();
+    params.MAX_NUMBER_OF_ITERATIONS = 100;
+    BanditTestState state(false);
+
+    SharedMemorySearch<BanditTestState, UctStatistic, UctStatistic, RandomHeuristic> search(params, 3,
+                                                    "/mamcts_test_search_" + std::to_string(getpid()));
+    search.search(state);
+    EXPECT_EQ(search.numIterations(), 300u);
+    EXPECT_EQ(search.returnBestAction(), 9);
+    EXPECT_EQ(search.get_ego_action_values().size(), 10u);
+}
+
+TEST(uct_statistic, prior_ordered_widening )
+{
+    auto params = default_uct_params();
+    params.uct_statistic.PROGRESSIVE_WIDENING = true;
+    params.uct_statistic.PRIOR_ORDERED_WIDENING = true;
+    params.uct_statistic.PROGRESSIVE_WIDENING_K = 1;
+    params.uct_statistic.PROGRESSIVE_WIDENING_ALPHA = 0.5;
+    PriorTestState state;
+    UctStatistic stat(20, 0, params);
+
+    std::vector<ActionIdx> introduced_actions;
+    for (unsigned int i = 0; i < 50; ++i) {
+        const ActionIdx action = stat.choose_next_action(state);
+        if (std::find(introduced_actions.begin(), introduced_actions.end(), action) == introduced_actions.end()) {
+            introduced_actions.push_back(action);
+        }
+        UctStatistic heuristic(0, 0, params);
+        heuristic.set_heuristic_estimate(static_cast<Reward>(action), 0.0);
+        UctStatistic child(0, 0, params);
+        child.update_from_heuristic(heuristic);
+        stat.collect(0.0, 0.0, action);
+        stat.update_statistic(child);
+    }
+
+    // After 50 visits actions are introduced up to 1 + K*50^ALPHA, by descending prior
+    EXPECT_EQ(introduced_actions, std::vector<ActionIdx>({19, 18, 17, 16, 15, 14, 13, 12}));
+    EXPECT_EQ(stat.get_best_action(), 19);
+}
+
+TEST(rave_statistic, amaf_update_and_expansion )
+{
+    auto params = default_uct_params();
+    SimpleState state(4);
+    RaveStatistic stat(3, 0, params);
+    const auto backpropagate = [&](const Reward& rollout_return, const std::vector<ActionIdx>& rollout_actions) {
+        RaveStatistic heuristic(0, 0, params);
+        heuristic.set_heuristic_estimate(rollout_return, 0.0);
+        heuristic.set_rollout_actions(rollout_actions);
+        RaveStatistic child(0, 0, params);
+        child.update_from_heuristic(heuristic);
+        stat.collect(0.0, 0.0, 0);
+        stat.update_statistic(child);
+    };
+    backpropagate(-10.0, {1, 1});
+    backpropagate(10.0, {2});
+
+    // Action 0 was taken, actions 1 and 2 only occurred later in one rollout each
+    UctTest test;
+    EXPECT_EQ(test.rave_counts(stat, 0), std::make_pair(2u, 2u));
+    EXPECT_EQ(test.rave_counts(stat, 1), std::make_pair(0u, 1u));
+    EXPECT_EQ(test.rave_counts(stat, 2), std::make_pair(0u, 1u));
+
+    // Unexpanded actions are introduced by descending AMAF value
+    EXPECT_EQ(stat.choose_next_action(state), 2);
+    EXPECT_EQ(stat.choose_next_action(state), 0);
+    EXPECT_EQ(stat.choose_next_action(state), 1);
+    EXPECT_EQ(stat.get_best_action(), 0);
+}
+
+TEST(rave_statistic, blend_schedules )
+{
+    auto params = default_uct_params();
+    RaveStatistic::UcbPair ucb_pair, amaf_pair;
+    ucb_pair.action_count_ = 10;
+    amaf_pair.action_count_ = 40;
+
+    params.rave_statistic.BLEND_SCHEDULE = RaveStatistic::EQUIVALENCE;
+    params.rave_statistic.EQUIVALENCE_PARAMETER = 0;
+    EXPECT_DOUBLE_EQ(RaveStatistic(3, 0, params).calculate_amaf_weight(ucb_pair, amaf_pair), 0.0);
+    params.rave_statistic.EQUIVALENCE_PARAMETER = 50;
+    EXPECT_DOUBLE_EQ(RaveStatistic(3, 0, params).calculate_amaf_weight(ucb_pair, amaf_pair), 1.0);
+
+    params.rave_statistic.BLEND_SCHEDULE = RaveStatistic::MINIMUM_MSE;
+    params.rave_statistic.AMAF_BIAS = 0.0;
+    EXPECT_DOUBLE_EQ(RaveStatistic(3, 0, params).calculate_amaf_weight(ucb_pair, amaf_pair), 0.8);
+
+    // Without AMAF samples only the action value counts
+    amaf_pair.action_count_ = 0;
+    EXPECT_DOUBLE_EQ(RaveStatistic(3, 0, params).calculate_amaf_weight(ucb_pair, amaf_pair), 0.0);
+}
+
 TEST(test_mcts, generate_dot_file )
 {
     Mcts<SimpleState, UctStatistic, UctStatistic, RandomHeuristic> mcts(default_uct_params());
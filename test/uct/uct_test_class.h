@@ -10,6 +10,12 @@
 #include "mcts/mcts.h"
 #include "mcts/heuristics/random_heuristic.h"
 #include "mcts/statistics/uct_statistic.h"
+#include "mcts/statistics/rave_statistic.h"
+#include "mcts/hypothesis/hypothesis_statistic.h"
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
 
 using namespace mcts;
 using namespace std;
@@ -19,6 +25,52 @@ class mcts::UctTest
 {
 
 public:
+    // Action count and AMAF count of an action
+    std::pair<unsigned, unsigned> rave_counts(const RaveStatistic& statistic, const ActionIdx& action) {
+        return std::make_pair(statistic.ucb_statistics_.at(action).action_count_,
+                              statistic.amaf_statistics_.at(action).action_count_);
+    }
+
+    // Visit count of each root ego action
+    template< class S, class SO, class H>
+    std::map<ActionIdx, unsigned> root_ego_action_counts(const Mcts<S, UctStatistic, SO, H>& mcts) {
+        std::map<ActionIdx, unsigned> counts;
+        for(const auto& ucb_pair : mcts.root_->ego_int_node_.ucb_statistics_) {
+            counts[ucb_pair.first] = ucb_pair.second.action_count_;
+        }
+        return counts;
+    }
+
+    // Largest number of children of a stage node in the tree sharing the same ego action
+    template< class S, class SE, class SO, class H>
+    std::size_t max_children_per_ego_action(const StageNodeSPtr<S,SE,SO,H>& node) {
+        std::size_t max_children = 0;
+        std::map<ActionIdx, std::size_t> children_per_ego_action;
+        for(const auto& child : node->children_) {
+            const auto num_children = ++children_per_ego_action[child.first[S::ego_agent_idx]];
+            max_children = std::max(max_children, std::max(num_children, max_children_per_ego_action(child.second)));
+        }
+        return max_children;
+    }
+
+    template< class S, class SE, class SO, class H>
+    std::size_t max_children_per_ego_action(const Mcts<S, SE, SO, H>& mcts) {
+        return max_children_per_ego_action(mcts.root_);
+    }
+
+    // Node counter of the tree and the number of nodes reachable from the root
+    template< class S, class SE, class SO, class H>
+    std::pair<unsigned int, unsigned int> num_nodes(const Mcts<S, SE, SO, H>& mcts) {
+        std::function<unsigned int(const StageNodeSPtr<S,SE,SO,H>&)> count = [&count](const StageNodeSPtr<S,SE,SO,H>& node) {
+            unsigned int num = 1;
+            for(const auto& child : node->children_) {
+                num += count(child.second);
+            }
+            return num;
+        };
+        return std::make_pair(mcts.root_->get_num_nodes(), count(mcts.root_));
+    }
+
     template< class S, class SE, class SO, class H>
     void verify_uct(const Mcts<S, SE, SO, H>& mcts, unsigned int depth) {
         std::unordered_map<AgentIdx, UctStatistic> expected_root_statistics = verify_uct(mcts.root_, depth);
@@ -80,7 +132,8 @@ public:
                     auto action_it = std::find(other_agent_idx.begin(),
                                       other_agent_idx.end(),
                                         child_int_node.get_agent_idx());
-                    auto action_idx = std::distance(other_agent_idx.begin(), action_it);
+                    // Joint actions and rewards hold the ego agent first
+                    auto action_idx = std::distance(other_agent_idx.begin(), action_it) + 1;
                     expected_statistics = expected_total_node_visits(child_int_node, child_int_node.get_agent_idx(), is_first_child_and_not_parent_root, expected_statistics);
                     expected_statistics = expected_action_count(child_int_node, child_int_node.get_agent_idx(), 
                                         joint_action, is_first_child_and_not_parent_root, expected_statistics, action_idx);
@@ -101,7 +154,249 @@ public:
             return expected_statistics;
 
     }
+
+    // Violations of the tree invariants of a finished search, empty if the tree is consistent. Unlike verify_uct
+    // this does not assume a single thread or a particular statistic of the other agents and names each violation:
+    // - node counter equals the reachable nodes, children link back to their parent one level deeper
+    // - joint actions of the children of a node are unique and each child has its rewards and costs
+    // - per agent the action counts of a node sum to its visits and match the visits of the children,
+    //   children ending the descent (terminal or at MAX_SEARCH_DEPTH) keep their single expansion visit
+    // - UctStatistic: Q-values recomputed from the children's rewards and values
+    // - HypothesisStatistic: visit counts per hypothesis sum to the node visits and to the action counts
+    template< class S, class SE, class SO, class H>
+    std::vector<std::string> tree_invariant_violations(const Mcts<S, SE, SO, H>& mcts) {
+        typedef StageNode<S,SE,SO,H> Node;
+        std::vector<std::string> violations;
+        unsigned int num_reachable = 0;
+        std::vector<const Node*> open_nodes{mcts.root_.get()};
+        while(!open_nodes.empty()) {
+            const Node* node = open_nodes.back();
+            open_nodes.pop_back();
+            num_reachable += 1;
+
+            std::set<JointAction> joint_actions;
+            for (const auto& child : node->children_) {
+                const Node* child_node = child.second.get();
+                open_nodes.push_back(child_node);
+                if(!joint_actions.insert(child_node->joint_action_).second) {
+                    violations.push_back(node_description(*node) + ": duplicate child joint action " + to_string(child_node->joint_action_));
+                }
+                if(child_node->joint_action_ != child.first) {
+                    violations.push_back(node_description(*child_node) + ": joint action differs from its key " + to_string(child.first));
+                }
+                if(child_node->parent_.lock().get() != node || child_node->depth_ != node->depth_ + 1) {
+                    violations.push_back(node_description(*child_node) + ": not linked to parent " + node_description(*node));
+                }
+                if(node->joint_rewards_.count(child.first) == 0 || node->ego_costs_.count(child.first) == 0) {
+                    violations.push_back(node_description(*node) + ": no rewards for child " + node_description(*child_node));
+                }
+            }
+
+            verify_agent(*node, S::ego_agent_idx, [](const Node& n) -> const IntermediateNode<S, SE>& { return n.ego_int_node_; }, violations);
+            for (std::size_t other = 0; other < node->other_int_nodes_.size(); ++other) {
+                verify_agent(*node, other + 1, [other](const Node& n) -> const IntermediateNode<S, SO>& {
+                                 return n.other_int_nodes_[other]; },
+                             violations);
+            }
+        }
+        if(mcts.root_->get_num_nodes() != num_reachable) {
+            violations.push_back("Node counter " + std::to_string(mcts.root_->get_num_nodes()) + " differs from " +
+                                 std::to_string(num_reachable) + " reachable nodes");
+        }
+        return violations;
+    }
+
 private:
+    template<class Node>
+    static std::string node_description(const Node& node) {
+        std::stringstream ss;
+        ss << "Node " << node.id_ << " at depth " << node.depth_;
+        return ss.str();
+    }
+
+    static std::string to_string(const JointAction& joint_action) {
+        std::stringstream ss;
+        ss << joint_action;
+        return ss.str();
+    }
+
+    // Descent ends at a child without updating it, the child keeps the visit of its expansion
+    template<class Node>
+    static bool ends_descent(const Node& node) {
+        return node.state_->is_terminal() || node.depth_ == node.mcts_parameters_.MAX_SEARCH_DEPTH;
+    }
+
+    static unsigned int node_visits(const UctStatistic& statistic) { return statistic.total_node_visits_; }
+
+    static unsigned int node_visits(const HypothesisStatistic& statistic) { return statistic.total_node_visits_; }
+
+    static std::map<ActionIdx, unsigned int> action_counts(const UctStatistic& statistic) {
+        std::map<ActionIdx, unsigned int> counts;
+        for (const auto& ucb_pair : statistic.ucb_statistics_) {
+            counts[ucb_pair.first] += ucb_pair.second.action_count_;
+        }
+        return counts;
+    }
+
+    // Summed over the hypotheses
+    static std::map<ActionIdx, unsigned int> action_counts(const HypothesisStatistic& statistic) {
+        std::map<ActionIdx, unsigned int> counts;
+        for (const auto& hypothesis_statistics : statistic.ucb_statistics_) {
+            for (const auto& ucb_pair : hypothesis_statistics.second) {
+                counts[ucb_pair.first] += ucb_pair.second.action_count_;
+            }
+        }
+        return counts;
+    }
+
+    // Visits and action counts of the agent at position agent_pos of the joint actions
+    template<class Node, class GetStatistic>
+    void verify_agent(const Node& node, const AgentIdx& agent_pos, const GetStatistic& get_statistic,
+                      std::vector<std::string>& violations) {
+        const auto& statistic = get_statistic(node);
+        const auto counts = action_counts(statistic);
+        std::stringstream prefix;
+        prefix << node_description(node) << ", agent " << static_cast<int>(statistic.agent_idx_) << ": ";
+
+        unsigned int count_sum = 0;
+        for (const auto& count : counts) {
+            count_sum += count.second;
+        }
+        const unsigned int expansion_visit = node.is_root() ? 0 : 1;
+        if(node_visits(statistic) != count_sum + expansion_visit) {
+            violations.push_back(prefix.str() + std::to_string(node_visits(statistic)) + " visits, action counts sum to " +
+                                 std::to_string(count_sum));
+        }
+
+        // Passes through the children per action, lower bound if a child ends the descent
+        std::map<ActionIdx, unsigned int> child_visits;
+        std::map<ActionIdx, unsigned int> descent_ending_children;
+        unsigned int child_visit_sum = 0;
+        unsigned int descent_ending_sum = 0;
+        for (const auto& child : node.children_) {
+            const auto& child_statistic = get_statistic(*child.second);
+            const ActionIdx action = child.first[agent_pos];
+            if(ends_descent(*child.second)) {
+                descent_ending_children[action] += 1;
+                descent_ending_sum += 1;
+                if(node_visits(child_statistic) != 1) {
+                    violations.push_back(prefix.str() + node_description(*child.second) + " ends the descent but has " +
+                                         std::to_string(node_visits(child_statistic)) + " visits");
+                }
+            } else {
+                child_visits[action] += node_visits(child_statistic);
+                child_visit_sum += node_visits(child_statistic);
+            }
+        }
+        if(descent_ending_sum == 0 ? count_sum != child_visit_sum : count_sum < child_visit_sum + descent_ending_sum) {
+            violations.push_back(prefix.str() + "action counts sum to " + std::to_string(count_sum) + ", children visits to " +
+                                 std::to_string(child_visit_sum) + " with " + std::to_string(descent_ending_sum) +
+                                 " children ending the descent");
+        }
+        for (const auto& count : counts) {
+            const auto expected = child_visits[count.first];
+            const auto num_ending = descent_ending_children[count.first];
+            if(num_ending == 0 ? count.second != expected : count.second < expected + num_ending) {
+                violations.push_back(prefix.str() + "action " + std::to_string(count.first) + " count " +
+                                     std::to_string(count.second) + ", children visits " + std::to_string(expected));
+            }
+        }
+        verify_values(node, agent_pos, statistic, get_statistic, violations, prefix.str());
+        verify_hypotheses(node, statistic, violations, prefix.str());
+    }
+
+    // Q(s,a) * N(s,a) = sum over children of a: N(child) * (reward + discount * V(child)), children ending the
+    // descent contribute their remaining passes with their constant value. Actions with several such children
+    // are skipped since their passes are not known individually.
+    template<class Node, class GetStatistic>
+    void verify_values(const Node& node, const AgentIdx& agent_pos, const UctStatistic& statistic,
+                       const GetStatistic& get_statistic, std::vector<std::string>& violations, const std::string& prefix) {
+        std::map<ActionIdx, double> returns;
+        std::map<ActionIdx, unsigned int> passes;
+        std::map<ActionIdx, std::vector<double>> descent_ending_returns;
+        for (const auto& child : node.children_) {
+            const UctStatistic& child_statistic = get_statistic(*child.second);
+            const ActionIdx action = child.first[agent_pos];
+            const double child_return = node.joint_rewards_.at(child.first)[agent_pos] +
+                                        statistic.k_discount_factor * child_statistic.value_;
+            if(ends_descent(*child.second)) {
+                descent_ending_returns[action].push_back(child_return);
+            } else {
+                returns[action] += child_statistic.total_node_visits_ * child_return;
+                passes[action] += child_statistic.total_node_visits_;
+            }
+        }
+        for (const auto& ucb_pair : statistic.ucb_statistics_) {
+            const ActionIdx action = ucb_pair.first;
+            const auto& count = ucb_pair.second.action_count_;
+            if(count == 0 || descent_ending_returns[action].size() > 1) {
+                continue;
+            }
+            double expected = returns[action];
+            if(descent_ending_returns[action].size() == 1) {
+                expected += (count - passes[action]) * descent_ending_returns[action].front();
+            }
+            expected /= count;
+            if(std::abs(ucb_pair.second.action_value_ - expected) > 1e-6 * std::max(1.0, std::abs(expected))) {
+                std::stringstream ss;
+                ss << prefix << "action " << action << " Q-value " << ucb_pair.second.action_value_
+                   << ", recomputed from children " << expected;
+                violations.push_back(ss.str());
+            }
+        }
+    }
+
+    // Ego cost values of HypothesisStatistic are not recomputable from the children
+    template<class Node, class GetStatistic>
+    void verify_values(const Node& node, const AgentIdx& agent_pos, const HypothesisStatistic& statistic,
+                       const GetStatistic& get_statistic, std::vector<std::string>& violations, const std::string& prefix) {}
+
+    template<class Node>
+    void verify_hypotheses(const Node& node, const UctStatistic& statistic, std::vector<std::string>& violations,
+                           const std::string& prefix) {}
+
+    // The expansion visit is counted before any hypothesis is set, all other visits under their sampled hypothesis
+    template<class Node>
+    void verify_hypotheses(const Node& node, const HypothesisStatistic& statistic, std::vector<std::string>& violations,
+                           const std::string& prefix) {
+        unsigned int visit_sum = 0;
+        for (const auto& hypothesis_visits : statistic.total_node_visits_hypothesis_) {
+            visit_sum += hypothesis_visits.second;
+            const auto& hypothesis_id = hypothesis_visits.first;
+            if(hypothesis_id == HYPOTHESIS_ID_NOT_SET) {
+                if(hypothesis_visits.second != (node.is_root() ? 0u : 1u)) {
+                    violations.push_back(prefix + std::to_string(hypothesis_visits.second) + " visits without hypothesis");
+                }
+                continue;
+            }
+            if(hypothesis_id >= node.state_->get_num_hypothesis(statistic.agent_idx_)) {
+                violations.push_back(prefix + "visits under unknown hypothesis " + std::to_string(hypothesis_id));
+            }
+            unsigned int count_sum = 0;
+            const auto ucb_it = statistic.ucb_statistics_.find(hypothesis_id);
+            if(ucb_it != statistic.ucb_statistics_.end()) {
+                for (const auto& ucb_pair : ucb_it->second) {
+                    count_sum += ucb_pair.second.action_count_;
+                }
+            }
+            if(count_sum != hypothesis_visits.second) {
+                violations.push_back(prefix + "hypothesis " + std::to_string(hypothesis_id) + " has " +
+                                     std::to_string(hypothesis_visits.second) + " visits, action counts sum to " +
+                                     std::to_string(count_sum));
+            }
+        }
+        for (const auto& hypothesis_statistics : statistic.ucb_statistics_) {
+            if(statistic.total_node_visits_hypothesis_.count(hypothesis_statistics.first) == 0) {
+                violations.push_back(prefix + "actions of hypothesis " + std::to_string(hypothesis_statistics.first) +
+                                     " without visit count");
+            }
+        }
+        if(visit_sum != statistic.total_node_visits_) {
+            violations.push_back(prefix + "hypothesis visits sum to " + std::to_string(visit_sum) + ", node visits " +
+                                 std::to_string(statistic.total_node_visits_));
+        }
+    }
+
     template< class S, class H>
     int action_occurence(const StageNodeSPtr<S,UctStatistic,UctStatistic,H>& node, const ActionIdx& action_idx, const AgentIdx & agent_idx) {
         // Counts how an agent selected an action in a state
@@ -45,6 +45,13 @@ cc_library(
 """
     )
 
+    _maybe(
+    http_archive,
+    name = "com_github_google_benchmark",
+    strip_prefix = "benchmark-1.5.0",
+    urls = ["https://github.com/google/benchmark/archive/v1.5.0.zip"],
+    )
+
     _maybe(
       git_repository,
       name = "com_github_gflags_gflags",